@@ -2,8 +2,12 @@
 // Defines the functions used to implement the cache.
 
 #include "cache.h"
+#include "hawkeye.h"
+#include "opt.h"
+#include "zcache.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <cmath>
 #include <numeric>
 
@@ -14,7 +18,7 @@
 /**
  * The current clock cycle number.
  */
-extern uint64_t current_cycle;
+extern thread_local uint64_t current_cycle;
 
 /**
  * For static way partitioning, the quota of ways in each set that can be
@@ -23,7 +27,19 @@ extern uint64_t current_cycle;
  * The remaining number of ways is the quota for core 1.
  */
 extern unsigned int SWP_CORE0_WAYS;
-unsigned int DWP_CORE0_WAYS = 0;
+thread_local unsigned int DWP_CORE0_WAYS = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+//                              GLOBAL VARIABLES                             //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The random number generator of the random replacement policy. Each host
+ * thread has its own, so that memory systems simulated on different threads
+ * do not perturb each other.
+ */
+static thread_local struct random_data rand_data;
+static thread_local char rand_state[128];
 
 ///////////////////////////////////////////////////////////////////////////////
 //                           FUNCTION DEFINITIONS                            //
@@ -47,14 +63,23 @@ Cache *cache_new(uint64_t size, uint64_t associativity, uint64_t line_size,
     c->sets = (size / line_size) / associativity;
     c->policy = replacement_policy;
     c->cacheGrid = (CacheSet*)calloc(c->sets, sizeof(CacheSet));
+    c->lines = (CacheLine*)calloc(c->sets * c->ways, sizeof(CacheLine));
     for (unsigned i = 0; i < c->sets; i++) {
-        c->cacheGrid[i].row = (CacheLine*)calloc(c->ways, sizeof(CacheLine));
+        c->cacheGrid[i].row = c->lines + (uint64_t)i * c->ways;
         c->cacheGrid[i].ways_per_core[0] = 0;
         c->cacheGrid[i].ways_per_core[1] = 0;
-        c->cacheGrid[i].umon.totalHits[MAX_WAYS_PER_CACHE_SET] = {0};
         c->cacheGrid[i].umon.totalMisses = 0;
     }
 
+    c->clock = &current_cycle;
+    c->full_sets = 0;
+    c->zcache_levels = 0;
+    c->opt = NULL;
+    c->pin_max_ways = 0;
+    c->prefetch_stats = false;
+    c->last_hit_prefetched = false;
+    c->hawkeye = (replacement_policy == HAWKEYE) ? hawkeye_new(c) : NULL;
+
     // Access info
     c->index_bits = (unsigned)(std::log2(c->sets));
     c->index_mask = ((1U << c->index_bits) - 1);
@@ -64,6 +89,10 @@ Cache *cache_new(uint64_t size, uint64_t associativity, uint64_t line_size,
     c->stat_write_access = 0;
     c->stat_write_miss = 0;
     c->stat_dirty_evicts = 0;
+    c->stat_relocations = 0;
+    c->stat_pf_fills = 0;
+    c->stat_pf_useful = 0;
+    c->stat_pf_unused = 0;
 
     return c;
 }
@@ -81,9 +110,18 @@ Cache *cache_new(uint64_t size, uint64_t associativity, uint64_t line_size,
 CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
                          unsigned int core_id)
 {
+    if (c->zcache_levels)
+    {
+        return zcache_access(c, line_addr, is_write, core_id);
+    }
+
     // Get the access information
     int set_to_check = (line_addr & c->index_mask);
     unsigned long tag_to_check = line_addr >> c->index_bits;
+
+    // For OPT, find out when this line is used next.
+    uint64_t next_use = c->opt ? opt_observe(c->opt, line_addr) : 0;
+    c->last_hit_prefetched = false;
     
     // Update the appropriate cache statistics
     if(is_write) 
@@ -101,7 +139,22 @@ CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
             {
                 c->cacheGrid[set_to_check].row[i].dirty = true;
             }
-            c->cacheGrid[set_to_check].row[i].lastAccessTime = current_cycle;
+            c->cacheGrid[set_to_check].row[i].lastAccessTime = *c->clock;
+            if (c->opt)
+            {
+                c->opt->line_next_use[(uint64_t)set_to_check * c->ways + i] =
+                    next_use;
+            }
+            if (c->hawkeye)
+            {
+                hawkeye_hit(c->hawkeye, set_to_check, i);
+            }
+            if (c->cacheGrid[set_to_check].row[i].prefetched)
+            {
+                c->cacheGrid[set_to_check].row[i].prefetched = false;
+                c->last_hit_prefetched = true;
+                c->stat_pf_useful++;
+            }
             
             // for DWP
             c->cacheGrid[set_to_check].umon.totalHits[i]++;
@@ -117,6 +170,11 @@ CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
 
     // for DWP
     c->cacheGrid[set_to_check].umon.totalMisses++;
+
+    if (c->opt)
+    {
+        c->opt->pending_next_use = next_use;
+    }
     
     return MISS;
 }
@@ -133,6 +191,12 @@ CacheResult cache_access(Cache *c, uint64_t line_addr, bool is_write,
 void cache_install(Cache *c, uint64_t line_addr, bool is_write,
                    unsigned int core_id)
 {
+    if (c->zcache_levels)
+    {
+        zcache_install(c, line_addr, is_write, core_id);
+        return;
+    }
+
     unsigned set_to_add = (line_addr & c->index_mask) % c->sets;
     unsigned i = cache_find_victim(c, set_to_add, core_id);
     c->lastEvictedLine = c->cacheGrid[set_to_add].row[i];
@@ -143,20 +207,66 @@ void cache_install(Cache *c, uint64_t line_addr, bool is_write,
     }
     if (c->lastEvictedLine.valid == true)
         c->cacheGrid[set_to_add].ways_per_core[c->lastEvictedLine.coreID]--;
+    if (c->lastEvictedLine.valid && c->lastEvictedLine.prefetched)
+        c->stat_pf_unused++;
 
     // Install the line
     c->cacheGrid[set_to_add].row[i].valid = true;
     c->cacheGrid[set_to_add].row[i].dirty = false;
+    c->cacheGrid[set_to_add].row[i].pinned = false;
+    c->cacheGrid[set_to_add].row[i].prefetched = false;
     c->cacheGrid[set_to_add].row[i].tag = line_addr >> c->index_bits;
     c->cacheGrid[set_to_add].row[i].coreID = core_id;
     c->cacheGrid[set_to_add].ways_per_core[core_id]++;
-    c->cacheGrid[set_to_add].row[i].lastAccessTime = current_cycle;
+    c->cacheGrid[set_to_add].row[i].lastAccessTime = *c->clock;
+    if (c->opt)
+    {
+        c->opt->line_next_use[(uint64_t)set_to_add * c->ways + i] =
+            c->opt->pending_next_use;
+    }
+    if (c->hawkeye)
+    {
+        hawkeye_fill(c->hawkeye, c, set_to_add, i);
+    }
     if(is_write)
     {
         c->cacheGrid[set_to_add].row[i].dirty = true;
     }
 }
 
+/**
+ * Count the pinned lines in a set.
+ */
+static unsigned cache_pinned_ways(Cache *c, unsigned int set_index)
+{
+    unsigned pinned = 0;
+    for (unsigned i = 0; c->pin_max_ways && i < c->ways; i++)
+    {
+        pinned += c->cacheGrid[set_index].row[i].pinned;
+    }
+    return pinned;
+}
+
+/**
+ * Find the way of the n-th (from 0) line of a set that is not pinned.
+ */
+static unsigned cache_nth_unpinned(Cache *c, unsigned int set_index,
+                                   unsigned n)
+{
+    if (c->pin_max_ways == 0)
+    {
+        return n;
+    }
+    for (unsigned i = 0; i < c->ways; i++)
+    {
+        if (!c->cacheGrid[set_index].row[i].pinned && n-- == 0)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
 /**
  * Find which way in a given cache set to replace when a new cache line needs
  * to be installed. This should be chosen according to the cache's replacement
@@ -175,7 +285,9 @@ unsigned int cache_find_victim(Cache *c, unsigned int set_index,
     // TODO: In part A, implement the LRU and random replacement policies.
     // TODO: In part E, for extra credit, implement static way partitioning.
     // TODO: In part F, for extra credit, implement dynamic way partitioning.
-    unsigned index = 0;
+
+    // Pinned lines are never evicted; start from the first line that may be.
+    unsigned index = cache_nth_unpinned(c, set_index, 0);
 
     if (c->policy == LRU) 
     {
@@ -189,11 +301,11 @@ unsigned int cache_find_victim(Cache *c, unsigned int set_index,
         }
 
         // If all are valid, then we need to evict a line
-        uint64_t oldestTime = c->cacheGrid[set_index].row[0].lastAccessTime;
+        uint64_t oldestTime = c->cacheGrid[set_index].row[index].lastAccessTime;
 
         for (unsigned i = 0; i < c->ways; i++)
         {
-            if(c->cacheGrid[set_index].row[i].lastAccessTime < oldestTime)
+            if(!c->cacheGrid[set_index].row[i].pinned && c->cacheGrid[set_index].row[i].lastAccessTime < oldestTime)
             {
                 index = i;
                 oldestTime = c->cacheGrid[set_index].row[i].lastAccessTime;
@@ -211,7 +323,10 @@ unsigned int cache_find_victim(Cache *c, unsigned int set_index,
             }
         }
         // If all are valid, then we need to evict a line
-        index = (unsigned) (rand() % c->ways);
+        int32_t r;
+        random_r(&rand_data, &r);
+        index = cache_nth_unpinned(c, set_index,
+                                   (unsigned) (r % (c->ways - cache_pinned_ways(c, set_index))));
     }
     else if (c->policy == SWP) 
     {
@@ -234,7 +349,7 @@ unsigned int cache_find_victim(Cache *c, unsigned int set_index,
         unsigned i = 0;
         for (; i < c->ways; i++)
         {
-            if (c->cacheGrid[set_index].row[i].coreID == core_to_assign)
+            if (c->cacheGrid[set_index].row[i].coreID == core_to_assign && !c->cacheGrid[set_index].row[i].pinned)
             {
                 index = i;
                 oldestTime = c->cacheGrid[set_index].row[i].lastAccessTime;
@@ -244,7 +359,7 @@ unsigned int cache_find_victim(Cache *c, unsigned int set_index,
         // Find the oldest row with the respective core id
         for (; i < c->ways; i++)
         {
-            if (c->cacheGrid[set_index].row[i].coreID == core_to_assign && c->cacheGrid[set_index].row[i].lastAccessTime < oldestTime)
+            if (c->cacheGrid[set_index].row[i].coreID == core_to_assign && !c->cacheGrid[set_index].row[i].pinned && c->cacheGrid[set_index].row[i].lastAccessTime < oldestTime)
             {
                 index = i;
                 oldestTime = c->cacheGrid[set_index].row[i].lastAccessTime;
@@ -293,7 +408,7 @@ unsigned int cache_find_victim(Cache *c, unsigned int set_index,
         // Find the first row with the respective core id
         for (; i < c->ways; i++)
         {
-            if (c->cacheGrid[set_index].row[i].coreID == core_to_assign)
+            if (c->cacheGrid[set_index].row[i].coreID == core_to_assign && !c->cacheGrid[set_index].row[i].pinned)
             {
                 index = i;
                 oldestTime = c->cacheGrid[set_index].row[i].lastAccessTime;
@@ -303,16 +418,480 @@ unsigned int cache_find_victim(Cache *c, unsigned int set_index,
         // Find the oldest row with the respective core id
         for (; i < c->ways; i++)
         {
-            if (c->cacheGrid[set_index].row[i].coreID == core_to_assign && c->cacheGrid[set_index].row[i].lastAccessTime < oldestTime)
+            if (c->cacheGrid[set_index].row[i].coreID == core_to_assign && !c->cacheGrid[set_index].row[i].pinned && c->cacheGrid[set_index].row[i].lastAccessTime < oldestTime)
             {
                 index = i;
                 oldestTime = c->cacheGrid[set_index].row[i].lastAccessTime;
             }
         }
     }
+    else if (c->policy == OPT)
+    {
+        // Check for empty slot
+        for (unsigned i = 0; i < c->ways; i++) 
+        {
+            if (c->cacheGrid[set_index].row[i].valid == false) 
+            {
+                return i;
+            }
+        }
+
+        if (c->opt == NULL || c->opt->recording)
+        {
+            // The future is not known yet while the accesses are recorded, so
+            // fall back to LRU.
+            uint64_t oldestTime = c->cacheGrid[set_index].row[index].lastAccessTime;
+            for (unsigned i = 0; i < c->ways; i++)
+            {
+                if (!c->cacheGrid[set_index].row[i].pinned &&
+                    c->cacheGrid[set_index].row[i].lastAccessTime < oldestTime)
+                {
+                    index = i;
+                    oldestTime = c->cacheGrid[set_index].row[i].lastAccessTime;
+                }
+            }
+        }
+        else
+        {
+            // Evict the line whose next use is furthest away.
+            const uint64_t *next_use = c->opt->line_next_use +
+                                       (uint64_t)set_index * c->ways;
+            for (unsigned i = index + 1; i < c->ways; i++)
+            {
+                if (!c->cacheGrid[set_index].row[i].pinned &&
+                    next_use[i] > next_use[index])
+                {
+                    index = i;
+                }
+            }
+        }
+    }
+    else if (c->policy == HAWKEYE)
+    {
+        // Check for empty slot
+        for (unsigned i = 0; i < c->ways; i++) 
+        {
+            if (c->cacheGrid[set_index].row[i].valid == false) 
+            {
+                return i;
+            }
+        }
+
+        index = hawkeye_victim(c->hawkeye, c, set_index);
+    }
     return index;
 }
 
+/**
+ * Pin the given line, if it is in the cache and its set has fewer than
+ * pin_max_ways pinned lines, so that no replacement policy evicts it.
+ *
+ * @param c The cache holding the line.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ * @return Whether the line is pinned afterwards.
+ */
+bool cache_pin_line(Cache *c, uint64_t line_addr, unsigned int core_id)
+{
+    unsigned set = (line_addr & c->index_mask) % c->sets;
+    unsigned long tag = line_addr >> c->index_bits;
+    for (unsigned i = 0; i < c->ways; i++)
+    {
+        CacheLine *line = &c->cacheGrid[set].row[i];
+        if (line->valid && line->coreID == core_id && line->tag == tag)
+        {
+            if (!line->pinned && cache_pinned_ways(c, set) < c->pin_max_ways)
+            {
+                line->pinned = true;
+            }
+            return line->pinned;
+        }
+    }
+    return false;
+}
+
+/**
+ * Count the pinned lines in the cache.
+ *
+ * @param c The cache.
+ * @return The number of pinned lines.
+ */
+uint64_t cache_pinned_lines(Cache *c)
+{
+    uint64_t pinned = 0;
+    for (uint64_t i = 0; i < (uint64_t)c->sets * c->ways; i++)
+    {
+        pinned += c->lines[i].pinned;
+    }
+    return pinned;
+}
+
+/**
+ * Check whether the given line is in the cache, without counting an access or
+ * updating the replacement state.
+ *
+ * @param c The cache.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ * @return Whether the line is in the cache.
+ */
+bool cache_probe(Cache *c, uint64_t line_addr, unsigned int core_id)
+{
+    unsigned set = (line_addr & c->index_mask) % c->sets;
+    unsigned long tag = line_addr >> c->index_bits;
+    for (unsigned i = 0; i < c->ways; i++)
+    {
+        CacheLine *line = &c->cacheGrid[set].row[i];
+        if (line->valid && line->coreID == core_id && line->tag == tag)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Install a prefetched cache line, clean and marked as not yet used.
+ *
+ * @param c The cache to install the line into.
+ * @param line_addr The address of the cache line to install (in units of the
+ *                  cache line size).
+ * @param core_id The CPU core ID that the line is prefetched for.
+ */
+void cache_install_prefetch(Cache *c, uint64_t line_addr,
+                            unsigned int core_id)
+{
+    cache_install(c, line_addr, false, core_id);
+    c->stat_pf_fills++;
+
+    unsigned set = (line_addr & c->index_mask) % c->sets;
+    unsigned long tag = line_addr >> c->index_bits;
+    for (unsigned i = 0; i < c->ways; i++)
+    {
+        CacheLine *line = &c->cacheGrid[set].row[i];
+        if (line->valid && line->coreID == core_id && line->tag == tag)
+        {
+            line->prefetched = true;
+            return;
+        }
+    }
+}
+
+/**
+ * Mark the given line clean, if it is in the cache and dirty.
+ *
+ * @param c The cache holding the line.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ * @return Whether the line was dirty.
+ */
+bool cache_clean_line(Cache *c, uint64_t line_addr, unsigned int core_id)
+{
+    unsigned set = (line_addr & c->index_mask) % c->sets;
+    unsigned long tag = line_addr >> c->index_bits;
+    for (unsigned i = 0; i < c->ways; i++)
+    {
+        CacheLine *line = &c->cacheGrid[set].row[i];
+        if (line->valid && line->coreID == core_id && line->tag == tag)
+        {
+            bool was_dirty = line->dirty;
+            line->dirty = false;
+            return was_dirty;
+        }
+    }
+    return false;
+}
+
+/**
+ * Find the least recently used dirty line among the given number of least
+ * recently used lines of the set that an address maps to.
+ *
+ * @param c The cache.
+ * @param line_addr The address of any cache line in the set (in units of the
+ *                  cache line size).
+ * @param depth How many of the least recently used lines to consider.
+ * @param dirty_addr Receives the address of the dirty line.
+ * @param core_id Receives the CPU core ID that owns the dirty line.
+ * @return Whether a dirty line was found.
+ */
+bool cache_lru_dirty_line(Cache *c, uint64_t line_addr, unsigned int depth,
+                          uint64_t *dirty_addr, unsigned int *core_id)
+{
+    unsigned set = (line_addr & c->index_mask) % c->sets;
+    CacheLine *row = c->cacheGrid[set].row;
+    unsigned best = c->ways;
+    unsigned best_rank = depth;
+
+    for (unsigned i = 0; i < c->ways; i++)
+    {
+        if (!row[i].valid || !row[i].dirty)
+        {
+            continue;
+        }
+
+        // Rank lines as LRU replacement would, breaking ties by lowest way.
+        unsigned rank = 0;
+        for (unsigned j = 0; j < c->ways; j++)
+        {
+            if (row[j].valid &&
+                (row[j].lastAccessTime < row[i].lastAccessTime ||
+                 (row[j].lastAccessTime == row[i].lastAccessTime && j < i)))
+            {
+                rank++;
+            }
+        }
+        if (rank < best_rank)
+        {
+            best = i;
+            best_rank = rank;
+        }
+    }
+
+    if (best == c->ways)
+    {
+        return false;
+    }
+    *dirty_addr = ((uint64_t)row[best].tag << c->index_bits) |
+                  (line_addr & c->index_mask);
+    *core_id = row[best].coreID;
+    return true;
+}
+
+/**
+ * Compute the address of the line that the last install evicted.
+ *
+ * @param c The cache that installed a line.
+ * @param line_addr The address of the line installed (in units of the cache
+ *                  line size).
+ * @return The address of c->lastEvictedLine (in units of the cache line size).
+ */
+uint64_t cache_evicted_line_addr(Cache *c, uint64_t line_addr)
+{
+    if (c->zcache_levels)
+    {
+        // A zcache keeps the whole line address as the tag.
+        return c->lastEvictedLine.tag;
+    }
+    return ((uint64_t)c->lastEvictedLine.tag << c->index_bits) |
+           (line_addr & c->index_mask);
+}
+
+/**
+ * Ask the host to prefetch the simulated set that the given address maps to,
+ * so that a later access to it does not stall on host memory.
+ *
+ * @param c The cache that will be accessed.
+ * @param line_addr The address of the cache line that will be accessed (in
+ *                  units of the cache line size).
+ */
+void cache_prefetch_set(Cache *c, uint64_t line_addr)
+{
+    unsigned set = (line_addr & c->index_mask) % c->sets;
+    __builtin_prefetch(&c->cacheGrid[set]);
+
+    const char *row = (const char *)(c->lines + (uint64_t)set * c->ways);
+    for (unsigned off = 0; off < c->ways * sizeof(CacheLine); off += 64)
+    {
+        __builtin_prefetch(row + off);
+    }
+}
+
+/**
+ * While warming an empty cache from a trace scanned backwards, place the given
+ * line below the lines already placed in its set, so that the most recently
+ * used line ends up in the highest way. All placed lines get timestamp 0; the
+ * LRU victim search breaks ties by the lowest way, which keeps their order.
+ *
+ * @param c The cache to warm.
+ * @param line_addr The address of the cache line accessed (in units of the
+ *                  cache line size).
+ * @param is_write Whether the access was a write.
+ * @param core_id The CPU core ID that made the access.
+ * @return Whether the line is in the cache afterwards.
+ */
+bool cache_reverse_fill(Cache *c, uint64_t line_addr, bool is_write,
+                        unsigned int core_id)
+{
+    unsigned set_index = (line_addr & c->index_mask) % c->sets;
+    CacheSet *set = &c->cacheGrid[set_index];
+    unsigned long tag = line_addr >> c->index_bits;
+
+    unsigned filled = 0;
+    for (unsigned i = 0; i < c->ways; i++)
+    {
+        CacheLine *line = &set->row[i];
+        if (line->valid == false)
+        {
+            continue;
+        }
+        filled++;
+        if (line->coreID == core_id && line->tag == tag)
+        {
+            // An older access; a store makes the newer copy dirty.
+            line->dirty = line->dirty || is_write;
+            return true;
+        }
+    }
+
+    if (filled == c->ways)
+    {
+        return false;
+    }
+
+    CacheLine *line = &set->row[c->ways - 1 - filled];
+    line->valid = true;
+    line->dirty = is_write;
+    line->tag = tag;
+    line->coreID = core_id;
+    line->lastAccessTime = 0;
+    set->ways_per_core[core_id]++;
+    if (filled + 1 == c->ways)
+    {
+        c->full_sets++;
+    }
+    return true;
+}
+
+/**
+ * Rewrite every set into the layout cache_reverse_fill() produces: the valid
+ * lines in the highest ways, oldest first, all with timestamp 0. Used after
+ * warming the cache with a clock that the detailed simulation will restart.
+ *
+ * @param c The cache to normalise.
+ */
+void cache_normalize_lru(Cache *c)
+{
+    CacheLine sorted[MAX_WAYS_PER_CACHE_SET];
+
+    for (unsigned s = 0; s < c->sets; s++)
+    {
+        CacheLine *row = c->cacheGrid[s].row;
+
+        // Insertion sort by age; equal timestamps keep the lower way older,
+        // as in the LRU victim search.
+        unsigned n = 0;
+        for (unsigned i = 0; i < c->ways; i++)
+        {
+            if (row[i].valid == false)
+            {
+                continue;
+            }
+            unsigned j = n++;
+            for (; j > 0 && sorted[j - 1].lastAccessTime >
+                                row[i].lastAccessTime;
+                 j--)
+            {
+                sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = row[i];
+        }
+
+        unsigned first = c->ways - n;
+        for (unsigned i = 0; i < c->ways; i++)
+        {
+            if (i < first)
+            {
+                row[i].valid = false;
+                row[i].dirty = false;
+            }
+            else
+            {
+                row[i] = sorted[i - first];
+            }
+            row[i].lastAccessTime = 0;
+        }
+    }
+}
+
+/**
+ * Reset the statistics of the given cache.
+ *
+ * @param c The cache to reset the statistics of.
+ */
+void cache_clear_stats(Cache *c)
+{
+    c->stat_read_access = 0;
+    c->stat_read_miss = 0;
+    c->stat_write_access = 0;
+    c->stat_write_miss = 0;
+    c->stat_dirty_evicts = 0;
+    c->stat_relocations = 0;
+    c->stat_pf_fills = 0;
+    c->stat_pf_useful = 0;
+    c->stat_pf_unused = 0;
+    if (c->hawkeye)
+    {
+        hawkeye_clear_stats(c->hawkeye);
+    }
+}
+
+/**
+ * Seed the random number generator of the random replacement policy for the
+ * calling thread. Seeding with the same value as srand() gives the same
+ * sequence as rand().
+ *
+ * @param seed The seed.
+ */
+void cache_seed_random(unsigned int seed)
+{
+    memset(&rand_data, 0, sizeof(rand_data));
+    initstate_r(seed, rand_state, sizeof(rand_state), &rand_data);
+}
+
+/**
+ * Draw a number from the random number generator of the calling thread.
+ *
+ * @return A random number in [0, RAND_MAX].
+ */
+int32_t cache_random()
+{
+    int32_t r;
+    random_r(&rand_data, &r);
+    return r;
+}
+
+/**
+ * Add the statistics of one cache to those of another of the same shape.
+ *
+ * @param dst The cache whose statistics are increased.
+ * @param src The cache whose statistics are added.
+ */
+void cache_add_stats(Cache *dst, const Cache *src)
+{
+    dst->stat_read_access += src->stat_read_access;
+    dst->stat_read_miss += src->stat_read_miss;
+    dst->stat_write_access += src->stat_write_access;
+    dst->stat_write_miss += src->stat_write_miss;
+    dst->stat_dirty_evicts += src->stat_dirty_evicts;
+    dst->stat_relocations += src->stat_relocations;
+    dst->stat_pf_fills += src->stat_pf_fills;
+    dst->stat_pf_useful += src->stat_pf_useful;
+    dst->stat_pf_unused += src->stat_pf_unused;
+    if (dst->hawkeye && src->hawkeye)
+    {
+        hawkeye_add_stats(dst->hawkeye, src->hawkeye);
+    }
+}
+
+/**
+ * Free a cache.
+ *
+ * @param c The cache to free.
+ */
+void cache_free(Cache *c)
+{
+    if (c->hawkeye)
+    {
+        hawkeye_free(c->hawkeye);
+    }
+    free(c->lines);
+    free(c->cacheGrid);
+    free(c);
+}
+
 /**
  * Print the statistics of the given cache.
  * 
@@ -345,4 +924,36 @@ void cache_print_stats(Cache *c, const char *header)
     printf("%s_READ_MISS_PERC  \t\t : %10.3f\n", header, read_miss_percent);
     printf("%s_WRITE_MISS_PERC \t\t : %10.3f\n", header, write_miss_percent);
     printf("%s_DIRTY_EVICTS    \t\t : %10llu\n", header, c->stat_dirty_evicts);
+    if (c->zcache_levels)
+    {
+        printf("%s_RELOCATIONS     \t\t : %10llu\n", header,
+               c->stat_relocations);
+    }
+    if (c->hawkeye)
+    {
+        hawkeye_print_stats(c->hawkeye, header);
+    }
+    if (c->prefetch_stats)
+    {
+        double accuracy = 0.0;
+        double coverage = 0.0;
+        if (c->stat_pf_fills)
+        {
+            accuracy = 100.0 * (double)c->stat_pf_useful /
+                       (double)c->stat_pf_fills;
+        }
+        if (c->stat_pf_useful + c->stat_read_miss)
+        {
+            coverage = 100.0 * (double)c->stat_pf_useful /
+                       (double)(c->stat_pf_useful + c->stat_read_miss);
+        }
+        printf("%s_PF_FILLS        \t\t : %10llu\n", header,
+               c->stat_pf_fills);
+        printf("%s_PF_USEFUL       \t\t : %10llu\n", header,
+               c->stat_pf_useful);
+        printf("%s_PF_UNUSED       \t\t : %10llu\n", header,
+               c->stat_pf_unused);
+        printf("%s_PF_ACCURACY_PERC\t\t : %10.3f\n", header, accuracy);
+        printf("%s_PF_COVERAGE_PERC\t\t : %10.3f\n", header, coverage);
+    }
 }
@@ -37,6 +37,18 @@ typedef enum ReplacementPolicyEnum
      * Evict according to a dynamic way partitioning policy.
      */
     DWP = 3,
+
+    /**
+     * Evict the line reused furthest in the future (Belady's MIN), as found
+     * by a pre-pass over the trace (see opt.h).
+     */
+    OPT = 4,
+
+    /**
+     * Insert and evict lines according to a predictor of which instructions
+     * load cache-friendly lines, trained on sampled sets (see hawkeye.h).
+     */
+    HAWKEYE = 5,
 } ReplacementPolicy;
 
 /** A single Cache line */
@@ -44,6 +56,13 @@ typedef struct CacheLine
 {
     bool valid;
     bool dirty;
+
+    /** Whether the line is locked in the cache and never chosen as victim. */
+    bool pinned;
+
+    /** Whether a prefetch brought the line in and no access has used it. */
+    bool prefetched;
+
     unsigned long tag;
     unsigned coreID;
     uint64_t lastAccessTime;
@@ -66,6 +85,9 @@ typedef struct CacheSet
 } CacheSet;
 
 
+struct OptOracle;
+struct Hawkeye;
+
 /** A single cache module. */
 typedef struct Cache
 {
@@ -74,6 +96,12 @@ typedef struct Cache
      */
     CacheSet* cacheGrid;
 
+    /**
+     * The lines of all sets in one block, so that the lines of a set can be
+     * located without reading its CacheSet first.
+     */
+    CacheLine* lines;
+
     /** 
      * Total ways in the cache 
      */
@@ -94,6 +122,39 @@ typedef struct Cache
      */
     CacheLine lastEvictedLine;
 
+    /**
+     * The clock used to timestamp lines for LRU. Points to current_cycle
+     * unless the cache is driven from its own host thread.
+     */
+    const uint64_t *clock;
+
+    /** The number of sets that reverse warming has filled completely. */
+    unsigned full_sets;
+
+    /**
+     * The number of levels of the replacement walk if the cache is organised
+     * as a zcache (see zcache.h), or 0 for a set-associative cache.
+     */
+    unsigned zcache_levels;
+
+    /** The future accesses of the cache, for the OPT policy. */
+    struct OptOracle *opt;
+
+    /** The predictor and per-line state of the HAWKEYE policy. */
+    struct Hawkeye *hawkeye;
+
+    /**
+     * The largest number of lines in a set that may be pinned, or 0 if lines
+     * are never pinned.
+     */
+    unsigned pin_max_ways;
+
+    /** Whether a prefetcher fills this cache, so its usefulness is printed. */
+    bool prefetch_stats;
+
+    /** Whether the last access hit a prefetched line that was not used yet. */
+    bool last_hit_prefetched;
+
     // Access bits
     unsigned index_mask;
     unsigned index_bits;
@@ -122,6 +183,19 @@ typedef struct Cache
      * The total number of times a dirty line was evicted from this cache.
      */
     unsigned long long stat_dirty_evicts;
+
+    /**
+     * The total number of lines a zcache moved to make room for new lines.
+     */
+    unsigned long long stat_relocations;
+
+    /**
+     * The total number of lines prefetched into this cache, how many of them
+     * an access used, and how many were evicted unused.
+     */
+    unsigned long long stat_pf_fills;
+    unsigned long long stat_pf_useful;
+    unsigned long long stat_pf_unused;
 } Cache;
 
 /** Whether a cache access is a hit or a miss. */
@@ -187,6 +261,158 @@ void cache_install(Cache *c, uint64_t line_addr, bool is_write,
 unsigned int cache_find_victim(Cache *c, unsigned int set_index,
                                unsigned int core_id);
 
+/**
+ * Pin the given line, if it is in the cache and its set has fewer than
+ * pin_max_ways pinned lines, so that no replacement policy evicts it.
+ *
+ * @param c The cache holding the line.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ * @return Whether the line is pinned afterwards.
+ */
+bool cache_pin_line(Cache *c, uint64_t line_addr, unsigned int core_id);
+
+/**
+ * Count the pinned lines in the cache.
+ *
+ * @param c The cache.
+ * @return The number of pinned lines.
+ */
+uint64_t cache_pinned_lines(Cache *c);
+
+/**
+ * Check whether the given line is in the cache, without counting an access or
+ * updating the replacement state.
+ *
+ * @param c The cache.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ * @return Whether the line is in the cache.
+ */
+bool cache_probe(Cache *c, uint64_t line_addr, unsigned int core_id);
+
+/**
+ * Install a prefetched cache line, clean and marked as not yet used.
+ *
+ * @param c The cache to install the line into.
+ * @param line_addr The address of the cache line to install (in units of the
+ *                  cache line size).
+ * @param core_id The CPU core ID that the line is prefetched for.
+ */
+void cache_install_prefetch(Cache *c, uint64_t line_addr,
+                            unsigned int core_id);
+
+/**
+ * Mark the given line clean, if it is in the cache and dirty.
+ *
+ * @param c The cache holding the line.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ * @return Whether the line was dirty.
+ */
+bool cache_clean_line(Cache *c, uint64_t line_addr, unsigned int core_id);
+
+/**
+ * Find the least recently used dirty line among the given number of least
+ * recently used lines of the set that an address maps to.
+ *
+ * @param c The cache.
+ * @param line_addr The address of any cache line in the set (in units of the
+ *                  cache line size).
+ * @param depth How many of the least recently used lines to consider.
+ * @param dirty_addr Receives the address of the dirty line.
+ * @param core_id Receives the CPU core ID that owns the dirty line.
+ * @return Whether a dirty line was found.
+ */
+bool cache_lru_dirty_line(Cache *c, uint64_t line_addr, unsigned int depth,
+                          uint64_t *dirty_addr, unsigned int *core_id);
+
+/**
+ * Compute the address of the line that the last install evicted.
+ *
+ * @param c The cache that installed a line.
+ * @param line_addr The address of the line installed (in units of the cache
+ *                  line size).
+ * @return The address of c->lastEvictedLine (in units of the cache line size).
+ */
+uint64_t cache_evicted_line_addr(Cache *c, uint64_t line_addr);
+
+/**
+ * Ask the host to prefetch the simulated set that the given address maps to,
+ * so that a later access to it does not stall on host memory.
+ *
+ * @param c The cache that will be accessed.
+ * @param line_addr The address of the cache line that will be accessed (in
+ *                  units of the cache line size).
+ */
+void cache_prefetch_set(Cache *c, uint64_t line_addr);
+
+/**
+ * While warming an empty cache from a trace scanned backwards, place the given
+ * line below the lines already placed in its set, so that the most recently
+ * used line ends up in the highest way. All placed lines get timestamp 0; the
+ * LRU victim search breaks ties by the lowest way, which keeps their order.
+ *
+ * @param c The cache to warm.
+ * @param line_addr The address of the cache line accessed (in units of the
+ *                  cache line size).
+ * @param is_write Whether the access was a write.
+ * @param core_id The CPU core ID that made the access.
+ * @return Whether the line is in the cache afterwards.
+ */
+bool cache_reverse_fill(Cache *c, uint64_t line_addr, bool is_write,
+                        unsigned int core_id);
+
+/**
+ * Rewrite every set into the layout cache_reverse_fill() produces: the valid
+ * lines in the highest ways, oldest first, all with timestamp 0. Used after
+ * warming the cache with a clock that the detailed simulation will restart.
+ *
+ * @param c The cache to normalise.
+ */
+void cache_normalize_lru(Cache *c);
+
+/**
+ * Reset the statistics of the given cache.
+ *
+ * @param c The cache to reset the statistics of.
+ */
+void cache_clear_stats(Cache *c);
+
+/**
+ * Seed the random number generator of the random replacement policy for the
+ * calling thread. Seeding with the same value as srand() gives the same
+ * sequence as rand().
+ *
+ * @param seed The seed.
+ */
+void cache_seed_random(unsigned int seed);
+
+/**
+ * Draw a number from the random number generator of the calling thread.
+ *
+ * @return A random number in [0, RAND_MAX].
+ */
+int32_t cache_random();
+
+/**
+ * Add the statistics of one cache to those of another of the same shape.
+ *
+ * @param dst The cache whose statistics are increased.
+ * @param src The cache whose statistics are added.
+ */
+void cache_add_stats(Cache *dst, const Cache *src);
+
+/**
+ * Free a cache.
+ *
+ * @param c The cache to free.
+ */
+void cache_free(Cache *c);
+
 /**
  * Print the statistics of the given cache.
  * 
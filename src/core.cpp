@@ -8,28 +8,90 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
-extern uint64_t current_cycle;
+extern thread_local uint64_t current_cycle;
+extern unsigned int TRACE_LOOKAHEAD;
+extern bool TRACE_SHM;
+extern bool TRACE_INDEX;
+extern unsigned int FFWD_WINDOW;
+extern CoreModel CORE_MODEL;
+extern unsigned int DISPATCH_WIDTH;
+extern unsigned int ROB_SIZE;
+extern IcachePrefetcherType ICACHE_PREFETCHER;
+extern unsigned int ICACHE_PF_DEPTH;
 
-int open_gunzip_pipe(const char *filename, int *fd, pid_t *pid);
 ssize_t trace_read(Core *core, void *buf, size_t size);
+bool trace_decode(Core *core, TraceRecord *rec);
+void core_cycle_interval(Core *core);
+static void core_drain_rob(Core *core, uint64_t stall_cycles);
 
 Core *core_new(MemorySystem *memsys, const char *trace_filename,
                unsigned int core_id)
 {
-    int trace_fd;
-    pid_t pid;
-    if (open_gunzip_pipe(trace_filename, &trace_fd, &pid) != 0)
+    int trace_fd = -1;
+    pid_t pid = 0;
+    TraceCache *trace_cache = NULL;
+    GzIndex *trace_index = NULL;
+    GzReader *trace_gz = NULL;
+    if (TRACE_SHM)
+    {
+        trace_cache = tracecache_open(trace_filename);
+        if (trace_cache == NULL)
+        {
+            return NULL;
+        }
+    }
+    else if (TRACE_INDEX)
+    {
+        trace_index = gzindex_open(trace_filename);
+        if (trace_index == NULL)
+        {
+            return NULL;
+        }
+        trace_gz = gzindex_reader_new(trace_index, trace_filename, 0);
+        if (trace_gz == NULL)
+        {
+            gzindex_free(trace_index);
+            return NULL;
+        }
+    }
+    else if (open_gunzip_pipe(trace_filename, &trace_fd, &pid) != 0)
     {
         return NULL;
     }
 
     Core *core = (Core *)calloc(1, sizeof(Core));
+    core->trace_cache = trace_cache;
+    core->trace_end = trace_cache ? trace_cache->num_records : 0;
+    core->trace_filename = trace_filename;
+    core->trace_index = trace_index;
+    core->trace_gz = trace_gz;
     core->core_id = core_id;
     core->memsys = memsys;
     core->trace_fd = trace_fd;
     core->pid = pid;
     core->read_buf_offset = 0;
     core->read_buf_left = 0;
+    if (FFWD_WINDOW)
+    {
+        core->ffwd = ffwd_new();
+    }
+
+    core_read_trace(core);
+    return core;
+}
+
+// Creates a core that executes records [begin, end) of a shared decoded trace.
+// The trace stays owned by the caller.
+Core *core_new_at(MemorySystem *memsys, TraceCache *trace_cache,
+                  uint64_t begin, uint64_t end, unsigned int core_id)
+{
+    Core *core = (Core *)calloc(1, sizeof(Core));
+    core->trace_cache = trace_cache;
+    core->trace_pos = begin;
+    core->trace_end = end;
+    core->core_id = core_id;
+    core->memsys = memsys;
+    core->trace_fd = -1;
 
     core_read_trace(core);
     return core;
@@ -48,6 +110,18 @@ void core_cycle(Core *core)
         return;
     }
 
+    // Skip ahead instead if the core is in a steady-state loop.
+    if (core->ffwd && ffwd_step(core))
+    {
+        return;
+    }
+
+    if (CORE_MODEL == CORE_MODEL_INTERVAL)
+    {
+        core_cycle_interval(core);
+        return;
+    }
+
     core->inst_count++;
 
     uint64_t ifetch_delay = 0;
@@ -55,7 +129,8 @@ void core_cycle(Core *core)
     uint64_t bubble_cycles = 0;
 
     ifetch_delay = memsys_access(core->memsys, core->trace_inst_addr,
-                                 ACCESS_TYPE_IFETCH, core->core_id);
+                                 ACCESS_TYPE_IFETCH, core->core_id,
+                                 core->trace_inst_addr);
     if (ifetch_delay > 1)
     {
         bubble_cycles += (ifetch_delay - 1);
@@ -64,7 +139,8 @@ void core_cycle(Core *core)
     if (core->trace_inst_type == INST_TYPE_LOAD)
     {
         ld_delay = memsys_access(core->memsys, core->trace_ldst_addr,
-                                 ACCESS_TYPE_LOAD, core->core_id);
+                                 ACCESS_TYPE_LOAD, core->core_id,
+                                 core->trace_inst_addr);
     }
     if (ld_delay > 1)
     {
@@ -74,7 +150,7 @@ void core_cycle(Core *core)
     if (core->trace_inst_type == INST_TYPE_STORE)
     {
         memsys_access(core->memsys, core->trace_ldst_addr, ACCESS_TYPE_STORE,
-                      core->core_id);
+                      core->core_id, core->trace_inst_addr);
     }
     // We don't incur bubbles for store misses.
 
@@ -86,27 +162,240 @@ void core_cycle(Core *core)
     core_read_trace(core);
 }
 
-void core_read_trace(Core *core)
+// Dispatches up to DISPATCH_WIDTH instructions this cycle, then stalls for
+// the penalties of the miss events among them.
+//
+// An instruction fetch miss drains the front end, so it ends the group and
+// costs its full latency. A load miss only stalls dispatch once the reorder
+// buffer has filled behind it, which takes its free entries / DISPATCH_WIDTH
+// cycles; load misses within the next ROB_SIZE instructions are issued while
+// it is outstanding, so their latency is hidden behind it. A load miss that
+// returns before the buffer fills still holds up retirement, so the entries
+// dispatched meanwhile stay occupied until a stall lets the buffer drain.
+void core_cycle_interval(Core *core)
 {
-    uint32_t inst_addr;
-    uint8_t inst_type;
-    uint32_t ldst_addr;
+    uint64_t penalty = 0;
+
+    for (unsigned int n = 0; n < DISPATCH_WIDTH && !core->done; n++)
+    {
+        if (n > 0 && core->ffwd && ffwd_step(core))
+        {
+            core->snooze_end_cycle += penalty;
+            return;
+        }
 
-    if (trace_read(core, &inst_addr, sizeof(inst_addr)) !=
-            sizeof(inst_addr) ||
-        trace_read(core, &inst_type, sizeof(inst_type)) !=
-            sizeof(inst_type) ||
-        trace_read(core, &ldst_addr, sizeof(ldst_addr)) !=
-            sizeof(ldst_addr))
+        core->inst_count++;
+        bool end_group = false;
+
+        uint64_t ifetch_delay = memsys_access(core->memsys,
+                                              core->trace_inst_addr,
+                                              ACCESS_TYPE_IFETCH,
+                                              core->core_id,
+                                              core->trace_inst_addr);
+        if (ifetch_delay > 1)
+        {
+            penalty += ifetch_delay - 1;
+            end_group = true;
+            core_drain_rob(core, ifetch_delay - 1);
+        }
+
+        if (core->trace_inst_type == INST_TYPE_LOAD)
+        {
+            uint64_t ld_delay = memsys_access(core->memsys,
+                                              core->trace_ldst_addr,
+                                              ACCESS_TYPE_LOAD, core->core_id,
+                                              core->trace_inst_addr);
+            uint64_t rob_fill_cycles = (ROB_SIZE - core->rob_backlog) /
+                                       DISPATCH_WIDTH;
+            if (ld_delay <= 1)
+            {
+                // L1 hits never stall.
+            }
+            else if (core->inst_count < core->mlp_shadow_end)
+            {
+                core->stat_overlapped_misses++;
+            }
+            else if (ld_delay > rob_fill_cycles)
+            {
+                core->stat_long_misses++;
+                penalty += ld_delay - rob_fill_cycles;
+                core->mlp_shadow_end = core->inst_count + ROB_SIZE;
+                core_drain_rob(core, ld_delay - rob_fill_cycles);
+            }
+            else
+            {
+                core->stat_short_misses++;
+                core->rob_backlog += ld_delay * DISPATCH_WIDTH;
+                if (core->rob_backlog > ROB_SIZE)
+                {
+                    core->rob_backlog = ROB_SIZE;
+                }
+            }
+        }
+
+        if (core->trace_inst_type == INST_TYPE_STORE)
+        {
+            memsys_access(core->memsys, core->trace_ldst_addr,
+                          ACCESS_TYPE_STORE, core->core_id,
+                          core->trace_inst_addr);
+        }
+
+        core_read_trace(core);
+        if (end_group)
+        {
+            break;
+        }
+    }
+
+    if (penalty)
+    {
+        core->snooze_end_cycle = current_cycle + penalty;
+    }
+}
+
+// Retires the reorder buffer backlog for the given number of cycles in
+// which dispatch is stalled.
+static void core_drain_rob(Core *core, uint64_t stall_cycles)
+{
+    if (core->rob_backlog > stall_cycles * DISPATCH_WIDTH)
+    {
+        core->rob_backlog -= stall_cycles * DISPATCH_WIDTH;
+    }
+    else
+    {
+        core->rob_backlog = 0;
+    }
+}
+
+void core_read_trace(Core *core)
+{
+    TraceRecord rec = {0, 0, 0};
+    if (!core_next_record(core, &rec))
     {
         core->done = true;
         core->done_inst_count = core->inst_count;
         core->done_cycle_count = current_cycle;
     }
 
-    core->trace_inst_addr = inst_addr;
-    core->trace_inst_type = inst_type;
-    core->trace_ldst_addr = ldst_addr;
+    core->trace_inst_addr = rec.inst_addr;
+    core->trace_inst_type = rec.inst_type;
+    core->trace_ldst_addr = rec.ldst_addr;
+}
+
+// Advances the trace by n instructions, as n calls to core_read_trace()
+// would, and returns how many were skipped. Through a trace index, decoding
+// restarts at the access point before the new instruction when that is past
+// the records decoded so far.
+uint64_t core_skip_trace(Core *core, uint64_t n)
+{
+    if (core->trace_gz && !core->ffwd && !core->done)
+    {
+        // The record decoded next, and the one the core holds.
+        uint64_t next = (core->trace_gz->pos - core->read_buf_left) /
+                        TRACE_RECORD_BYTES;
+        uint64_t current = next - core->lookahead_count - 1;
+        uint64_t total = core->trace_index->total_out / TRACE_RECORD_BYTES;
+        uint64_t target = (n < total - current) ? current + n : total;
+        uint64_t offset = target * TRACE_RECORD_BYTES;
+        if (gzindex_point_at(core->trace_index, offset) >
+            core->trace_gz->pos)
+        {
+            GzReader *r = gzindex_reader_new(core->trace_index,
+                                             core->trace_filename, offset);
+            if (r)
+            {
+                gzindex_reader_free(core->trace_gz);
+                core->trace_gz = r;
+                core->read_buf_offset = 0;
+                core->read_buf_left = 0;
+                core->lookahead_count = 0;
+                core->lookahead_eof = false;
+                core_read_trace(core);
+                return target - current;
+            }
+        }
+    }
+
+    uint64_t skipped = 0;
+    for (; skipped < n && !core->done; skipped++)
+    {
+        core_read_trace(core);
+    }
+    return skipped;
+}
+
+bool core_next_record(Core *core, TraceRecord *rec)
+{
+    bool valid;
+
+    if (core->ffwd && ffwd_replay_pop(core->ffwd, rec))
+    {
+        return true;
+    }
+
+    // The fetch-directed instruction prefetcher runs ICACHE_PF_DEPTH
+    // instructions ahead, over the decoded instructions.
+    bool fdp = (ICACHE_PREFETCHER == IPF_FDP);
+    unsigned int depth = TRACE_LOOKAHEAD;
+    if (fdp && depth < ICACHE_PF_DEPTH)
+    {
+        depth = ICACHE_PF_DEPTH;
+    }
+
+    if (depth == 0)
+    {
+        valid = trace_decode(core, rec);
+    }
+    else
+    {
+        // Keep the next depth instructions decoded, and have the host
+        // prefetch the simulated state each one will touch as soon as it is
+        // decoded.
+        while (!core->lookahead_eof && core->lookahead_count <= depth)
+        {
+            unsigned int tail = (core->lookahead_head + core->lookahead_count) %
+                                (MAX_LOOKAHEAD + 1);
+            TraceRecord *next = &core->lookahead[tail];
+            if (!trace_decode(core, next))
+            {
+                core->lookahead_eof = true;
+                break;
+            }
+            core->lookahead_count++;
+
+            memsys_host_prefetch(core->memsys, next->inst_addr,
+                                 ACCESS_TYPE_IFETCH, core->core_id);
+            if (next->inst_type == INST_TYPE_LOAD ||
+                next->inst_type == INST_TYPE_STORE)
+            {
+                memsys_host_prefetch(core->memsys, next->ldst_addr,
+                                     (next->inst_type == INST_TYPE_LOAD)
+                                         ? ACCESS_TYPE_LOAD
+                                         : ACCESS_TYPE_STORE,
+                                     core->core_id);
+            }
+        }
+
+        valid = core->lookahead_count > 0;
+        if (valid)
+        {
+            *rec = core->lookahead[core->lookahead_head];
+            core->lookahead_head = (core->lookahead_head + 1) %
+                                   (MAX_LOOKAHEAD + 1);
+            core->lookahead_count--;
+        }
+
+        if (fdp && core->lookahead_count >= ICACHE_PF_DEPTH)
+        {
+            TraceRecord *ahead = &core->lookahead[(core->lookahead_head +
+                                                   ICACHE_PF_DEPTH - 1) %
+                                                  (MAX_LOOKAHEAD + 1)];
+            memsys_fetch_directed(core->memsys, ahead->inst_addr,
+                                  core->core_id);
+        }
+    }
+
+    return valid;
 }
 
 void core_print_stats(Core *core)
@@ -125,6 +414,34 @@ void core_print_stats(Core *core)
            core->done_cycle_count);
     printf("CORE_%01d_IPC          \t\t : %10.3f\n", core->core_id, ipc);
 
+    if (CORE_MODEL == CORE_MODEL_INTERVAL)
+    {
+        printf("CORE_%01d_LONG_MISSES  \t\t : %10llu\n", core->core_id,
+               core->stat_long_misses);
+        printf("CORE_%01d_OVERLAP_MISS \t\t : %10llu\n", core->core_id,
+               core->stat_overlapped_misses);
+        printf("CORE_%01d_SHORT_MISSES \t\t : %10llu\n", core->core_id,
+               core->stat_short_misses);
+    }
+
+    if (core->ffwd)
+    {
+        ffwd_print_stats(core->ffwd, core->core_id);
+    }
+
+    if (core->trace_cache)
+    {
+        tracecache_close(core->trace_cache);
+        return;
+    }
+
+    if (core->trace_gz)
+    {
+        gzindex_reader_free(core->trace_gz);
+        gzindex_free(core->trace_index);
+        return;
+    }
+
     close(core->trace_fd);
     waitpid(core->pid, NULL, 0);
 }
@@ -168,6 +485,26 @@ int open_gunzip_pipe(const char *filename, int *fd, pid_t *pid)
     return 0;
 }
 
+bool trace_decode(Core *core, TraceRecord *rec)
+{
+    if (core->trace_cache)
+    {
+        if (core->trace_pos >= core->trace_end)
+        {
+            return false;
+        }
+        *rec = core->trace_cache->records[core->trace_pos++];
+        return true;
+    }
+
+    return trace_read(core, &rec->inst_addr, sizeof(rec->inst_addr)) ==
+               sizeof(rec->inst_addr) &&
+           trace_read(core, &rec->inst_type, sizeof(rec->inst_type)) ==
+               sizeof(rec->inst_type) &&
+           trace_read(core, &rec->ldst_addr, sizeof(rec->ldst_addr)) ==
+               sizeof(rec->ldst_addr);
+}
+
 ssize_t trace_read(Core *core, void *buf, size_t size)
 {
     uint8_t *bytes = (uint8_t *)buf;
@@ -186,11 +523,23 @@ ssize_t trace_read(Core *core, void *buf, size_t size)
         if (core->read_buf_left == 0)
         {
             // Refill the read buffer.
-            core->read_buf_left = read(core->trace_fd, core->read_buf,
-                                       sizeof(core->read_buf));
+            if (core->trace_gz)
+            {
+                core->read_buf_left = gzindex_read(core->trace_gz,
+                                                   core->read_buf,
+                                                   sizeof(core->read_buf));
+            }
+            else
+            {
+                core->read_buf_left = read(core->trace_fd, core->read_buf,
+                                           sizeof(core->read_buf));
+                if (core->read_buf_left < 0)
+                {
+                    perror("Couldn't read from trace file");
+                }
+            }
             if (core->read_buf_left < 0)
             {
-                perror("Couldn't read from trace file");
                 return -1;
             }
             if (core->read_buf_left == 0)
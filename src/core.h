@@ -6,8 +6,26 @@
 
 #include "types.h"
 #include "memsys.h"
+#include "tracecache.h"
+#include "gzindex.h"
+#include "ffwd.h"
 #include <sys/types.h>
 
+/** The maximum number of instructions decoded ahead of execution. */
+#define MAX_LOOKAHEAD 64
+
+/** Possible models of the CPU core. */
+typedef enum CoreModelEnum
+{
+    // Executes one instruction at a time, blocking on fetch and load misses.
+    CORE_MODEL_INORDER = 0,
+
+    // Dispatches several instructions per cycle and charges each interval
+    // between miss events with the penalty of the event, hiding misses that
+    // overlap in the reorder buffer.
+    CORE_MODEL_INTERVAL = 1,
+} CoreModel;
+
 typedef struct Core
 {
     unsigned int core_id;
@@ -20,15 +38,45 @@ typedef struct Core
     size_t read_buf_offset;
     ssize_t read_buf_left;
 
+    // The index of the trace and the decoder reading through it, when
+    // reading through one instead of the pipe.
+    const char *trace_filename;
+    GzIndex *trace_index;
+    GzReader *trace_gz;
+
+    // The shared decoded trace, when reading from one instead of the pipe.
+    TraceCache *trace_cache;
+    uint64_t trace_pos;
+    uint64_t trace_end;
+
     bool done;
 
     uint64_t trace_inst_addr;
     uint64_t trace_inst_type;
     uint64_t trace_ldst_addr;
 
+    // Instructions decoded ahead of the current one, oldest first.
+    TraceRecord lookahead[MAX_LOOKAHEAD + 1];
+    unsigned int lookahead_head;
+    unsigned int lookahead_count;
+    bool lookahead_eof;
+
+    // Detects steady-state loops to fast-forward, when enabled.
+    LoopDetector *ffwd;
+
     // Used to stall when waiting for data to return from memory.
     uint64_t snooze_end_cycle;
 
+    // For the interval model, the instruction count up to which a load miss
+    // overlaps the outstanding long-latency miss.
+    unsigned long long mlp_shadow_end;
+    // Reorder buffer entries held behind load misses that returned before
+    // it filled, which leave that much less room for the next miss.
+    unsigned long long rob_backlog;
+    unsigned long long stat_long_misses;
+    unsigned long long stat_short_misses;
+    unsigned long long stat_overlapped_misses;
+
     unsigned long long inst_count;
     unsigned long long done_inst_count;
     unsigned long long done_cycle_count;
@@ -36,8 +84,13 @@ typedef struct Core
 
 Core *core_new(MemorySystem *memsys, const char *trace_filename,
                unsigned int core_id);
+Core *core_new_at(MemorySystem *memsys, TraceCache *trace_cache,
+                  uint64_t begin, uint64_t end, unsigned int core_id);
 void core_cycle(Core *core);
 void core_print_stats(Core *core);
 void core_read_trace(Core *core);
+uint64_t core_skip_trace(Core *core, uint64_t n);
+bool core_next_record(Core *core, TraceRecord *rec);
+int open_gunzip_pipe(const char *filename, int *fd, pid_t *pid);
 
 #endif // __CORE_H__
@@ -0,0 +1,138 @@
+// dbi.cpp
+// Defines the dirty-block index of the L2 cache, which finds the dirty lines
+// in a DRAM row.
+
+#include "dbi.h"
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+static uint64_t dbi_hash(uint64_t row, unsigned int core_id)
+{
+    return (row ^ ((uint64_t)core_id << 40)) * 0x9e3779b97f4a7c15ULL;
+}
+
+/**
+ * Find the slot holding the entry of the given row and core, or the free
+ * slot where it would go.
+ */
+static uint64_t dbi_slot(Dbi *dbi, uint64_t row, unsigned int core_id)
+{
+    uint64_t slot = (dbi_hash(row, core_id) >> 20) & dbi->mask;
+    while (dbi->entries[slot].dirty &&
+           (dbi->entries[slot].row != row ||
+            dbi->entries[slot].core_id != core_id))
+    {
+        slot = (slot + 1) & dbi->mask;
+    }
+    return slot;
+}
+
+/**
+ * Allocate and initialize a dirty-block index.
+ *
+ * @param max_lines The largest number of dirty lines to track.
+ * @param row_bits The number of low line address bits that select a line in
+ *                 a DRAM row, at most 6.
+ * @return A pointer to the index.
+ */
+Dbi *dbi_new(uint64_t max_lines, unsigned int row_bits)
+{
+    // Keep the table at most half full.
+    uint64_t capacity = 1;
+    while (capacity < 2 * max_lines)
+    {
+        capacity <<= 1;
+    }
+
+    Dbi *dbi = (Dbi *)malloc(sizeof(Dbi));
+    dbi->entries = (DbiEntry *)calloc(capacity, sizeof(DbiEntry));
+    dbi->mask = capacity - 1;
+    dbi->row_bits = row_bits;
+    return dbi;
+}
+
+/**
+ * Record that a line is dirty.
+ *
+ * @param dbi The index.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ */
+void dbi_mark(Dbi *dbi, uint64_t line_addr, unsigned int core_id)
+{
+    uint64_t row = line_addr >> dbi->row_bits;
+    DbiEntry *e = &dbi->entries[dbi_slot(dbi, row, core_id)];
+    e->row = row;
+    e->core_id = core_id;
+    e->dirty |= 1ULL << (line_addr & ((1ULL << dbi->row_bits) - 1));
+}
+
+/**
+ * Record that a line is clean or no longer cached.
+ *
+ * @param dbi The index.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ */
+void dbi_clear(Dbi *dbi, uint64_t line_addr, unsigned int core_id)
+{
+    uint64_t row = line_addr >> dbi->row_bits;
+    uint64_t slot = dbi_slot(dbi, row, core_id);
+    DbiEntry *e = &dbi->entries[slot];
+    if (e->dirty == 0)
+    {
+        return;
+    }
+    e->dirty &= ~(1ULL << (line_addr & ((1ULL << dbi->row_bits) - 1)));
+    if (e->dirty)
+    {
+        return;
+    }
+
+    // The slot is free now. Move back any later entry of the same probe run
+    // that could not reach its home slot past it.
+    uint64_t hole = slot;
+    for (uint64_t next = (slot + 1) & dbi->mask; dbi->entries[next].dirty;
+         next = (next + 1) & dbi->mask)
+    {
+        DbiEntry *n = &dbi->entries[next];
+        uint64_t home = (dbi_hash(n->row, n->core_id) >> 20) & dbi->mask;
+        if (((next - home) & dbi->mask) >= ((next - hole) & dbi->mask))
+        {
+            dbi->entries[hole] = *n;
+            n->dirty = 0;
+            hole = next;
+        }
+    }
+}
+
+/**
+ * Find the dirty lines of a core in the DRAM row of the given line.
+ *
+ * @param dbi The index.
+ * @param line_addr The address of any cache line in the row (in units of the
+ *                  cache line size).
+ * @param core_id The CPU core ID that owns the lines.
+ * @return A mask with bit i set if the line at offset i of the row is dirty.
+ */
+uint64_t dbi_row_dirty(Dbi *dbi, uint64_t line_addr, unsigned int core_id)
+{
+    uint64_t row = line_addr >> dbi->row_bits;
+    return dbi->entries[dbi_slot(dbi, row, core_id)].dirty;
+}
+
+/**
+ * Free a dirty-block index.
+ *
+ * @param dbi The index to free.
+ */
+void dbi_free(Dbi *dbi)
+{
+    free(dbi->entries);
+    free(dbi);
+}
@@ -0,0 +1,100 @@
+// dbi.h
+// Declares the dirty-block index of the L2 cache, which finds the dirty lines
+// in a DRAM row.
+
+#ifndef __DBI_H__
+#define __DBI_H__
+
+#include "types.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Possible policies for writing dirty L2 lines back to DRAM. */
+typedef enum L2WritebackPolicyEnum
+{
+    L2_WB_EVICT = 0,     // Write a dirty line back when it is evicted.
+    L2_WB_EAGER = 1,     // Also clean lines near the LRU position when the
+                         // DRAM is idle.
+    L2_WB_ROW = 2,       // With each writeback, also write the other dirty
+                         // lines in the same DRAM row.
+    L2_WB_EAGER_ROW = 3, // Both.
+} L2WritebackPolicy;
+
+/** The dirty lines of one core in one DRAM row. */
+typedef struct DbiEntry
+{
+    uint64_t row;
+    unsigned int core_id;
+
+    /** One bit per line of the row. An entry with no bits set is free. */
+    uint64_t dirty;
+} DbiEntry;
+
+/**
+ * A hash table from DRAM rows to their dirty L2 lines, with room for an entry
+ * per line of the L2 cache, so that it never has to force a writeback.
+ */
+typedef struct Dbi
+{
+    DbiEntry *entries;
+    uint64_t mask;
+
+    /** The number of low line address bits that select a line in a row. */
+    unsigned int row_bits;
+} Dbi;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a dirty-block index.
+ *
+ * @param max_lines The largest number of dirty lines to track.
+ * @param row_bits The number of low line address bits that select a line in
+ *                 a DRAM row, at most 6.
+ * @return A pointer to the index.
+ */
+Dbi *dbi_new(uint64_t max_lines, unsigned int row_bits);
+
+/**
+ * Record that a line is dirty.
+ *
+ * @param dbi The index.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ */
+void dbi_mark(Dbi *dbi, uint64_t line_addr, unsigned int core_id);
+
+/**
+ * Record that a line is clean or no longer cached.
+ *
+ * @param dbi The index.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param core_id The CPU core ID that owns the line.
+ */
+void dbi_clear(Dbi *dbi, uint64_t line_addr, unsigned int core_id);
+
+/**
+ * Find the dirty lines of a core in the DRAM row of the given line.
+ *
+ * @param dbi The index.
+ * @param line_addr The address of any cache line in the row (in units of the
+ *                  cache line size).
+ * @param core_id The CPU core ID that owns the lines.
+ * @return A mask with bit i set if the line at offset i of the row is dirty.
+ */
+uint64_t dbi_row_dirty(Dbi *dbi, uint64_t line_addr, unsigned int core_id);
+
+/**
+ * Free a dirty-block index.
+ *
+ * @param dbi The index to free.
+ */
+void dbi_free(Dbi *dbi);
+
+#endif // __DBI_H__
@@ -27,12 +27,39 @@
  */
 #define DELAY_BUS 10
 
+/**
+ * The DRAM write recovery latency (WR), in cycles, after which a written row
+ * may be precharged. Only modelled with subarrays.
+ */
+#define DELAY_WR 45
+
+/** The latency of switching MASA to another activated subarray, in cycles. */
+#define DELAY_SA_SEL 5
+
+/** The latency of leaving power-down (tXP), in cycles. */
+#define DELAY_XP 12
+
+/**
+ * The latency of leaving self-refresh (tXS), in cycles: a refresh cycle
+ * (tRFC) plus 10 ns.
+ */
+#define DELAY_XS 540
+
 /** The row buffer size, in bytes. */
 #define ROW_BUFFER_SIZE 1024
 
 /** The number of banks in the DRAM module. */
 #define NUM_BANKS 16
 
+/** How often the analytical model is refreshed, in cycles. */
+#define DRAM_MODEL_INTERVAL 10000
+
+/**
+ * The highest utilisation the analytical model assumes for a bank or the bus,
+ * which keeps the M/D/1 waiting time finite.
+ */
+#define DRAM_MODEL_MAX_UTIL 0.95
+
 ///////////////////////////////////////////////////////////////////////////////
 //                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
 ///////////////////////////////////////////////////////////////////////////////
@@ -48,6 +75,42 @@ extern uint64_t CACHE_LINESIZE;
 /** Which page policy the DRAM should use. */
 extern DRAMPolicy DRAM_PAGE_POLICY;
 
+/** How the DRAM latency is computed in modes C through F. */
+extern DRAMModel DRAM_MODEL;
+
+/** How the subarrays of each bank are organised. */
+extern DRAMSalp DRAM_SALP;
+
+/** The number of subarrays in each bank. */
+extern unsigned int DRAM_SUBARRAYS;
+
+/** The number of rows in the row buffer cache of each bank, or 0 if none. */
+extern unsigned int DRAM_RBC_ROWS;
+
+/** The associativity of the row buffer caches. */
+extern unsigned int DRAM_RBC_ASSOC;
+
+/** The latency of reading a line from a row buffer cache, in cycles. */
+extern unsigned int DRAM_RBC_LATENCY;
+
+/** The RowHammer mitigation of the DRAM. */
+extern RowHammerMitigation RH_MITIGATION;
+
+/** The scheduler that orders the requests of each bank. */
+extern MemSchedulerType DRAM_SCHED;
+
+/** The number of ranks the DRAM banks are split into. */
+extern unsigned int DRAM_RANKS;
+
+/** The idle cycles after which a rank enters power-down, or 0 for never. */
+extern uint64_t DRAM_PD_THRESHOLD;
+
+/** The idle cycles after which a rank enters self-refresh, or 0 for never. */
+extern uint64_t DRAM_SR_THRESHOLD;
+
+/** The current clock cycle number. */
+extern thread_local uint64_t current_cycle;
+
 ///////////////////////////////////////////////////////////////////////////////
 //                           FUNCTION DEFINITIONS                            //
 ///////////////////////////////////////////////////////////////////////////////
@@ -67,29 +130,249 @@ DRAM *dram_new()
     d->stat_read_delay = 0;
     d->stat_write_access = 0;
     d->stat_write_delay = 0;
+    d->stat_row_hits = 0;
+    d->stat_queue_delay = 0;
+    d->stat_model_intervals = 0;
+    d->stat_activates = 0;
+    d->stat_precharges = 0;
+    d->stat_sa_conflicts = 0;
+    d->stat_sa_same_conflicts = 0;
+    d->stat_pd_entries = 0;
+    d->stat_sr_entries = 0;
+    d->stat_pd_cycles = 0;
+    d->stat_sr_cycles = 0;
+    d->stat_lp_delay = 0;
 
     // Access info
     d->bank_bits = (unsigned)(std::log2(NUM_BANKS));
+
+    d->model = NULL;
+    d->model_bus_delay = 0.0;
+    d->model_interval_start = 0;
+    d->busy_until = 0;
+    d->salp = NULL;
+    d->sa_rowbuf = NULL;
+    if (DRAM_SALP != SALP_OFF)
+    {
+        d->salp = (SalpBank*)calloc(NUM_BANKS, sizeof(SalpBank));
+    }
+    if (DRAM_SALP == SALP_MASA)
+    {
+        d->sa_rowbuf = (RowBuffer*)calloc(NUM_BANKS * DRAM_SUBARRAYS,
+                                          sizeof(RowBuffer));
+    }
+    d->rbc = NULL;
+    d->rbc_sets = 0;
+    d->rbc_clock = 0;
+    d->stat_rbc_access = NULL;
+    d->stat_rbc_hits = NULL;
+    if (DRAM_RBC_ROWS)
+    {
+        d->rbc = (RbcEntry*)calloc(NUM_BANKS * DRAM_RBC_ROWS,
+                                   sizeof(RbcEntry));
+        d->rbc_sets = DRAM_RBC_ROWS / DRAM_RBC_ASSOC;
+        d->stat_rbc_access = (unsigned long long*)calloc(
+            NUM_BANKS, sizeof(unsigned long long));
+        d->stat_rbc_hits = (unsigned long long*)calloc(
+            NUM_BANKS, sizeof(unsigned long long));
+    }
+    d->rh = NULL;
+    if (RH_MITIGATION != RH_OFF)
+    {
+        d->rh = rowhammer_new(NUM_BANKS);
+    }
+    d->sched = NULL;
+    if (DRAM_SCHED != SCHED_OFF)
+    {
+        d->sched = sched_new(NUM_BANKS, DELAY_CAS, DELAY_ACT + DELAY_CAS,
+                             DELAY_PRE + DELAY_ACT + DELAY_CAS);
+    }
+    d->lp = NULL;
+    d->lp_rank_banks = 0;
+    if (DRAM_PD_THRESHOLD || DRAM_SR_THRESHOLD)
+    {
+        d->lp = (LowPowerRank*)calloc(DRAM_RANKS, sizeof(LowPowerRank));
+        d->lp_rank_banks = NUM_BANKS / DRAM_RANKS;
+    }
+    if (DRAM_MODEL == DRAM_MODEL_ANALYTICAL)
+    {
+        d->model = (BankModel*)calloc(NUM_BANKS, sizeof(BankModel));
+        for (unsigned i = 0; i < NUM_BANKS; i++)
+        {
+            d->model[i].service = DELAY_ACT + DELAY_CAS;
+        }
+    }
     return d;
 }
 
 /**
- * Access the DRAM at the given cache line address.
- * 
- * @param dram The DRAM module to access.
- * @param line_addr The address of the cache line to access (in units of the
- *                  cache line size).
- * @param is_dram_write Whether this access writes to DRAM.
- * @return The delay in cycles incurred by this DRAM access.
+ * Count the activation of the row of an access towards RowHammer, and find
+ * the extra time its mitigation takes: throttling, and refreshing the
+ * neighbouring rows, each with an ACT and a PRE, after closing the open rows
+ * of the bank.
  */
-uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write)
+static uint64_t dram_rowhammer(DRAM *dram, uint64_t line_addr)
+{
+    unsigned row_no = (unsigned) (line_addr >> dram->bank_bits);
+    unsigned bank_no = (unsigned) row_no % NUM_BANKS;
+
+    unsigned int refreshes;
+    uint64_t delay = rowhammer_activate(dram->rh, bank_no, row_no,
+                                        current_cycle, &refreshes);
+    if (refreshes)
+    {
+        delay += refreshes * (DELAY_ACT + DELAY_PRE);
+        dram->stat_activates += refreshes;
+        dram->stat_precharges += refreshes;
+
+        // Every open row of the bank is closed, in each subarray with MASA.
+        bool closed = false;
+        if (dram->rowbuf[bank_no].valid)
+        {
+            dram->stat_precharges++;
+            dram->rowbuf[bank_no].valid = false;
+            closed = true;
+        }
+        for (unsigned i = 0; dram->sa_rowbuf && i < DRAM_SUBARRAYS; i++)
+        {
+            RowBuffer *rb = &dram->sa_rowbuf[bank_no * DRAM_SUBARRAYS + i];
+            if (rb->valid)
+            {
+                dram->stat_precharges++;
+                rb->valid = false;
+                closed = true;
+            }
+        }
+        if (closed)
+        {
+            delay += DELAY_PRE;
+        }
+    }
+    dram->rh->stat_delay += delay;
+    return delay;
+}
+
+/**
+ * Find the states the rank of an access passed through while it was idle,
+ * and how long the access waits for the rank to leave the deepest one. A rank
+ * in self-refresh has closed its rows.
+ */
+static uint64_t dram_wake_rank(DRAM *dram, uint64_t line_addr)
+{
+    unsigned row_no = (unsigned) (line_addr >> dram->bank_bits);
+    unsigned bank_no = (unsigned) row_no % NUM_BANKS;
+    unsigned rank_no = bank_no / dram->lp_rank_banks;
+    LowPowerRank *rank = &dram->lp[rank_no];
+    if (current_cycle <= rank->busy_until)
+    {
+        return 0;
+    }
+
+    uint64_t idle = current_cycle - rank->busy_until;
+    uint64_t pd_until = idle;
+    uint64_t delay = 0;
+    if (DRAM_SR_THRESHOLD && idle >= DRAM_SR_THRESHOLD)
+    {
+        dram->stat_sr_entries++;
+        dram->stat_sr_cycles += idle - DRAM_SR_THRESHOLD;
+        pd_until = DRAM_SR_THRESHOLD;
+        delay = DELAY_XS;
+
+        for (unsigned i = 0; i < dram->lp_rank_banks; i++)
+        {
+            RowBuffer *rb = &dram->rowbuf[rank_no * dram->lp_rank_banks + i];
+            if (rb->valid)
+            {
+                rb->valid = false;
+                dram->stat_precharges++;
+            }
+        }
+        for (unsigned i = 0; dram->sa_rowbuf &&
+                             i < dram->lp_rank_banks * DRAM_SUBARRAYS; i++)
+        {
+            RowBuffer *rb = &dram->sa_rowbuf[rank_no * dram->lp_rank_banks *
+                                             DRAM_SUBARRAYS + i];
+            if (rb->valid)
+            {
+                rb->valid = false;
+                dram->stat_precharges++;
+            }
+        }
+        if (dram->sched)
+        {
+            unsigned long long served[3];
+            unsigned closed = sched_close_rows(dram->sched,
+                                               rank_no * dram->lp_rank_banks,
+                                               dram->lp_rank_banks, served);
+            dram->stat_row_hits += served[0];
+            dram->stat_activates += served[1] + served[2];
+            dram->stat_precharges += served[2] + closed;
+        }
+    }
+    if (DRAM_PD_THRESHOLD && pd_until >= DRAM_PD_THRESHOLD)
+    {
+        dram->stat_pd_entries++;
+        dram->stat_pd_cycles += pd_until - DRAM_PD_THRESHOLD;
+        if (!delay)
+        {
+            delay = DELAY_XP;
+        }
+    }
+    dram->stat_lp_delay += delay;
+    return delay;
+}
+
+/**
+ * Access the DRAM at the given cache line address, for the given core or for
+ * none.
+ */
+static uint64_t dram_access_for(DRAM *dram, uint64_t line_addr,
+                                bool is_dram_write, unsigned int core_id)
 {
     uint64_t delay = 0;
+    if (dram->lp)
+    {
+        delay += dram_wake_rank(dram, line_addr);
+    }
+
+    unsigned long long activates = dram->stat_activates;
     if (SIM_MODE == SIM_MODE_B)
+    {
         delay += DELAY_SIM_MODE_B;
+        dram->stat_activates++;
+        dram->stat_precharges++;
+    }
+    else if (DRAM_MODEL == DRAM_MODEL_ANALYTICAL)
+        delay += dram_access_analytical(dram, line_addr, is_dram_write);
+    else if (DRAM_SALP != SALP_OFF)
+        delay += dram_access_salp(dram, line_addr, is_dram_write);
+    else if (dram->sched)
+        delay += dram_access_sched(dram, line_addr, core_id);
+    else if (dram->rbc)
+        delay += dram_access_rbc(dram, line_addr, is_dram_write);
     else 
         delay += dram_access_mode_CDEF(dram, line_addr, is_dram_write);
 
+    if (dram->rh && dram->stat_activates != activates)
+    {
+        delay += dram_rowhammer(dram, line_addr);
+    }
+
+    if (current_cycle + delay > dram->busy_until)
+    {
+        dram->busy_until = current_cycle + delay;
+    }
+    if (dram->lp)
+    {
+        unsigned row_no = (unsigned) (line_addr >> dram->bank_bits);
+        LowPowerRank *rank = &dram->lp[row_no % NUM_BANKS /
+                                       dram->lp_rank_banks];
+        if (current_cycle + delay > rank->busy_until)
+        {
+            rank->busy_until = current_cycle + delay;
+        }
+    }
+
     // Update dram stats
     if(is_dram_write)
     {
@@ -104,6 +387,36 @@ uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write)
     return delay;
 }
 
+/**
+ * Access the DRAM at the given cache line address.
+ * 
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param is_dram_write Whether this access writes to DRAM.
+ * @return The delay in cycles incurred by this DRAM access.
+ */
+uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write)
+{
+    return dram_access_for(dram, line_addr, is_dram_write, SCHED_NO_CORE);
+}
+
+/**
+ * Read the given cache line address from the DRAM for a core that waits for
+ * it. The memory scheduler, if any, tells the requests of cores apart.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to read (in units of the
+ *                  cache line size).
+ * @param core_id The CPU core ID that waits for the line.
+ * @return The delay in cycles incurred by this DRAM access.
+ */
+uint64_t dram_demand_read(DRAM *dram, uint64_t line_addr,
+                          unsigned int core_id)
+{
+    return dram_access_for(dram, line_addr, false, core_id);
+}
+
 /**
  * For modes C through F, access the DRAM at the given cache line address.
  * 
@@ -133,6 +446,8 @@ uint64_t dram_access_mode_CDEF(DRAM *dram, uint64_t line_addr,
             {
                 delay += DELAY_PRE + DELAY_ACT + DELAY_CAS;
                 dram->rowbuf[bank_no].rowID = row_no;
+                dram->stat_precharges++;
+                dram->stat_activates++;
             }
         }    
         // not active
@@ -141,6 +456,7 @@ uint64_t dram_access_mode_CDEF(DRAM *dram, uint64_t line_addr,
             delay += DELAY_ACT + DELAY_CAS;
             dram->rowbuf[bank_no].rowID = row_no;
             dram->rowbuf[bank_no].valid = true;
+            dram->stat_activates++;
         }
     }
     else
@@ -148,10 +464,449 @@ uint64_t dram_access_mode_CDEF(DRAM *dram, uint64_t line_addr,
         delay += DELAY_ACT + DELAY_CAS;
         dram->rowbuf[bank_no].rowID = row_no;
         dram->rowbuf[bank_no].valid = false;
+        dram->stat_activates++;
+        dram->stat_precharges++;
+    }
+    return delay;
+}
+
+/**
+ * For modes C through F, access the DRAM at the given cache line address,
+ * modelling the subarrays of each bank as DRAM_SALP selects.
+ *
+ * Consecutive rows of a bank lie in consecutive subarrays. A row conflict
+ * costs PRE + ACT + CAS, plus WR first if the bank last wrote the row being
+ * closed. SALP-1 overlaps the PRE with the ACT when the new row is in another
+ * subarray, SALP-2 also overlaps the WR, and MASA keeps the row of every
+ * subarray open, paying SA_SEL to switch between them.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param is_dram_write Whether this access writes to DRAM.
+ * @return The delay in cycles incurred by this DRAM access.
+ */
+uint64_t dram_access_salp(DRAM *dram, uint64_t line_addr, bool is_dram_write)
+{
+    unsigned row_no = (unsigned) (line_addr >> dram->bank_bits);
+    unsigned bank_no = (unsigned) row_no % NUM_BANKS;
+    unsigned subarray = (row_no / NUM_BANKS) % DRAM_SUBARRAYS;
+    SalpBank *bank = &dram->salp[bank_no];
+    bool same_subarray = bank->accessed && bank->last_subarray == subarray;
+
+    // Without MASA, the one open row of the bank may be in any subarray.
+    RowBuffer *rowbuf = &dram->rowbuf[bank_no];
+    if (DRAM_SALP == SALP_MASA)
+    {
+        rowbuf = &dram->sa_rowbuf[bank_no * DRAM_SUBARRAYS + subarray];
+    }
+
+    uint64_t delay = DELAY_BUS;
+    if (rowbuf->valid && rowbuf->rowID == row_no)
+    {
+        delay += DELAY_CAS;
+        if (DRAM_SALP == SALP_MASA && !same_subarray)
+        {
+            delay += DELAY_SA_SEL;
+        }
+        dram->stat_row_hits++;
+    }
+    else if (rowbuf->valid)
+    {
+        unsigned open_subarray = (rowbuf->rowID / NUM_BANKS) % DRAM_SUBARRAYS;
+        bool other_subarray = open_subarray != subarray;
+        bool overlap = other_subarray && DRAM_SALP != SALP_NONE;
+        if (other_subarray)
+        {
+            dram->stat_sa_conflicts++;
+        }
+        else
+        {
+            dram->stat_sa_same_conflicts++;
+        }
+
+        // The closed row must recover from the last write to it, unless
+        // SALP-2 activates the new row while it does. With MASA, the closed
+        // row is in the same subarray as the new one.
+        bool wrote_closed_row = bank->last_write &&
+                                (DRAM_SALP != SALP_MASA || same_subarray);
+        if (wrote_closed_row && (!overlap || DRAM_SALP == SALP_1))
+        {
+            delay += DELAY_WR;
+        }
+        delay += overlap ? DELAY_ACT + DELAY_CAS
+                         : DELAY_PRE + DELAY_ACT + DELAY_CAS;
+        rowbuf->rowID = row_no;
+        dram->stat_precharges++;
+        dram->stat_activates++;
+    }
+    else
+    {
+        delay += DELAY_ACT + DELAY_CAS;
+        rowbuf->rowID = row_no;
+        rowbuf->valid = true;
+        dram->stat_activates++;
+    }
+
+    bank->accessed = true;
+    bank->last_subarray = subarray;
+    bank->last_write = is_dram_write;
+    return delay;
+}
+
+/**
+ * For modes C through F, access the DRAM at the given cache line address
+ * through the row buffer cache of its bank, which holds the DRAM_RBC_ROWS
+ * rows opened last (set-associative, with LRU replacement). A row not in it
+ * is opened as in dram_access_mode_CDEF() and then cached.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param is_dram_write Whether this access writes to DRAM.
+ * @return The delay in cycles incurred by this DRAM access.
+ */
+uint64_t dram_access_rbc(DRAM *dram, uint64_t line_addr, bool is_dram_write)
+{
+    unsigned row_no = (unsigned) (line_addr >> dram->bank_bits);
+    unsigned bank_no = (unsigned) row_no % NUM_BANKS;
+    unsigned set = (row_no / NUM_BANKS) % dram->rbc_sets;
+    RbcEntry *ways = &dram->rbc[(bank_no * dram->rbc_sets + set) *
+                                DRAM_RBC_ASSOC];
+
+    dram->rbc_clock++;
+    dram->stat_rbc_access[bank_no]++;
+
+    RbcEntry *victim = &ways[0];
+    for (unsigned i = 0; i < DRAM_RBC_ASSOC; i++)
+    {
+        if (ways[i].valid && ways[i].rowID == row_no)
+        {
+            ways[i].last_use = dram->rbc_clock;
+            dram->stat_rbc_hits[bank_no]++;
+            return DELAY_BUS + DRAM_RBC_LATENCY;
+        }
+        if (!ways[i].valid ||
+            (victim->valid && ways[i].last_use < victim->last_use))
+        {
+            victim = &ways[i];
+        }
+    }
+
+    uint64_t delay = dram_access_mode_CDEF(dram, line_addr, is_dram_write);
+    victim->valid = true;
+    victim->rowID = row_no;
+    victim->last_use = dram->rbc_clock;
+    return delay;
+}
+
+/**
+ * The mean waiting time of an M/D/1 queue.
+ *
+ * @param arrival_rate The arrivals per cycle.
+ * @param service The (deterministic) service time in cycles.
+ * @param util Receives the utilisation.
+ * @return The mean time spent waiting before service, in cycles.
+ */
+static double md1_wait(double arrival_rate, double service, double *util)
+{
+    double rho = arrival_rate * service;
+    if (rho > DRAM_MODEL_MAX_UTIL)
+    {
+        rho = DRAM_MODEL_MAX_UTIL;
+    }
+    *util = rho;
+    return rho * service / (2.0 * (1.0 - rho));
+}
+
+/**
+ * Re-estimate the service and queueing delays of every bank and of the bus
+ * from the traffic of the interval that just ended.
+ */
+static void dram_model_refresh(DRAM *dram)
+{
+    double cycles = (double)(current_cycle - dram->model_interval_start);
+    unsigned long long total_arrivals = 0;
+
+    for (unsigned i = 0; i < NUM_BANKS; i++)
+    {
+        BankModel *bank = &dram->model[i];
+        if (bank->arrivals)
+        {
+            bank->hit_ratio = (double)bank->row_hits / (double)bank->arrivals;
+        }
+
+        if (DRAM_PAGE_POLICY == OPEN_PAGE)
+        {
+            bank->service = bank->hit_ratio * DELAY_CAS +
+                            (1.0 - bank->hit_ratio) *
+                                (DELAY_PRE + DELAY_ACT + DELAY_CAS);
+        }
+        else
+        {
+            bank->service = DELAY_ACT + DELAY_CAS;
+        }
+
+        double util;
+        bank->queue_delay = md1_wait(bank->arrivals / cycles, bank->service,
+                                     &util);
+
+        total_arrivals += bank->arrivals;
+        bank->arrivals = 0;
+        bank->row_hits = 0;
     }
+
+    double bus_util;
+    dram->model_bus_delay = md1_wait(total_arrivals / cycles, DELAY_BUS,
+                                     &bus_util);
+    dram->model_interval_start = current_cycle;
+    dram->stat_model_intervals++;
+}
+
+/**
+ * For modes C through F, queue an access at its bank, where the scheduler of
+ * DRAM_SCHED places it, and find when the bank will have served it. The open
+ * row of each bank follows the order in which it serves its requests.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param core_id The CPU core ID that waits for the access, or
+ *                SCHED_NO_CORE.
+ * @return The delay in cycles incurred by this DRAM access.
+ */
+uint64_t dram_access_sched(DRAM *dram, uint64_t line_addr,
+                           unsigned int core_id)
+{
+    unsigned row_no = (unsigned) (line_addr >> dram->bank_bits);
+    unsigned bank_no = (unsigned) row_no % NUM_BANKS;
+
+    // Requests are counted once served, as the scheduler may still reorder
+    // those queued.
+    unsigned long long served[3];
+    uint64_t delay = DELAY_BUS + sched_access(dram->sched, bank_no, row_no,
+                                              core_id, current_cycle, served);
+    dram->stat_row_hits += served[0];
+    dram->stat_activates += served[1] + served[2];
+    dram->stat_precharges += served[2];
     return delay;
 }
 
+/**
+ * For modes C through F, estimate the latency of an access from the row
+ * buffer hit ratio and the load of its bank and of the bus, each modelled as
+ * an M/D/1 queue whose parameters are refreshed from the traffic observed in
+ * each interval of DRAM_MODEL_INTERVAL cycles.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param is_dram_write Whether this access writes to DRAM.
+ * @return The estimated delay in cycles of this DRAM access.
+ */
+uint64_t dram_access_analytical(DRAM *dram, uint64_t line_addr,
+                                bool is_dram_write)
+{
+    if (current_cycle - dram->model_interval_start >= DRAM_MODEL_INTERVAL)
+    {
+        dram_model_refresh(dram);
+    }
+
+    unsigned row_no = (unsigned) (line_addr >> dram->bank_bits);
+    unsigned bank_no = (unsigned) row_no % NUM_BANKS;
+    BankModel *bank = &dram->model[bank_no];
+
+    // Only measure the row hit ratio; the latency uses the estimate.
+    bank->arrivals++;
+    if (dram->rowbuf[bank_no].valid == true &&
+        dram->rowbuf[bank_no].rowID == row_no)
+    {
+        bank->row_hits++;
+        dram->stat_row_hits++;
+    }
+    else
+    {
+        // Open page closes the old row only when a different one is needed;
+        // close page closes every row right after its access.
+        dram->stat_activates++;
+        if (dram->rowbuf[bank_no].valid || DRAM_PAGE_POLICY == CLOSE_PAGE)
+        {
+            dram->stat_precharges++;
+        }
+    }
+    dram->rowbuf[bank_no].rowID = row_no;
+    dram->rowbuf[bank_no].valid = (DRAM_PAGE_POLICY == OPEN_PAGE);
+
+    double queue_delay = bank->queue_delay + dram->model_bus_delay;
+    dram->stat_queue_delay += (uint64_t)(queue_delay + 0.5);
+    return (uint64_t)(DELAY_BUS + bank->service + queue_delay + 0.5);
+}
+
+/**
+ * Check whether every DRAM access issued so far has completed.
+ *
+ * @param dram The DRAM module.
+ * @return Whether the DRAM is idle in the current cycle.
+ */
+bool dram_idle(DRAM *dram)
+{
+    return current_cycle >= dram->busy_until;
+}
+
+/**
+ * Find how many low line address bits select a line within a DRAM row. Lines
+ * whose addresses differ only in these bits share a bank and a row.
+ *
+ * @param dram The DRAM module.
+ * @return The number of bits.
+ */
+unsigned int dram_row_line_bits(DRAM *dram)
+{
+    // The row number is the line address without the bank bits, and the
+    // bank is taken from the row number.
+    return dram->bank_bits;
+}
+
+/**
+ * Ask the host to prefetch the row buffer state that the given address maps
+ * to.
+ *
+ * @param dram The DRAM module that will be accessed.
+ * @param line_addr The address of the cache line that will be accessed (in
+ *                  units of the cache line size).
+ */
+void dram_prefetch_row(DRAM *dram, uint64_t line_addr)
+{
+    unsigned row_no = (unsigned) (line_addr >> dram->bank_bits);
+    __builtin_prefetch(&dram->rowbuf[row_no % NUM_BANKS]);
+}
+
+/**
+ * Restart the clock of the DRAM module at cycle 0, when the simulation
+ * restarts its own, letting every bank finish the requests it holds.
+ *
+ * @param dram The DRAM module whose clock restarts.
+ */
+void dram_reset_clock(DRAM *dram)
+{
+    dram->busy_until = 0;
+    dram->model_interval_start = 0;
+    if (dram->lp)
+    {
+        for (unsigned i = 0; i < NUM_BANKS / dram->lp_rank_banks; i++)
+        {
+            dram->lp[i].busy_until = 0;
+        }
+    }
+    if (dram->sched)
+    {
+        sched_reset_clock(dram->sched);
+    }
+}
+
+/**
+ * Reset the statistics of the DRAM module.
+ *
+ * @param dram The DRAM module to reset the statistics of.
+ */
+void dram_clear_stats(DRAM *dram)
+{
+    dram->stat_read_access = 0;
+    dram->stat_read_delay = 0;
+    dram->stat_write_access = 0;
+    dram->stat_write_delay = 0;
+    dram->stat_row_hits = 0;
+    dram->stat_queue_delay = 0;
+    dram->stat_model_intervals = 0;
+    dram->stat_activates = 0;
+    dram->stat_precharges = 0;
+    dram->stat_sa_conflicts = 0;
+    dram->stat_sa_same_conflicts = 0;
+    dram->stat_pd_entries = 0;
+    dram->stat_sr_entries = 0;
+    dram->stat_pd_cycles = 0;
+    dram->stat_sr_cycles = 0;
+    dram->stat_lp_delay = 0;
+    for (unsigned i = 0; dram->rbc && i < NUM_BANKS; i++)
+    {
+        dram->stat_rbc_access[i] = 0;
+        dram->stat_rbc_hits[i] = 0;
+    }
+    if (dram->rh)
+    {
+        rowhammer_clear_stats(dram->rh);
+    }
+    if (dram->sched)
+    {
+        sched_clear_stats(dram->sched);
+    }
+}
+
+/**
+ * Add the statistics of one DRAM module to those of another.
+ *
+ * @param dst The DRAM module whose statistics are increased.
+ * @param src The DRAM module whose statistics are added.
+ */
+void dram_add_stats(DRAM *dst, const DRAM *src)
+{
+    dst->stat_read_access += src->stat_read_access;
+    dst->stat_read_delay += src->stat_read_delay;
+    dst->stat_write_access += src->stat_write_access;
+    dst->stat_write_delay += src->stat_write_delay;
+    dst->stat_row_hits += src->stat_row_hits;
+    dst->stat_queue_delay += src->stat_queue_delay;
+    dst->stat_model_intervals += src->stat_model_intervals;
+    dst->stat_activates += src->stat_activates;
+    dst->stat_precharges += src->stat_precharges;
+    dst->stat_sa_conflicts += src->stat_sa_conflicts;
+    dst->stat_sa_same_conflicts += src->stat_sa_same_conflicts;
+    dst->stat_pd_entries += src->stat_pd_entries;
+    dst->stat_sr_entries += src->stat_sr_entries;
+    dst->stat_pd_cycles += src->stat_pd_cycles;
+    dst->stat_sr_cycles += src->stat_sr_cycles;
+    dst->stat_lp_delay += src->stat_lp_delay;
+    for (unsigned i = 0; dst->rbc && src->rbc && i < NUM_BANKS; i++)
+    {
+        dst->stat_rbc_access[i] += src->stat_rbc_access[i];
+        dst->stat_rbc_hits[i] += src->stat_rbc_hits[i];
+    }
+    if (dst->rh && src->rh)
+    {
+        rowhammer_add_stats(dst->rh, src->rh);
+    }
+    if (dst->sched && src->sched)
+    {
+        sched_add_stats(dst->sched, src->sched);
+    }
+}
+
+/**
+ * Free a DRAM module.
+ *
+ * @param dram The DRAM module to free.
+ */
+void dram_free(DRAM *dram)
+{
+    free(dram->model);
+    free(dram->salp);
+    free(dram->sa_rowbuf);
+    free(dram->rbc);
+    free(dram->stat_rbc_access);
+    free(dram->stat_rbc_hits);
+    free(dram->lp);
+    if (dram->rh)
+    {
+        rowhammer_free(dram->rh);
+    }
+    if (dram->sched)
+    {
+        sched_free(dram->sched);
+    }
+    free(dram->rowbuf);
+    free(dram);
+}
+
 /**
  * Print the statistics of the DRAM module.
  * 
@@ -179,4 +934,91 @@ void dram_print_stats(DRAM *dram)
     printf("DRAM_WRITE_ACCESS    \t\t : %10llu\n", dram->stat_write_access);
     printf("DRAM_READ_DELAY_AVG  \t\t : %10.3f\n", avg_read_delay);
     printf("DRAM_WRITE_DELAY_AVG \t\t : %10.3f\n", avg_write_delay);
+
+    if (dram->model)
+    {
+        unsigned long long accesses = dram->stat_read_access +
+                                      dram->stat_write_access;
+        double row_hit_perc = 0.0;
+        double avg_queue_delay = 0.0;
+        if (accesses)
+        {
+            row_hit_perc = 100.0 * (double)(dram->stat_row_hits) /
+                           (double)accesses;
+            avg_queue_delay = (double)(dram->stat_queue_delay) /
+                              (double)accesses;
+        }
+        printf("DRAM_MODEL_INTERVALS \t\t : %10llu\n",
+               dram->stat_model_intervals);
+        printf("DRAM_ROW_HIT_PERC    \t\t : %10.3f\n", row_hit_perc);
+        printf("DRAM_QUEUE_DELAY_AVG \t\t : %10.3f\n", avg_queue_delay);
+    }
+
+    if (dram->salp || dram->sched)
+    {
+        unsigned long long accesses = dram->stat_read_access +
+                                      dram->stat_write_access;
+        double row_hit_perc = 0.0;
+        if (accesses)
+        {
+            row_hit_perc = 100.0 * (double)(dram->stat_row_hits) /
+                           (double)accesses;
+        }
+        printf("DRAM_ROW_HIT_PERC    \t\t : %10.3f\n", row_hit_perc);
+    }
+
+    if (dram->salp)
+    {
+        printf("DRAM_SA_CONFLICTS    \t\t : %10llu\n",
+               dram->stat_sa_conflicts);
+        printf("DRAM_SA_SAME_CONFLICTS\t\t : %10llu\n",
+               dram->stat_sa_same_conflicts);
+    }
+
+    if (dram->rbc)
+    {
+        unsigned long long accesses = 0;
+        unsigned long long hits = 0;
+        for (unsigned i = 0; i < NUM_BANKS; i++)
+        {
+            accesses += dram->stat_rbc_access[i];
+            hits += dram->stat_rbc_hits[i];
+        }
+        printf("DRAM_RBC_HITS        \t\t : %10llu\n", hits);
+        printf("DRAM_RBC_HIT_PERC    \t\t : %10.3f\n",
+               accesses ? 100.0 * (double)hits / (double)accesses : 0.0);
+        for (unsigned i = 0; i < NUM_BANKS; i++)
+        {
+            double hit_perc = 0.0;
+            if (dram->stat_rbc_access[i])
+            {
+                hit_perc = 100.0 * (double)dram->stat_rbc_hits[i] /
+                           (double)dram->stat_rbc_access[i];
+            }
+            printf("DRAM_RBC_BANK_%02u_HIT_PERC\t : %10.3f\n", i, hit_perc);
+        }
+    }
+
+    if (dram->lp)
+    {
+        printf("DRAM_PD_ENTRIES      \t\t : %10llu\n", dram->stat_pd_entries);
+        printf("DRAM_SR_ENTRIES      \t\t : %10llu\n", dram->stat_sr_entries);
+        printf("DRAM_PD_CYCLES       \t\t : %10llu\n",
+               (unsigned long long)dram->stat_pd_cycles);
+        printf("DRAM_SR_CYCLES       \t\t : %10llu\n",
+               (unsigned long long)dram->stat_sr_cycles);
+        printf("DRAM_LP_EXIT_DELAY   \t\t : %10llu\n",
+               (unsigned long long)dram->stat_lp_delay);
+    }
+
+    if (dram->sched)
+    {
+        sched_print_stats(dram->sched);
+    }
+
+    if (dram->rh)
+    {
+        rowhammer_print_stats(dram->rh, dram->stat_read_delay +
+                                            dram->stat_write_delay);
+    }
 }
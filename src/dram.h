@@ -5,6 +5,18 @@
 #define __DRAM_H__
 
 #include "types.h"
+#include "rowhammer.h"
+#include "sched.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The largest number of subarrays in a DRAM bank. */
+#define MAX_SUBARRAYS 128
+
+/** The largest number of rows in the row buffer cache of a DRAM bank. */
+#define MAX_RBC_ROWS 64
 
 ///////////////////////////////////////////////////////////////////////////////
 //                              DATA STRUCTURES                              //
@@ -17,6 +29,46 @@ typedef struct RowBuffer
     unsigned rowID;
 } RowBuffer;
 
+/** The traffic and estimated latency of one bank for the analytical model. */
+typedef struct BankModel
+{
+    /** The accesses and row buffer hits seen in the current interval. */
+    unsigned long long arrivals;
+    unsigned long long row_hits;
+
+    /** The row buffer hit ratio measured in the last interval with traffic. */
+    double hit_ratio;
+
+    /** The estimated service time and queueing delay, in cycles. */
+    double service;
+    double queue_delay;
+} BankModel;
+
+/** One recently opened row in the row buffer cache of a bank. */
+typedef struct RbcEntry
+{
+    bool valid;
+    unsigned rowID;
+
+    /** When the row was last accessed, in accesses to the DRAM. */
+    uint64_t last_use;
+} RbcEntry;
+
+/** The last access to one bank, for subarray-level parallelism. */
+typedef struct SalpBank
+{
+    bool accessed;
+    unsigned last_subarray;
+    bool last_write;
+} SalpBank;
+
+/** The low-power state of one rank of DRAM banks. */
+typedef struct LowPowerRank
+{
+    /** The cycle by which every access to the rank has completed. */
+    uint64_t busy_until;
+} LowPowerRank;
+
 /** A DRAM module. */
 typedef struct DRAM
 {
@@ -25,6 +77,43 @@ typedef struct DRAM
 
     // access info
     unsigned bank_bits;
+
+    // For the analytical model, the per-bank estimates, the queueing delay
+    // of the shared bus, and when the current interval started.
+    BankModel *model;
+    double model_bus_delay;
+    uint64_t model_interval_start;
+
+    /** The cycle by which every access issued so far has completed. */
+    uint64_t busy_until;
+
+    /**
+     * For subarray-level parallelism, the last access to each bank, and with
+     * MASA the local row buffer of each subarray, bank by bank.
+     */
+    SalpBank *salp;
+    RowBuffer *sa_rowbuf;
+
+    /**
+     * The row buffer caches, bank by bank and set by set, the number of sets
+     * of each, and the clock that orders their entries for LRU.
+     */
+    RbcEntry *rbc;
+    unsigned rbc_sets;
+    uint64_t rbc_clock;
+
+    /** The activation trackers of the RowHammer mitigation, if any. */
+    RowHammer *rh;
+
+    /** The request queues of the banks and their scheduler, if any. */
+    MemScheduler *sched;
+
+    /**
+     * With low-power states, the ranks the banks are split into, and the
+     * number of banks in each.
+     */
+    LowPowerRank *lp;
+    unsigned lp_rank_banks;
     
     /**
      * The total number of times DRAM was accessed for a read.
@@ -45,6 +134,52 @@ typedef struct DRAM
      * The total number of cycles spent on DRAM writes.
      */
     uint64_t stat_write_delay;
+
+    /**
+     * For the analytical model, the number of accesses that would have hit
+     * the row buffer.
+     */
+    unsigned long long stat_row_hits;
+
+    /**
+     * For the analytical model, the total estimated cycles spent queueing
+     * for banks and the bus.
+     */
+    uint64_t stat_queue_delay;
+
+    /** For the analytical model, the number of times it was refreshed. */
+    unsigned long long stat_model_intervals;
+
+    /**
+     * The total number of rows opened (ACT) and closed (PRE). Mode B, which
+     * has no row buffers, counts one of each per access.
+     */
+    unsigned long long stat_activates;
+    unsigned long long stat_precharges;
+
+    /**
+     * With subarrays, the number of row conflicts with an open row in
+     * another subarray of the bank, and in the same subarray.
+     */
+    unsigned long long stat_sa_conflicts;
+    unsigned long long stat_sa_same_conflicts;
+
+    /** With row buffer caches, the accesses to and hits of each bank. */
+    unsigned long long *stat_rbc_access;
+    unsigned long long *stat_rbc_hits;
+
+    /**
+     * With low-power states, the number of times a rank entered power-down
+     * and self-refresh, and the cycles ranks spent in each, summed over the
+     * ranks. A rank that goes on to self-refresh passes through power-down.
+     */
+    unsigned long long stat_pd_entries;
+    unsigned long long stat_sr_entries;
+    uint64_t stat_pd_cycles;
+    uint64_t stat_sr_cycles;
+
+    /** The total cycles accesses waited for their rank to wake up. */
+    uint64_t stat_lp_delay;
 } DRAM;
 
 /** Possible page policies for DRAM. */
@@ -54,6 +189,23 @@ typedef enum DRAMPolicyEnum
     CLOSE_PAGE = 1, // The DRAM uses a close-page policy.
 } DRAMPolicy;
 
+/** Possible models of the DRAM latency in modes C through F. */
+typedef enum DRAMModelEnum
+{
+    DRAM_MODEL_ROWBUF = 0,     // Track the row buffer of each bank.
+    DRAM_MODEL_ANALYTICAL = 1, // Estimate latency from queueing formulas.
+} DRAMModel;
+
+/** Possible organisations of the subarrays of each DRAM bank. */
+typedef enum DRAMSalpEnum
+{
+    SALP_OFF = 0,  // One row buffer per bank, without write recovery.
+    SALP_NONE = 1, // Subarrays and write recovery, but one subarray at a time.
+    SALP_1 = 2,    // Precharge one subarray while activating another.
+    SALP_2 = 3,    // Also activate before the write recovery of another.
+    SALP_MASA = 4, // Keep a row open in every subarray.
+} DRAMSalp;
+
 ///////////////////////////////////////////////////////////////////////////////
 //                            FUNCTION PROTOTYPES                            //
 ///////////////////////////////////////////////////////////////////////////////
@@ -76,6 +228,19 @@ DRAM *dram_new();
  */
 uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write);
 
+/**
+ * Read the given cache line address from the DRAM for a core that waits for
+ * it. The memory scheduler, if any, tells the requests of cores apart.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to read (in units of the
+ *                  cache line size).
+ * @param core_id The CPU core ID that waits for the line.
+ * @return The delay in cycles incurred by this DRAM access.
+ */
+uint64_t dram_demand_read(DRAM *dram, uint64_t line_addr,
+                          unsigned int core_id);
+
 /**
  * For modes C through F, access the DRAM at the given cache line address.
  * 
@@ -88,6 +253,119 @@ uint64_t dram_access(DRAM *dram, uint64_t line_addr, bool is_dram_write);
 uint64_t dram_access_mode_CDEF(DRAM *dram, uint64_t line_addr,
                                bool is_dram_write);
 
+/**
+ * For modes C through F, access the DRAM at the given cache line address,
+ * modelling the subarrays of each bank as DRAM_SALP selects.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param is_dram_write Whether this access writes to DRAM.
+ * @return The delay in cycles incurred by this DRAM access.
+ */
+uint64_t dram_access_salp(DRAM *dram, uint64_t line_addr, bool is_dram_write);
+
+/**
+ * For modes C through F, access the DRAM at the given cache line address
+ * through the row buffer cache of its bank, which holds the DRAM_RBC_ROWS
+ * rows opened last (set-associative, with LRU replacement). A row not in it
+ * is opened as in dram_access_mode_CDEF() and then cached.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param is_dram_write Whether this access writes to DRAM.
+ * @return The delay in cycles incurred by this DRAM access.
+ */
+uint64_t dram_access_rbc(DRAM *dram, uint64_t line_addr, bool is_dram_write);
+
+/**
+ * For modes C through F, queue an access at its bank, where the scheduler of
+ * DRAM_SCHED places it, and find when the bank will have served it. The open
+ * row of each bank follows the order in which it serves its requests.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param core_id The CPU core ID that waits for the access, or
+ *                SCHED_NO_CORE.
+ * @return The delay in cycles incurred by this DRAM access.
+ */
+uint64_t dram_access_sched(DRAM *dram, uint64_t line_addr,
+                           unsigned int core_id);
+
+/**
+ * For modes C through F, estimate the latency of an access from the row
+ * buffer hit ratio and the load of its bank and of the bus, each modelled as
+ * an M/D/1 queue whose parameters are refreshed from the traffic observed in
+ * each interval of DRAM_MODEL_INTERVAL cycles.
+ *
+ * @param dram The DRAM module to access.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param is_dram_write Whether this access writes to DRAM.
+ * @return The estimated delay in cycles of this DRAM access.
+ */
+uint64_t dram_access_analytical(DRAM *dram, uint64_t line_addr,
+                                bool is_dram_write);
+
+/**
+ * Check whether every DRAM access issued so far has completed.
+ *
+ * @param dram The DRAM module.
+ * @return Whether the DRAM is idle in the current cycle.
+ */
+bool dram_idle(DRAM *dram);
+
+/**
+ * Find how many low line address bits select a line within a DRAM row. Lines
+ * whose addresses differ only in these bits share a bank and a row.
+ *
+ * @param dram The DRAM module.
+ * @return The number of bits.
+ */
+unsigned int dram_row_line_bits(DRAM *dram);
+
+/**
+ * Ask the host to prefetch the row buffer state that the given address maps
+ * to.
+ *
+ * @param dram The DRAM module that will be accessed.
+ * @param line_addr The address of the cache line that will be accessed (in
+ *                  units of the cache line size).
+ */
+void dram_prefetch_row(DRAM *dram, uint64_t line_addr);
+
+/**
+ * Restart the clock of the DRAM module at cycle 0, when the simulation
+ * restarts its own, letting every bank finish the requests it holds.
+ *
+ * @param dram The DRAM module whose clock restarts.
+ */
+void dram_reset_clock(DRAM *dram);
+
+/**
+ * Reset the statistics of the DRAM module.
+ *
+ * @param dram The DRAM module to reset the statistics of.
+ */
+void dram_clear_stats(DRAM *dram);
+
+/**
+ * Add the statistics of one DRAM module to those of another.
+ *
+ * @param dst The DRAM module whose statistics are increased.
+ * @param src The DRAM module whose statistics are added.
+ */
+void dram_add_stats(DRAM *dst, const DRAM *src);
+
+/**
+ * Free a DRAM module.
+ *
+ * @param dram The DRAM module to free.
+ */
+void dram_free(DRAM *dram);
+
 /**
  * Print the statistics of the DRAM module.
  * 
@@ -0,0 +1,294 @@
+// energy.cpp
+// Defines the energy model of the caches and DRAM.
+//
+// Each cache access checks the tags of one set. A read hit reads a line, a
+// write hit writes one, every miss and every prefetch fills (writes) a line,
+// and a dirty eviction reads the line it writes back. A zcache relocation
+// reads and writes a line. DRAM pays for each row activation and precharge and for
+// each line transferred. Every structure also leaks (or, for DRAM, draws
+// background power) for the whole run; DRAM ranks draw less of it while in
+// power-down or self-refresh.
+
+#include "energy.h"
+#include <stdio.h>
+#include <cmath>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The clock frequency used to turn cycles into time, in GHz. */
+#define ENERGY_CLOCK_GHZ 2.0
+
+/** The associativity and line size the energy table was made for. */
+#define ENERGY_TABLE_WAYS 8
+#define ENERGY_TABLE_LINESIZE 64
+
+/** The energy of opening (ACT) and closing (PRE) a DRAM row, in nJ. */
+#define DRAM_ACT_ENERGY 1.2
+#define DRAM_PRE_ENERGY 0.8
+
+/** The energy of reading or writing one line from DRAM, in nJ. */
+#define DRAM_READ_ENERGY 1.1
+#define DRAM_WRITE_ENERGY 1.2
+
+/** The background power of DRAM, in mW. */
+#define DRAM_BACKGROUND_POWER 150.0
+
+/** The background power of DRAM in power-down and in self-refresh, in mW. */
+#define DRAM_PD_POWER 60.0
+#define DRAM_SR_POWER 20.0
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The estimated energies of an 8-way cache with 64-byte lines. */
+typedef struct EnergyTableRow
+{
+    unsigned kb;
+
+    /** The energy of reading a line, writing one, and checking tags, in nJ. */
+    double read;
+    double write;
+    double tag;
+
+    /** The leakage power, in mW. */
+    double leakage;
+} EnergyTableRow;
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The current mode under which the simulation is running. */
+extern Mode SIM_MODE;
+
+/** The number of bytes in a cache line. */
+extern uint64_t CACHE_LINESIZE;
+
+/** The number of ranks the DRAM banks are split into. */
+extern unsigned int DRAM_RANKS;
+
+/** Where the per-access energies of the caches come from. */
+extern EnergyModel ENERGY_MODEL;
+
+/** The coefficients of the linear energy model. */
+extern EnergyCoeffs ENERGY_COEFFS;
+
+///////////////////////////////////////////////////////////////////////////////
+//                              GLOBAL VARIABLES                             //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Estimates in the style of CACTI for a 32 nm process. */
+static const EnergyTableRow energy_table[] = {
+    {8, 0.010, 0.011, 0.002, 2.0},
+    {16, 0.014, 0.015, 0.003, 4.0},
+    {32, 0.020, 0.022, 0.004, 8.0},
+    {64, 0.030, 0.033, 0.005, 15.0},
+    {128, 0.045, 0.050, 0.007, 28.0},
+    {256, 0.070, 0.078, 0.009, 55.0},
+    {512, 0.110, 0.122, 0.012, 105.0},
+    {1024, 0.170, 0.190, 0.016, 200.0},
+    {2048, 0.260, 0.290, 0.021, 390.0},
+    {4096, 0.400, 0.450, 0.028, 760.0},
+    {8192, 0.620, 0.700, 0.037, 1500.0},
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Interpolate between two table entries geometrically in the capacity, which
+ * also extrapolates beyond either end of the table.
+ */
+static double table_lookup(double a, double b, double t)
+{
+    return a * std::pow(b / a, t);
+}
+
+/**
+ * Find the per-access energies and the leakage power of a cache from its
+ * capacity and associativity, using ENERGY_MODEL.
+ *
+ * @param c The cache.
+ * @param e Receives the energies.
+ */
+void energy_cache_params(const Cache *c, CacheEnergy *e)
+{
+    double kb = (double)c->sets * c->ways * CACHE_LINESIZE / 1024.0;
+
+    if (ENERGY_MODEL == ENERGY_LINEAR)
+    {
+        e->read = (ENERGY_COEFFS.read_per_kb * kb +
+                   ENERGY_COEFFS.read_per_way * c->ways) / 1000.0;
+        e->write = (ENERGY_COEFFS.write_per_kb * kb +
+                    ENERGY_COEFFS.write_per_way * c->ways) / 1000.0;
+        e->tag = ENERGY_COEFFS.tag_per_way * c->ways / 1000.0;
+        e->leakage = ENERGY_COEFFS.leak_per_kb * kb;
+        return;
+    }
+
+    unsigned rows = sizeof(energy_table) / sizeof(energy_table[0]);
+    unsigned i = 0;
+    while (i + 2 < rows && kb > energy_table[i + 1].kb)
+    {
+        i++;
+    }
+    const EnergyTableRow *lo = &energy_table[i];
+    const EnergyTableRow *hi = &energy_table[i + 1];
+    double t = std::log2(kb / lo->kb) / std::log2((double)hi->kb / lo->kb);
+
+    // Wider sets lengthen the data multiplexers a little and add one
+    // comparator per way; longer lines are read and written in proportion.
+    double way_scale = 1.0 + ((double)c->ways - ENERGY_TABLE_WAYS) /
+                                 (4.0 * ENERGY_TABLE_WAYS);
+    double line_scale = (double)CACHE_LINESIZE / ENERGY_TABLE_LINESIZE;
+    e->read = table_lookup(lo->read, hi->read, t) * way_scale * line_scale;
+    e->write = table_lookup(lo->write, hi->write, t) * way_scale *
+               line_scale;
+    e->tag = table_lookup(lo->tag, hi->tag, t) * c->ways / ENERGY_TABLE_WAYS;
+    e->leakage = table_lookup(lo->leakage, hi->leakage, t);
+}
+
+/**
+ * Convert a power in mW drawn over the given number of cycles to nJ.
+ */
+static double leakage_energy(double power, uint64_t cycles)
+{
+    return power * (double)cycles / (ENERGY_CLOCK_GHZ * 1000.0);
+}
+
+static double per_inst(double energy, unsigned long long insts)
+{
+    return insts ? energy / (double)insts : 0.0;
+}
+
+/**
+ * Print the energy of one cache.
+ *
+ * @return The total energy of the cache, in nJ.
+ */
+static double cache_energy(const Cache *c, const char *header,
+                           uint64_t cycles, unsigned long long insts)
+{
+    CacheEnergy e;
+    energy_cache_params(c, &e);
+
+    unsigned long long misses = c->stat_read_miss + c->stat_write_miss;
+    unsigned long long tags = c->stat_read_access + c->stat_write_access;
+    unsigned long long reads = c->stat_read_access - c->stat_read_miss +
+                               c->stat_dirty_evicts + c->stat_relocations;
+    unsigned long long writes = c->stat_write_access - c->stat_write_miss +
+                                misses + c->stat_pf_fills +
+                                c->stat_relocations;
+
+    double dynamic = tags * e.tag + reads * e.read + writes * e.write;
+    double leakage = leakage_energy(e.leakage, cycles);
+
+    printf("\n");
+    printf("%s_DYN_ENERGY_NJ   \t\t : %10.3f\n", header, dynamic);
+    printf("%s_LEAK_ENERGY_NJ  \t\t : %10.3f\n", header, leakage);
+    printf("%s_NJ_PER_INST     \t\t : %10.3f\n", header,
+           per_inst(dynamic + leakage, insts));
+    return dynamic + leakage;
+}
+
+/**
+ * Print the energy of the DRAM.
+ *
+ * @return The total energy of the DRAM, in nJ.
+ */
+static double dram_energy(const DRAM *d, uint64_t cycles,
+                          unsigned long long insts)
+{
+    double dynamic = d->stat_activates * DRAM_ACT_ENERGY +
+                     d->stat_precharges * DRAM_PRE_ENERGY +
+                     d->stat_read_access * DRAM_READ_ENERGY +
+                     d->stat_write_access * DRAM_WRITE_ENERGY;
+    double background = leakage_energy(DRAM_BACKGROUND_POWER, cycles);
+
+    // Each rank draws its share of the background power, less of it for the
+    // cycles it spent in a low-power state.
+    double pd_perc = 0.0;
+    double sr_perc = 0.0;
+    if (d->lp && cycles)
+    {
+        uint64_t pd = d->stat_pd_cycles;
+        uint64_t sr = d->stat_sr_cycles;
+        background -= leakage_energy((DRAM_BACKGROUND_POWER - DRAM_PD_POWER) /
+                                         DRAM_RANKS, pd);
+        background -= leakage_energy((DRAM_BACKGROUND_POWER - DRAM_SR_POWER) /
+                                         DRAM_RANKS, sr);
+        pd_perc = 100.0 * (double)pd / ((double)cycles * DRAM_RANKS);
+        sr_perc = 100.0 * (double)sr / ((double)cycles * DRAM_RANKS);
+    }
+
+    printf("\n");
+    printf("DRAM_ACTIVATES       \t\t : %10llu\n", d->stat_activates);
+    printf("DRAM_PRECHARGES      \t\t : %10llu\n", d->stat_precharges);
+    if (d->lp)
+    {
+        printf("DRAM_PD_RESIDENCY_PERC\t\t : %10.3f\n", pd_perc);
+        printf("DRAM_SR_RESIDENCY_PERC\t\t : %10.3f\n", sr_perc);
+    }
+    printf("DRAM_DYN_ENERGY_NJ   \t\t : %10.3f\n", dynamic);
+    printf("DRAM_BG_ENERGY_NJ    \t\t : %10.3f\n", background);
+    printf("DRAM_NJ_PER_INST     \t\t : %10.3f\n",
+           per_inst(dynamic + background, insts));
+    return dynamic + background;
+}
+
+/**
+ * Print the dynamic and leakage energy of every cache and of DRAM, and the
+ * energy per instruction of each level and of the whole memory system.
+ *
+ * @param sys The memory system.
+ * @param cycles The number of cycles simulated, over which power leaks.
+ * @param insts The number of instructions executed by all cores.
+ */
+void energy_print_stats(MemorySystem *sys, uint64_t cycles,
+                        unsigned long long insts)
+{
+    double l1 = 0.0;
+    double l2 = 0.0;
+    double dram = 0.0;
+
+    if (SIM_MODE == SIM_MODE_A)
+    {
+        l1 += cache_energy(sys->dcache, "DCACHE", cycles, insts);
+    }
+    else if (SIM_MODE == SIM_MODE_DEF)
+    {
+        l1 += cache_energy(sys->icache_coreid[0], "ICACHE_0", cycles, insts);
+        l1 += cache_energy(sys->dcache_coreid[0], "DCACHE_0", cycles, insts);
+        l1 += cache_energy(sys->icache_coreid[1], "ICACHE_1", cycles, insts);
+        l1 += cache_energy(sys->dcache_coreid[1], "DCACHE_1", cycles, insts);
+    }
+    else
+    {
+        l1 += cache_energy(sys->icache, "ICACHE", cycles, insts);
+        l1 += cache_energy(sys->dcache, "DCACHE", cycles, insts);
+    }
+
+    if (sys->l2cache)
+    {
+        l2 = cache_energy(sys->l2cache, "L2CACHE", cycles, insts);
+    }
+    if (sys->dram)
+    {
+        dram = dram_energy(sys->dram, cycles, insts);
+    }
+
+    double total = l1 + l2 + dram;
+    double seconds = (double)cycles / (ENERGY_CLOCK_GHZ * 1e9);
+
+    printf("\n");
+    printf("ENERGY_L1_NJ_PER_INST\t\t : %10.3f\n", per_inst(l1, insts));
+    printf("ENERGY_L2_NJ_PER_INST\t\t : %10.3f\n", per_inst(l2, insts));
+    printf("ENERGY_TOTAL_NJ      \t\t : %10.3f\n", total);
+    printf("ENERGY_NJ_PER_INST   \t\t : %10.3f\n", per_inst(total, insts));
+    printf("ENERGY_AVG_POWER_MW  \t\t : %10.3f\n",
+           seconds > 0.0 ? total * 1e-6 / seconds : 0.0);
+}
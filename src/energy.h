@@ -0,0 +1,78 @@
+// energy.h
+// Declares the energy model of the caches and DRAM.
+
+#ifndef __ENERGY_H__
+#define __ENERGY_H__
+
+#include "types.h"
+#include "memsys.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Possible sources of the per-access energies of a cache. */
+typedef enum EnergyModelEnum
+{
+    ENERGY_OFF = 0,    // Do not report energy.
+    ENERGY_TABLE = 1,  // Interpolate a table of CACTI-like estimates.
+    ENERGY_LINEAR = 2, // Scale the coefficients of ENERGY_COEFFS.
+} EnergyModel;
+
+/**
+ * The coefficients of the linear energy model. Each energy is the sum of a
+ * part proportional to the capacity and one proportional to the number of
+ * ways.
+ */
+typedef struct EnergyCoeffs
+{
+    /** The energy of reading or writing a line, in pJ per KB and per way. */
+    double read_per_kb;
+    double read_per_way;
+    double write_per_kb;
+    double write_per_way;
+
+    /** The energy of checking the tags of a set, in pJ per way. */
+    double tag_per_way;
+
+    /** The leakage power, in mW per KB. */
+    double leak_per_kb;
+} EnergyCoeffs;
+
+/** The energies of one access to a cache, and its leakage power. */
+typedef struct CacheEnergy
+{
+    /** In nJ. */
+    double read;
+    double write;
+    double tag;
+
+    /** In mW. */
+    double leakage;
+} CacheEnergy;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Find the per-access energies and the leakage power of a cache from its
+ * capacity and associativity, using ENERGY_MODEL.
+ *
+ * @param c The cache.
+ * @param e Receives the energies.
+ */
+void energy_cache_params(const Cache *c, CacheEnergy *e);
+
+/**
+ * Print the dynamic and leakage energy of every cache and of DRAM, and the
+ * energy per instruction of each level and of the whole memory system.
+ *
+ * @param sys The memory system.
+ * @param cycles The number of cycles simulated, over which power leaks.
+ * @param insts The number of instructions executed by all cores.
+ */
+void energy_print_stats(MemorySystem *sys, uint64_t cycles,
+                        unsigned long long insts);
+
+#endif // __ENERGY_H__
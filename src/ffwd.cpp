@@ -0,0 +1,592 @@
+// ffwd.cpp
+// Defines the detection and fast-forwarding of steady-state loops.
+
+#include "ffwd.h"
+#include "core.h"
+#include "hawkeye.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * How far apart, in percent, the statistics of two windows may be for the
+ * loop to count as steady.
+ */
+#define FFWD_TOLERANCE_PERC 2
+
+/** The number of windows skipped between two windows checked in detail. */
+#define FFWD_CHECK_INTERVAL 16
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The current clock cycle number. */
+extern thread_local uint64_t current_cycle;
+
+/** The number of loop iterations in a fast-forward window. */
+extern unsigned int FFWD_WINDOW;
+
+/** The number of cores being simulated. */
+extern unsigned int NUM_CORES;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           STATISTICS COUNTERS                             //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Copies each counter visited into an array. */
+struct CounterRead
+{
+    uint64_t *out;
+    unsigned int n;
+    template <typename T> void operator()(T &v) { out[n++] = v; }
+};
+
+/** Overwrites each counter visited from an array. */
+struct CounterWrite
+{
+    const uint64_t *in;
+    unsigned int n;
+    template <typename T> void operator()(T &v) { v = in[n++]; }
+};
+
+/** Adds an array to the counters visited. */
+struct CounterAdd
+{
+    const uint64_t *in;
+    unsigned int n;
+    template <typename T> void operator()(T &v) { v += in[n++]; }
+};
+
+template <typename F> static void visit_cache(Cache *c, F &f)
+{
+    if (c == NULL)
+    {
+        return;
+    }
+    f(c->stat_read_access);
+    f(c->stat_read_miss);
+    f(c->stat_write_access);
+    f(c->stat_write_miss);
+    f(c->stat_dirty_evicts);
+    f(c->stat_relocations);
+    f(c->stat_pf_fills);
+    f(c->stat_pf_useful);
+    f(c->stat_pf_unused);
+    if (c->hawkeye)
+    {
+        f(c->hawkeye->stat_friendly);
+        f(c->hawkeye->stat_predictions);
+        f(c->hawkeye->stat_optgen_hits);
+        f(c->hawkeye->stat_optgen_accesses);
+    }
+}
+
+template <typename F> static void visit_dram(DRAM *d, F &f)
+{
+    f(d->stat_read_access);
+    f(d->stat_read_delay);
+    f(d->stat_write_access);
+    f(d->stat_write_delay);
+    f(d->stat_row_hits);
+    f(d->stat_queue_delay);
+    f(d->stat_model_intervals);
+    f(d->stat_activates);
+    f(d->stat_precharges);
+    f(d->stat_sa_conflicts);
+    f(d->stat_sa_same_conflicts);
+    f(d->stat_pd_entries);
+    f(d->stat_sr_entries);
+    f(d->stat_pd_cycles);
+    f(d->stat_sr_cycles);
+    f(d->stat_lp_delay);
+    for (unsigned int i = 0; d->rbc && i < (1u << d->bank_bits); i++)
+    {
+        f(d->stat_rbc_access[i]);
+        f(d->stat_rbc_hits[i]);
+    }
+    if (d->rh)
+    {
+        f(d->rh->stat_acts);
+        f(d->rh->stat_over_threshold);
+        f(d->rh->stat_refreshes);
+        f(d->rh->stat_throttled);
+        f(d->rh->stat_delay);
+    }
+    if (d->sched)
+    {
+        for (unsigned int c = 0; c < NUM_CORES; c++)
+        {
+            f(d->sched->stat_reads[c]);
+            f(d->sched->stat_read_cycles[c]);
+            f(d->sched->stat_interference[c]);
+        }
+        f(d->sched->stat_reordered);
+        f(d->sched->stat_batches);
+    }
+}
+
+/**
+ * Visit every statistics counter of a core and its memory system, always in
+ * the same order.
+ */
+template <typename F> static void visit_counters(Core *core, F &f)
+{
+    MemorySystem *sys = core->memsys;
+    f(core->stat_long_misses);
+    f(core->stat_overlapped_misses);
+    f(core->stat_short_misses);
+
+    f(sys->stat_ifetch_access);
+    f(sys->stat_load_access);
+    f(sys->stat_store_access);
+    f(sys->stat_ifetch_delay);
+    f(sys->stat_load_delay);
+    f(sys->stat_store_delay);
+    f(sys->stat_pin_access);
+    f(sys->stat_pin_hits);
+    f(sys->stat_wb_eager);
+    f(sys->stat_wb_row);
+
+    visit_cache(sys->dcache, f);
+    visit_cache(sys->icache, f);
+    for (unsigned int i = 0; i < MAX_CORES; i++)
+    {
+        visit_cache(sys->dcache_coreid[i], f);
+        visit_cache(sys->icache_coreid[i], f);
+    }
+    visit_cache(sys->l2cache, f);
+
+    if (sys->dram)
+    {
+        visit_dram(sys->dram, f);
+    }
+    if (sys->nuca)
+    {
+        for (unsigned int c = 0; c < NUM_CORES; c++)
+        {
+            f(sys->nuca->stat_hops[c]);
+            f(sys->nuca->stat_requests[c]);
+        }
+        f(sys->nuca->stat_migrations);
+    }
+    if (sys->l2pf)
+    {
+        f(sys->l2pf->stat_trains);
+        f(sys->l2pf->stat_candidates);
+        f(sys->l2pf->stat_meta_reads);
+        f(sys->l2pf->stat_meta_writes);
+    }
+    for (unsigned int i = 0; i < MAX_CORES; i++)
+    {
+        if (sys->ipf[i])
+        {
+            f(sys->ipf[i]->stat_issued);
+            f(sys->ipf[i]->stat_dropped);
+            f(sys->ipf[i]->stat_l2_misses);
+            f(sys->ipf[i]->stat_timely);
+            f(sys->ipf[i]->stat_late);
+            f(sys->ipf[i]->stat_late_cycles);
+        }
+    }
+}
+
+/**
+ * Read the current cycle and every counter of the memory system.
+ *
+ * @return The number of values read.
+ */
+static unsigned int read_counters(Core *core, uint64_t *out)
+{
+    CounterRead r = {out, 1};
+    out[0] = current_cycle;
+    visit_counters(core, r);
+    return r.n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a loop detector.
+ *
+ * @return A pointer to the loop detector.
+ */
+LoopDetector *ffwd_new()
+{
+    return (LoopDetector *)calloc(1, sizeof(LoopDetector));
+}
+
+static bool is_mem_op(const TraceRecord *rec)
+{
+    return rec->inst_type == INST_TYPE_LOAD ||
+           rec->inst_type == INST_TYPE_STORE;
+}
+
+/**
+ * Forget the current loop and start tracking the one headed at pc.
+ */
+static void start_loop(LoopDetector *ld, Core *core, uint64_t pc)
+{
+    ld->head_pc = pc;
+    ld->cur_len = 0;
+    ld->last_len = 0;
+    ld->stable_iters = 0;
+    ld->checking = false;
+    ld->windows_since_check = 0;
+    read_counters(core, ld->iter_start);
+}
+
+/**
+ * Whether a record is instruction j of the i-th iteration after the last one.
+ */
+static bool record_matches(LoopDetector *ld, const TraceRecord *rec,
+                           unsigned int i, unsigned int j)
+{
+    const TraceRecord *expect = &ld->last[j];
+    if (rec->inst_addr != expect->inst_addr ||
+        rec->inst_type != expect->inst_type)
+    {
+        return false;
+    }
+    return !is_mem_op(rec) ||
+           rec->ldst_addr == (uint32_t)(expect->ldst_addr + i * ld->stride[j]);
+}
+
+/**
+ * Run the accesses of the last skipped window through the memory system
+ * without counting them, so the caches hold the lines the loop just touched.
+ */
+static void warm_last_window(Core *core)
+{
+    LoopDetector *ld = core->ffwd;
+    uint64_t saved[FFWD_MAX_COUNTERS];
+    read_counters(core, saved);
+
+    for (unsigned int i = 0; i < FFWD_WINDOW; i++)
+    {
+        int64_t back = FFWD_WINDOW - 1 - i;
+        for (unsigned int j = 0; j < ld->last_len; j++)
+        {
+            const TraceRecord *rec = &ld->last[j];
+            memsys_access(core->memsys, rec->inst_addr, ACCESS_TYPE_IFETCH,
+                          core->core_id, rec->inst_addr);
+            if (is_mem_op(rec))
+            {
+                uint32_t addr = rec->ldst_addr - back * ld->stride[j];
+                memsys_access(core->memsys, addr,
+                              (rec->inst_type == INST_TYPE_LOAD)
+                                  ? ACCESS_TYPE_LOAD
+                                  : ACCESS_TYPE_STORE,
+                              core->core_id, rec->inst_addr);
+            }
+        }
+    }
+
+    CounterWrite w = {saved, 1};
+    visit_counters(core, w);
+}
+
+/**
+ * Skip as many windows as the trace and the check interval allow, starting at
+ * the head instruction the core holds.
+ *
+ * @return Whether any window was skipped.
+ */
+static bool try_skip(Core *core)
+{
+    LoopDetector *ld = core->ffwd;
+    unsigned int len = ld->last_len;
+
+    // Replayed records would need to be requeued on a mismatch.
+    if (ld->replay_pos != ld->replay_len)
+    {
+        return false;
+    }
+
+    unsigned int skipped = 0;
+    uint64_t skipped_cycles = 0;
+    while (ld->windows_since_check < FFWD_CHECK_INTERVAL)
+    {
+        TraceRecord rec;
+        rec.inst_addr = core->trace_inst_addr;
+        rec.inst_type = core->trace_inst_type;
+        rec.ldst_addr = core->trace_ldst_addr;
+
+        // Read the window and the instruction after it, checking each one
+        // against the addresses the strides predict.
+        bool match = true;
+        ld->pending_len = 0;
+        for (unsigned int k = 0; k <= FFWD_WINDOW * len; k++)
+        {
+            if (k > 0 && !core_next_record(core, &rec))
+            {
+                match = false;
+                break;
+            }
+            ld->pending[ld->pending_len++] = rec;
+            if (k < FFWD_WINDOW * len &&
+                !record_matches(ld, &rec, k / len + 1, k % len))
+            {
+                match = false;
+                break;
+            }
+        }
+
+        if (!match)
+        {
+            const TraceRecord *head = &ld->pending[0];
+            core->trace_inst_addr = head->inst_addr;
+            core->trace_inst_type = head->inst_type;
+            core->trace_ldst_addr = head->ldst_addr;
+            memcpy(ld->replay, ld->pending + 1,
+                   (ld->pending_len - 1) * sizeof(TraceRecord));
+            ld->replay_len = ld->pending_len - 1;
+            ld->replay_pos = 0;
+            break;
+        }
+
+        CounterAdd add = {ld->window_delta, 1};
+        visit_counters(core, add);
+        core->inst_count += FFWD_WINDOW * len;
+        skipped_cycles += ld->window_delta[0];
+        for (unsigned int j = 0; j < len; j++)
+        {
+            ld->last[j].ldst_addr += FFWD_WINDOW * ld->stride[j];
+        }
+
+        core->trace_inst_addr = rec.inst_addr;
+        core->trace_inst_type = rec.inst_type;
+        core->trace_ldst_addr = rec.ldst_addr;
+
+        skipped++;
+        ld->windows_since_check++;
+        ld->stat_windows_skipped++;
+        ld->stat_insts_skipped += FFWD_WINDOW * len;
+    }
+
+    if (skipped == 0)
+    {
+        return false;
+    }
+
+    warm_last_window(core);
+
+    // The instruction after the skipped windows starts a new iteration once
+    // the skipped cycles have passed.
+    core->snooze_end_cycle = current_cycle + skipped_cycles - 1;
+    read_counters(core, ld->iter_start);
+    ld->iter_start[0] = current_cycle + skipped_cycles;
+    ld->prev_pc = 0;
+    return true;
+}
+
+/**
+ * Close the iteration that just ended, and decide whether to skip ahead.
+ *
+ * @return Whether a window was skipped.
+ */
+static bool end_iteration(Core *core)
+{
+    LoopDetector *ld = core->ffwd;
+    unsigned int window = FFWD_WINDOW;
+
+    uint64_t now[FFWD_MAX_COUNTERS];
+    unsigned int n = read_counters(core, now);
+    uint64_t *delta = ld->iter_delta[ld->iter_delta_head];
+    ld->iter_delta_head = (ld->iter_delta_head + 1) % (2 * window);
+    for (unsigned int k = 0; k < n; k++)
+    {
+        delta[k] = now[k] - ld->iter_start[k];
+    }
+    memcpy(ld->iter_start, now, sizeof(now));
+
+    // Compare the instructions and strides with the previous iteration.
+    bool same = ld->last_len == ld->cur_len;
+    for (unsigned int j = 0; same && j < ld->cur_len; j++)
+    {
+        same = ld->cur[j].inst_addr == ld->last[j].inst_addr &&
+               ld->cur[j].inst_type == ld->last[j].inst_type;
+    }
+    if (same)
+    {
+        bool same_stride = ld->stable_iters > 0;
+        for (unsigned int j = 0; j < ld->cur_len; j++)
+        {
+            int64_t stride = 0;
+            if (is_mem_op(&ld->cur[j]))
+            {
+                stride = (int64_t)ld->cur[j].ldst_addr -
+                         (int64_t)ld->last[j].ldst_addr;
+            }
+            same_stride = same_stride && stride == ld->stride[j];
+            ld->stride[j] = stride;
+        }
+        ld->stable_iters = same_stride ? ld->stable_iters + 1 : 1;
+    }
+    else
+    {
+        ld->stable_iters = 0;
+        ld->checking = false;
+    }
+
+    memcpy(ld->last, ld->cur, ld->cur_len * sizeof(TraceRecord));
+    ld->last_len = ld->cur_len;
+    ld->cur_len = 0;
+
+    if (ld->checking && ++ld->check_iters == window)
+    {
+        // Compare the detailed window with the extrapolated one.
+        uint64_t actual = now[0] - ld->check_start[0];
+        uint64_t predicted = ld->window_delta[0];
+        uint64_t error = actual > predicted ? actual - predicted
+                                            : predicted - actual;
+        ld->stat_check_cycles += actual;
+        ld->stat_check_error += error;
+        ld->checking = false;
+        ld->windows_since_check = 0;
+        if (error * 100 > FFWD_TOLERANCE_PERC * actual)
+        {
+            ld->stable_iters = 0;
+        }
+    }
+
+    if (ld->checking || ld->stable_iters <= 2 * window)
+    {
+        return false;
+    }
+
+    // The loop is steady if the last two windows agree on every counter.
+    uint64_t newer[FFWD_MAX_COUNTERS] = {0};
+    uint64_t older[FFWD_MAX_COUNTERS] = {0};
+    for (unsigned int i = 0; i < window; i++)
+    {
+        const uint64_t *d_new = ld->iter_delta[(ld->iter_delta_head +
+                                                2 * window - 1 - i) %
+                                               (2 * window)];
+        const uint64_t *d_old = ld->iter_delta[(ld->iter_delta_head +
+                                                window - 1 - i) %
+                                               (2 * window)];
+        for (unsigned int k = 0; k < n; k++)
+        {
+            newer[k] += d_new[k];
+            older[k] += d_old[k];
+        }
+    }
+    for (unsigned int k = 0; k < n; k++)
+    {
+        uint64_t diff = newer[k] > older[k] ? newer[k] - older[k]
+                                            : older[k] - newer[k];
+        uint64_t larger = newer[k] > older[k] ? newer[k] : older[k];
+        if (diff * 100 > FFWD_TOLERANCE_PERC * larger)
+        {
+            return false;
+        }
+    }
+    memcpy(ld->window_delta, newer, sizeof(newer));
+
+    if (ld->windows_since_check >= FFWD_CHECK_INTERVAL)
+    {
+        ld->checking = true;
+        ld->check_iters = 0;
+        memcpy(ld->check_start, now, sizeof(now));
+        ld->stat_checks++;
+        return false;
+    }
+
+    return try_skip(core);
+}
+
+/**
+ * Observe the instruction the core is about to execute, and skip a window of
+ * loop iterations if the loop has reached a steady state.
+ *
+ * @param core The core, which must have an instruction to execute.
+ * @return Whether a window was skipped. If so, the core now holds the first
+ *         instruction after it and is snoozing for the cycles it would take.
+ */
+bool ffwd_step(Core *core)
+{
+    LoopDetector *ld = core->ffwd;
+    uint64_t pc = core->trace_inst_addr;
+
+    if (pc < ld->prev_pc)
+    {
+        if (pc == ld->head_pc && ld->cur_len > 0)
+        {
+            if (end_iteration(core))
+            {
+                return true;
+            }
+
+            // A window that was about to be skipped may have been requeued.
+            pc = core->trace_inst_addr;
+        }
+        else
+        {
+            start_loop(ld, core, pc);
+        }
+    }
+
+    if (ld->cur_len < FFWD_MAX_BODY)
+    {
+        TraceRecord *rec = &ld->cur[ld->cur_len++];
+        rec->inst_addr = core->trace_inst_addr;
+        rec->inst_type = core->trace_inst_type;
+        rec->ldst_addr = core->trace_ldst_addr;
+    }
+    else
+    {
+        // Too long to be fast-forwarded; wait for the next backward jump.
+        ld->head_pc = UINT64_MAX;
+    }
+
+    ld->prev_pc = pc;
+    return false;
+}
+
+/**
+ * Take the next record queued for replay, if any.
+ *
+ * @param ld The loop detector.
+ * @param rec Receives the record.
+ * @return Whether a record was available.
+ */
+bool ffwd_replay_pop(LoopDetector *ld, TraceRecord *rec)
+{
+    if (ld->replay_pos == ld->replay_len)
+    {
+        return false;
+    }
+    *rec = ld->replay[ld->replay_pos++];
+    return true;
+}
+
+/**
+ * Print the fast-forwarding statistics of a core.
+ *
+ * @param ld The loop detector of the core.
+ * @param core_id The CPU core ID, used as a prefix for each statistic.
+ */
+void ffwd_print_stats(LoopDetector *ld, unsigned int core_id)
+{
+    double error_perc = 0.0;
+    if (ld->stat_check_cycles)
+    {
+        error_perc = 100.0 * (double)(ld->stat_check_error) /
+                     (double)(ld->stat_check_cycles);
+    }
+
+    printf("CORE_%01d_FFWD_WINDOWS \t\t : %10llu\n", core_id,
+           ld->stat_windows_skipped);
+    printf("CORE_%01d_FFWD_INSTS   \t\t : %10llu\n", core_id,
+           ld->stat_insts_skipped);
+    printf("CORE_%01d_FFWD_CHECKS  \t\t : %10llu\n", core_id,
+           ld->stat_checks);
+    printf("CORE_%01d_FFWD_ERR_PERC\t\t : %10.3f\n", core_id, error_perc);
+}
@@ -0,0 +1,124 @@
+// ffwd.h
+// Declares the detection and fast-forwarding of steady-state loops.
+
+#ifndef __FFWD_H__
+#define __FFWD_H__
+
+#include "types.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The longest loop body, in instructions, that can be fast-forwarded. */
+#define FFWD_MAX_BODY 256
+
+/** The largest number of iterations in a fast-forward window. */
+#define FFWD_MAX_WINDOW 16
+
+/** The largest number of statistics counters extrapolated, plus cycles. */
+#define FFWD_MAX_COUNTERS 160
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+struct Core;
+
+/**
+ * Tracks the innermost loop a core is executing.
+ *
+ * An iteration starts each time a backward jump lands on the loop head. Once
+ * consecutive iterations repeat the same instructions with constant address
+ * strides, and the statistics of two consecutive windows of iterations agree,
+ * later windows are checked against the predicted addresses and skipped,
+ * adding the statistics of one window instead of simulating it.
+ */
+typedef struct LoopDetector
+{
+    uint64_t head_pc;
+    uint64_t prev_pc;
+
+    /** The iteration being executed. */
+    TraceRecord cur[FFWD_MAX_BODY];
+    unsigned int cur_len;
+
+    /** The last complete iteration, and the address strides it followed. */
+    TraceRecord last[FFWD_MAX_BODY];
+    unsigned int last_len;
+    int64_t stride[FFWD_MAX_BODY];
+
+    /** The number of consecutive iterations with the same strides. */
+    unsigned int stable_iters;
+
+    /** The counters when the current iteration started. Index 0 is cycles. */
+    uint64_t iter_start[FFWD_MAX_COUNTERS];
+
+    /** The counter deltas of the last two windows of iterations, as a ring. */
+    uint64_t iter_delta[2 * FFWD_MAX_WINDOW][FFWD_MAX_COUNTERS];
+    unsigned int iter_delta_head;
+
+    /** The counter deltas added for each skipped window. */
+    uint64_t window_delta[FFWD_MAX_COUNTERS];
+
+    /** Whether a window is being simulated in detail to measure the error. */
+    bool checking;
+    unsigned int check_iters;
+    uint64_t check_start[FFWD_MAX_COUNTERS];
+    unsigned int windows_since_check;
+
+    /** The records read while verifying a window, replayed on a mismatch. */
+    TraceRecord pending[FFWD_MAX_WINDOW * FFWD_MAX_BODY + 1];
+    unsigned int pending_len;
+
+    /** Records to execute before reading further from the trace. */
+    TraceRecord replay[FFWD_MAX_WINDOW * FFWD_MAX_BODY + 1];
+    unsigned int replay_len;
+    unsigned int replay_pos;
+
+    unsigned long long stat_windows_skipped;
+    unsigned long long stat_insts_skipped;
+    unsigned long long stat_checks;
+    uint64_t stat_check_cycles;
+    uint64_t stat_check_error;
+} LoopDetector;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a loop detector.
+ *
+ * @return A pointer to the loop detector.
+ */
+LoopDetector *ffwd_new();
+
+/**
+ * Observe the instruction the core is about to execute, and skip a window of
+ * loop iterations if the loop has reached a steady state.
+ *
+ * @param core The core, which must have an instruction to execute.
+ * @return Whether a window was skipped. If so, the core now holds the first
+ *         instruction after it and is snoozing for the cycles it would take.
+ */
+bool ffwd_step(struct Core *core);
+
+/**
+ * Take the next record queued for replay, if any.
+ *
+ * @param ld The loop detector.
+ * @param rec Receives the record.
+ * @return Whether a record was available.
+ */
+bool ffwd_replay_pop(LoopDetector *ld, TraceRecord *rec);
+
+/**
+ * Print the fast-forwarding statistics of a core.
+ *
+ * @param ld The loop detector of the core.
+ * @param core_id The CPU core ID, used as a prefix for each statistic.
+ */
+void ffwd_print_stats(LoopDetector *ld, unsigned int core_id);
+
+#endif // __FFWD_H__
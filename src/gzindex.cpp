@@ -0,0 +1,556 @@
+// gzindex.cpp
+// Defines the access point index of a gzip-compressed trace, which lets a
+// trace be decoded from the middle, and in several segments at once, without
+// changing its format.
+//
+// Indexing inflates the trace once, block by block, and records an access
+// point at the first deflate block boundary after every GZINDEX_SPAN decoded
+// bytes: where the block starts in both streams, the bits of its first byte
+// that belong to the previous block, and the last 32 KB decoded before it,
+// which later blocks may refer back to. Decoding from a point primes a raw
+// inflate with those bits and uses the window as its dictionary. The points
+// are saved next to the trace, with its size and modification time, and
+// rebuilt when the trace changes.
+
+#include "gzindex.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The decoded bytes between access points. */
+#define GZINDEX_SPAN (4ULL << 20)
+
+/** Marks a sidecar index file ("CMPIDX01"). */
+#define GZINDEX_MAGIC 0x3130584449504d43ULL
+
+/** The most bytes inflated in one call, which zlib counts in 32 bits. */
+#define GZINDEX_MAX_CHUNK (1U << 30)
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The header of a sidecar index file, followed by the access points. */
+typedef struct GzIndexHeader
+{
+    uint64_t magic;
+
+    /** The size and modification time of the trace when it was indexed. */
+    uint64_t trace_size;
+    int64_t trace_mtime;
+
+    uint64_t total_out;
+    uint64_t num_points;
+} GzIndexHeader;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Record an access point, given the circular window being decoded into and
+ * how much of it is still free.
+ */
+static void gzindex_add_point(GzIndex *idx, uint64_t *capacity,
+                              unsigned int bits, uint64_t in, uint64_t out,
+                              unsigned int left, const uint8_t *window)
+{
+    if (idx->num_points == *capacity)
+    {
+        *capacity = *capacity ? *capacity * 2 : 16;
+        idx->points = (GzAccessPoint *)realloc(idx->points,
+                                               *capacity *
+                                                   sizeof(GzAccessPoint));
+    }
+
+    GzAccessPoint *point = &idx->points[idx->num_points++];
+    point->out = out;
+    point->in = in;
+    point->bits = bits;
+    if (left)
+    {
+        memcpy(point->window, window + GZINDEX_WINDOW - left, left);
+    }
+    if (left < GZINDEX_WINDOW)
+    {
+        memcpy(point->window + left, window, GZINDEX_WINDOW - left);
+    }
+}
+
+/**
+ * Inflate a whole trace, recording an access point every GZINDEX_SPAN
+ * decoded bytes.
+ */
+static GzIndex *gzindex_build(const char *trace_filename)
+{
+    FILE *file = fopen(trace_filename, "rb");
+    if (file == NULL)
+    {
+        perror("Couldn't open trace file");
+        return NULL;
+    }
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, 47) != Z_OK)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    GzIndex *idx = (GzIndex *)calloc(1, sizeof(GzIndex));
+    uint64_t capacity = 0;
+    uint8_t *in_buf = (uint8_t *)malloc(64 * 1024);
+    uint8_t *window = (uint8_t *)calloc(GZINDEX_WINDOW, 1);
+    uint64_t total_in = 0;
+    uint64_t total_out = 0;
+    uint64_t last = 0;
+    int ret = Z_OK;
+
+    // Decode into the window, which wraps around, and count where each
+    // block starts in both streams.
+    while (ret != Z_STREAM_END)
+    {
+        strm.avail_in = fread(in_buf, 1, 64 * 1024, file);
+        if (strm.avail_in == 0)
+        {
+            ret = Z_DATA_ERROR;
+            break;
+        }
+        strm.next_in = in_buf;
+
+        do
+        {
+            if (strm.avail_out == 0)
+            {
+                strm.avail_out = GZINDEX_WINDOW;
+                strm.next_out = window;
+            }
+            total_in += strm.avail_in;
+            total_out += strm.avail_out;
+            ret = inflate(&strm, Z_BLOCK);
+            total_in -= strm.avail_in;
+            total_out -= strm.avail_out;
+            if (ret != Z_OK && ret != Z_STREAM_END)
+            {
+                ret = Z_DATA_ERROR;
+                break;
+            }
+            if (ret == Z_STREAM_END)
+            {
+                break;
+            }
+
+            // At the end of a block header that is not the last block.
+            if ((strm.data_type & 128) && !(strm.data_type & 64) &&
+                (total_out == 0 || total_out - last > GZINDEX_SPAN))
+            {
+                gzindex_add_point(idx, &capacity, strm.data_type & 7,
+                                  total_in, total_out, strm.avail_out,
+                                  window);
+                last = total_out;
+            }
+        } while (strm.avail_in != 0);
+
+        if (ret == Z_DATA_ERROR)
+        {
+            break;
+        }
+    }
+
+    // A second gzip member would start a new stream, which the raw inflate
+    // of an access point cannot cross.
+    if (ret == Z_STREAM_END && (strm.avail_in || fgetc(file) != EOF))
+    {
+        fprintf(stderr, "Error: %s has more than one gzip member and cannot "
+                        "be indexed\n",
+                trace_filename);
+        ret = Z_DATA_ERROR;
+    }
+    else if (ret != Z_STREAM_END)
+    {
+        fprintf(stderr, "Error: couldn't decode %s as gzip\n",
+                trace_filename);
+    }
+
+    inflateEnd(&strm);
+    fclose(file);
+    free(in_buf);
+    free(window);
+    if (ret != Z_STREAM_END)
+    {
+        gzindex_free(idx);
+        return NULL;
+    }
+    idx->total_out = total_out;
+    return idx;
+}
+
+/**
+ * Load a sidecar index file, if it exists and was made from the trace as it
+ * is now.
+ */
+static GzIndex *gzindex_load(const char *idx_path, const struct stat *st)
+{
+    FILE *file = fopen(idx_path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    GzIndexHeader hdr;
+    GzIndex *idx = NULL;
+    if (fread(&hdr, sizeof(hdr), 1, file) == 1 &&
+        hdr.magic == GZINDEX_MAGIC &&
+        hdr.trace_size == (uint64_t)st->st_size &&
+        hdr.trace_mtime == (int64_t)st->st_mtime && hdr.num_points > 0)
+    {
+        idx = (GzIndex *)calloc(1, sizeof(GzIndex));
+        idx->total_out = hdr.total_out;
+        idx->num_points = hdr.num_points;
+        idx->points = (GzAccessPoint *)malloc(hdr.num_points *
+                                              sizeof(GzAccessPoint));
+        if (fread(idx->points, sizeof(GzAccessPoint), hdr.num_points,
+                  file) != hdr.num_points)
+        {
+            gzindex_free(idx);
+            idx = NULL;
+        }
+    }
+
+    fclose(file);
+    return idx;
+}
+
+/**
+ * Save an index next to its trace. A temporary file is renamed into place so
+ * that processes indexing the same trace at once never see a partial file.
+ */
+static void gzindex_save(const GzIndex *idx, const char *idx_path,
+                         const struct stat *st)
+{
+    char tmp_path[PATH_MAX + 16];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d", idx_path, (int)getpid());
+
+    GzIndexHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = GZINDEX_MAGIC;
+    hdr.trace_size = st->st_size;
+    hdr.trace_mtime = st->st_mtime;
+    hdr.total_out = idx->total_out;
+    hdr.num_points = idx->num_points;
+
+    FILE *file = fopen(tmp_path, "wb");
+    bool ok = file != NULL && fwrite(&hdr, sizeof(hdr), 1, file) == 1 &&
+              fwrite(idx->points, sizeof(GzAccessPoint), idx->num_points,
+                     file) == idx->num_points;
+    if (file != NULL && fclose(file) != 0)
+    {
+        ok = false;
+    }
+    if (!ok || rename(tmp_path, idx_path) != 0)
+    {
+        fprintf(stderr, "Warning: couldn't write the trace index %s; "
+                        "indexing again next time\n",
+                idx_path);
+        unlink(tmp_path);
+    }
+}
+
+/**
+ * Load the index of a compressed trace from its sidecar file, the trace's
+ * name followed by ".idx". If there is none, or the trace changed since it
+ * was written, index the trace in one pass and write a new sidecar file.
+ *
+ * @param trace_filename The gzip-compressed trace file.
+ * @return The index, or NULL if the trace could not be indexed.
+ */
+GzIndex *gzindex_open(const char *trace_filename)
+{
+    struct stat st;
+    if (stat(trace_filename, &st) != 0)
+    {
+        perror("Couldn't stat trace file");
+        return NULL;
+    }
+
+    char idx_path[PATH_MAX];
+    snprintf(idx_path, sizeof(idx_path), "%s.idx", trace_filename);
+    GzIndex *idx = gzindex_load(idx_path, &st);
+    if (idx)
+    {
+        return idx;
+    }
+
+    idx = gzindex_build(trace_filename);
+    if (idx)
+    {
+        gzindex_save(idx, idx_path, &st);
+    }
+    return idx;
+}
+
+/**
+ * Free the index of a trace.
+ *
+ * @param idx The index to free.
+ */
+void gzindex_free(GzIndex *idx)
+{
+    free(idx->points);
+    free(idx);
+}
+
+/**
+ * Find the last access point at or before an offset. The first point is at
+ * offset 0.
+ */
+static const GzAccessPoint *gzindex_find(const GzIndex *idx, uint64_t offset)
+{
+    uint64_t lo = 0;
+    uint64_t hi = idx->num_points;
+    while (hi - lo > 1)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (idx->points[mid].out <= offset)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return &idx->points[lo];
+}
+
+/**
+ * Find where decoding would start to reach an offset in the decoded trace.
+ *
+ * @param idx The index of the trace.
+ * @param offset The offset in the decoded trace.
+ * @return The offset of the last access point at or before it.
+ */
+uint64_t gzindex_point_at(const GzIndex *idx, uint64_t offset)
+{
+    return gzindex_find(idx, offset)->out;
+}
+
+/**
+ * Start decoding a compressed trace at the given offset, from the access
+ * point at or before it.
+ *
+ * @param idx The index of the trace.
+ * @param trace_filename The gzip-compressed trace file.
+ * @param offset The offset in the decoded trace to start at.
+ * @return The decoder, or NULL on error.
+ */
+GzReader *gzindex_reader_new(const GzIndex *idx, const char *trace_filename,
+                             uint64_t offset)
+{
+    const GzAccessPoint *point = gzindex_find(idx, offset);
+
+    FILE *file = fopen(trace_filename, "rb");
+    if (file == NULL)
+    {
+        perror("Couldn't open trace file");
+        return NULL;
+    }
+
+    GzReader *r = (GzReader *)calloc(1, sizeof(GzReader));
+    r->file = file;
+    if (inflateInit2(&r->strm, -15) != Z_OK)
+    {
+        fclose(file);
+        free(r);
+        return NULL;
+    }
+
+    int ret = Z_OK;
+    if (fseeko(file, point->in - (point->bits ? 1 : 0), SEEK_SET) != 0)
+    {
+        ret = Z_ERRNO;
+    }
+    else if (point->bits)
+    {
+        int c = getc(file);
+        ret = (c == EOF) ? Z_ERRNO
+                         : inflatePrime(&r->strm, point->bits,
+                                        c >> (8 - point->bits));
+    }
+    if (ret == Z_OK)
+    {
+        ret = inflateSetDictionary(&r->strm, point->window, GZINDEX_WINDOW);
+    }
+    if (ret != Z_OK)
+    {
+        fprintf(stderr, "Error: couldn't start decoding %s at an access "
+                        "point\n",
+                trace_filename);
+        gzindex_reader_free(r);
+        return NULL;
+    }
+
+    r->skip = offset - point->out;
+    r->pos = offset;
+    return r;
+}
+
+/**
+ * Inflate up to size bytes, stopping early only at the end of the stream.
+ */
+static ssize_t gzindex_inflate(GzReader *r, uint8_t *out, unsigned int size)
+{
+    r->strm.next_out = out;
+    r->strm.avail_out = size;
+    while (r->strm.avail_out && !r->eof)
+    {
+        if (r->strm.avail_in == 0)
+        {
+            r->strm.avail_in = fread(r->in_buf, 1, sizeof(r->in_buf),
+                                     r->file);
+            if (r->strm.avail_in == 0)
+            {
+                fprintf(stderr, "Error: trace file ends in the middle of "
+                                "the stream\n");
+                return -1;
+            }
+            r->strm.next_in = r->in_buf;
+        }
+
+        int ret = inflate(&r->strm, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END)
+        {
+            r->eof = true;
+        }
+        else if (ret != Z_OK)
+        {
+            fprintf(stderr, "Error: couldn't decode trace file (zlib error "
+                            "%d)\n",
+                    ret);
+            return -1;
+        }
+    }
+    return size - r->strm.avail_out;
+}
+
+/**
+ * Decode the next bytes of a trace.
+ *
+ * @param r The decoder.
+ * @param buf The buffer to decode into.
+ * @param size The number of bytes wanted.
+ * @return The number of bytes decoded, less than size only at the end of the
+ *         trace, or -1 on error.
+ */
+ssize_t gzindex_read(GzReader *r, void *buf, size_t size)
+{
+    // Decode and drop the bytes between the access point and the offset.
+    while (r->skip && !r->eof)
+    {
+        uint8_t discard[GZINDEX_WINDOW];
+        unsigned int n = (r->skip < sizeof(discard)) ? (unsigned int)r->skip
+                                                     : sizeof(discard);
+        ssize_t got = gzindex_inflate(r, discard, n);
+        if (got < 0)
+        {
+            return -1;
+        }
+        r->skip -= got;
+    }
+
+    uint8_t *bytes = (uint8_t *)buf;
+    size_t done = 0;
+    while (done < size && !r->eof)
+    {
+        size_t n = size - done;
+        ssize_t got = gzindex_inflate(r, bytes + done,
+                                      (n < GZINDEX_MAX_CHUNK)
+                                          ? (unsigned int)n
+                                          : GZINDEX_MAX_CHUNK);
+        if (got < 0)
+        {
+            return -1;
+        }
+        done += got;
+    }
+    r->pos += done;
+    return done;
+}
+
+/**
+ * Close a decoder.
+ *
+ * @param r The decoder to close.
+ */
+void gzindex_reader_free(GzReader *r)
+{
+    inflateEnd(&r->strm);
+    fclose(r->file);
+    free(r);
+}
+
+/**
+ * Decode a whole trace into memory, splitting it at access points into one
+ * segment per thread and decoding the segments in parallel.
+ *
+ * @param idx The index of the trace.
+ * @param trace_filename The gzip-compressed trace file.
+ * @param buf The buffer to decode into, of idx->total_out bytes.
+ * @param num_threads The number of threads, or 0 for one per hardware thread.
+ * @return 0 on success, or 1 on error.
+ */
+int gzindex_decode(const GzIndex *idx, const char *trace_filename,
+                   uint8_t *buf, unsigned int num_threads)
+{
+    if (num_threads == 0)
+    {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    if (num_threads == 0)
+    {
+        num_threads = 1;
+    }
+    if (num_threads > idx->num_points)
+    {
+        num_threads = idx->num_points;
+    }
+
+    // Each thread decodes from its first access point to the next thread's.
+    std::vector<int> failed(num_threads, 0);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < num_threads; t++)
+    {
+        uint64_t first = t * idx->num_points / num_threads;
+        uint64_t next = (t + 1) * idx->num_points / num_threads;
+        uint64_t begin = idx->points[first].out;
+        uint64_t end = (next < idx->num_points) ? idx->points[next].out
+                                                : idx->total_out;
+        workers.push_back(std::thread([=, &failed]() {
+            GzReader *r = gzindex_reader_new(idx, trace_filename, begin);
+            failed[t] = r == NULL ||
+                        gzindex_read(r, buf + begin, end - begin) !=
+                            (ssize_t)(end - begin);
+            if (r)
+            {
+                gzindex_reader_free(r);
+            }
+        }));
+    }
+
+    int status = 0;
+    for (unsigned int t = 0; t < num_threads; t++)
+    {
+        workers[t].join();
+        status |= failed[t];
+    }
+    return status;
+}
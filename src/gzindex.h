@@ -0,0 +1,143 @@
+// gzindex.h
+// Declares the access point index of a gzip-compressed trace, which lets a
+// trace be decoded from the middle, and in several segments at once, without
+// changing its format.
+
+#ifndef __GZINDEX_H__
+#define __GZINDEX_H__
+
+#include "types.h"
+#include <stdio.h>
+#include <sys/types.h>
+#include <zlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The bytes of output that inflating a deflate stream may refer back to. */
+#define GZINDEX_WINDOW 32768
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** A place in a compressed trace where decoding can start. */
+typedef struct GzAccessPoint
+{
+    /** The offset of the point in the decoded trace. */
+    uint64_t out;
+
+    /** The offset of the first compressed byte after the point. */
+    uint64_t in;
+
+    /**
+     * The number of bits of the byte before in that belong after the point,
+     * or 0 if the point is on a byte boundary.
+     */
+    unsigned int bits;
+
+    /** The decoded bytes just before the point, oldest first. */
+    uint8_t window[GZINDEX_WINDOW];
+} GzAccessPoint;
+
+/** The access points of a compressed trace. */
+typedef struct GzIndex
+{
+    GzAccessPoint *points;
+    uint64_t num_points;
+
+    /** The size of the decoded trace in bytes. */
+    uint64_t total_out;
+} GzIndex;
+
+/** A decoder of a compressed trace that started at some offset. */
+typedef struct GzReader
+{
+    FILE *file;
+    z_stream strm;
+    uint8_t in_buf[16 * 1024];
+
+    /** The decoded bytes still to discard before the starting offset. */
+    uint64_t skip;
+
+    /** The offset in the decoded trace of the next byte read. */
+    uint64_t pos;
+
+    bool eof;
+} GzReader;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Load the index of a compressed trace from its sidecar file, the trace's
+ * name followed by ".idx". If there is none, or the trace changed since it
+ * was written, index the trace in one pass and write a new sidecar file.
+ *
+ * @param trace_filename The gzip-compressed trace file.
+ * @return The index, or NULL if the trace could not be indexed.
+ */
+GzIndex *gzindex_open(const char *trace_filename);
+
+/**
+ * Free the index of a trace.
+ *
+ * @param idx The index to free.
+ */
+void gzindex_free(GzIndex *idx);
+
+/**
+ * Find where decoding would start to reach an offset in the decoded trace.
+ *
+ * @param idx The index of the trace.
+ * @param offset The offset in the decoded trace.
+ * @return The offset of the last access point at or before it.
+ */
+uint64_t gzindex_point_at(const GzIndex *idx, uint64_t offset);
+
+/**
+ * Start decoding a compressed trace at the given offset, from the access
+ * point at or before it.
+ *
+ * @param idx The index of the trace.
+ * @param trace_filename The gzip-compressed trace file.
+ * @param offset The offset in the decoded trace to start at.
+ * @return The decoder, or NULL on error.
+ */
+GzReader *gzindex_reader_new(const GzIndex *idx, const char *trace_filename,
+                             uint64_t offset);
+
+/**
+ * Decode the next bytes of a trace.
+ *
+ * @param r The decoder.
+ * @param buf The buffer to decode into.
+ * @param size The number of bytes wanted.
+ * @return The number of bytes decoded, less than size only at the end of the
+ *         trace, or -1 on error.
+ */
+ssize_t gzindex_read(GzReader *r, void *buf, size_t size);
+
+/**
+ * Close a decoder.
+ *
+ * @param r The decoder to close.
+ */
+void gzindex_reader_free(GzReader *r);
+
+/**
+ * Decode a whole trace into memory, splitting it at access points into one
+ * segment per thread and decoding the segments in parallel.
+ *
+ * @param idx The index of the trace.
+ * @param trace_filename The gzip-compressed trace file.
+ * @param buf The buffer to decode into, of idx->total_out bytes.
+ * @param num_threads The number of threads, or 0 for one per hardware thread.
+ * @return 0 on success, or 1 on error.
+ */
+int gzindex_decode(const GzIndex *idx, const char *trace_filename,
+                   uint8_t *buf, unsigned int num_threads);
+
+#endif // __GZINDEX_H__
@@ -0,0 +1,347 @@
+// hawkeye.cpp
+// Defines the Hawkeye replacement policy: a predictor of cache-friendly
+// instructions, trained by reconstructing OPT's decisions on sampled sets.
+//
+// OPTgen replays the accesses to a sampled set and asks, each time a line is
+// reused, whether OPT could have kept it cached since its last access: it
+// could if fewer than `ways` lines were being kept over every access in
+// between. The answer trains a counter for the instruction that made the
+// last access. Each access is then inserted close to or far from eviction,
+// RRIP-style, according to the counter of its instruction.
+
+#include "hawkeye.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+static uint16_t hawkeye_signature(uint64_t pc, unsigned int core_id)
+{
+    uint64_t h = (pc ^ ((uint64_t)core_id << 32)) * 0x9e3779b97f4a7c15ULL;
+    return (uint16_t)(h >> (64 - HAWKEYE_PREDICTOR_BITS));
+}
+
+static void hawkeye_train(Hawkeye *h, uint16_t signature, bool friendly)
+{
+    uint8_t *counter = &h->predictor[signature];
+    if (friendly && *counter < HAWKEYE_COUNTER_MAX)
+    {
+        (*counter)++;
+    }
+    if (!friendly && *counter > 0)
+    {
+        (*counter)--;
+    }
+}
+
+/**
+ * Allocate and initialize the Hawkeye state of a cache.
+ *
+ * @param c The cache, which must have its sets and ways set.
+ * @return A pointer to the Hawkeye state.
+ */
+Hawkeye *hawkeye_new(const Cache *c)
+{
+    Hawkeye *h = (Hawkeye *)calloc(1, sizeof(Hawkeye));
+    h->ways = c->ways;
+    h->history = HAWKEYE_HISTORY_PER_WAY * c->ways;
+    h->sample_stride = (c->sets > HAWKEYE_SAMPLED_SETS)
+                           ? c->sets / HAWKEYE_SAMPLED_SETS
+                           : 1;
+
+    for (unsigned int i = 0; i < HAWKEYE_SAMPLED_SETS; i++)
+    {
+        h->sampled[i].occupancy = (uint8_t *)calloc(h->history,
+                                                    sizeof(uint8_t));
+        h->sampled[i].samples = (HawkeyeSample *)calloc(
+            h->history, sizeof(HawkeyeSample));
+    }
+
+    // Until trained, every instruction is assumed cache-friendly.
+    memset(h->predictor, (HAWKEYE_COUNTER_MAX + 1) / 2, sizeof(h->predictor));
+
+    uint64_t num_lines = (uint64_t)c->sets * c->ways;
+    h->rrpv = (uint8_t *)malloc(num_lines * sizeof(uint8_t));
+    h->signature = (uint16_t *)malloc(num_lines * sizeof(uint16_t));
+    for (uint64_t i = 0; i < num_lines; i++)
+    {
+        h->rrpv[i] = HAWKEYE_RRPV_MAX;
+        h->signature[i] = HAWKEYE_NO_SIGNATURE;
+    }
+    return h;
+}
+
+/**
+ * Run OPTgen on an access to a sampled set, training the predictor with the
+ * outcome OPT would have had for the previous access to the same line.
+ */
+static void optgen_access(Hawkeye *h, HawkeyeSampledSet *s,
+                          uint64_t line_addr, uint16_t signature)
+{
+    uint64_t now = s->time;
+    s->occupancy[now % h->history] = 0;
+
+    HawkeyeSample *e = NULL;
+    for (unsigned int i = 0; i < h->history; i++)
+    {
+        if (s->samples[i].valid && s->samples[i].line_addr == line_addr)
+        {
+            e = &s->samples[i];
+            break;
+        }
+    }
+
+    if (e)
+    {
+        bool fits = now - e->time < h->history;
+        for (uint64_t t = e->time; fits && t < now; t++)
+        {
+            fits = s->occupancy[t % h->history] < h->ways;
+        }
+
+        if (fits)
+        {
+            for (uint64_t t = e->time; t < now; t++)
+            {
+                s->occupancy[t % h->history]++;
+            }
+            h->stat_optgen_hits++;
+        }
+        hawkeye_train(h, e->signature, fits);
+    }
+    else
+    {
+        // Forget the least recently accessed line; it was not reused within
+        // the history, so OPT would not have kept it.
+        e = &s->samples[0];
+        for (unsigned int i = 0; i < h->history && e->valid; i++)
+        {
+            if (!s->samples[i].valid || s->samples[i].time < e->time)
+            {
+                e = &s->samples[i];
+            }
+        }
+        if (e->valid)
+        {
+            hawkeye_train(h, e->signature, false);
+        }
+    }
+
+    e->valid = true;
+    e->line_addr = line_addr;
+    e->time = now;
+    e->signature = signature;
+    s->time++;
+    h->stat_optgen_accesses++;
+}
+
+/**
+ * Describe the access about to be made to the cache, train OPTgen if it goes
+ * to a sampled set, and predict whether its instruction is cache-friendly.
+ *
+ * @param h The Hawkeye state of the cache.
+ * @param c The cache about to be accessed.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param pc The address of the instruction that caused the access.
+ * @param is_writeback Whether the access is a writeback, which neither trains
+ *                     nor is predicted, and is inserted for early eviction.
+ * @param core_id The CPU core ID that made the access.
+ */
+void hawkeye_access(Hawkeye *h, const Cache *c, uint64_t line_addr,
+                    uint64_t pc, bool is_writeback, unsigned int core_id)
+{
+    h->cur_writeback = is_writeback;
+    if (is_writeback)
+    {
+        h->cur_signature = HAWKEYE_NO_SIGNATURE;
+        h->cur_friendly = false;
+        return;
+    }
+
+    h->cur_signature = hawkeye_signature(pc, core_id);
+
+    unsigned int set = (line_addr & c->index_mask) % c->sets;
+    if (set % h->sample_stride == 0 &&
+        set / h->sample_stride < HAWKEYE_SAMPLED_SETS)
+    {
+        optgen_access(h, &h->sampled[set / h->sample_stride], line_addr,
+                      h->cur_signature);
+    }
+
+    h->cur_friendly = h->predictor[h->cur_signature] >
+                      HAWKEYE_COUNTER_MAX / 2;
+    h->stat_predictions++;
+    if (h->cur_friendly)
+    {
+        h->stat_friendly++;
+    }
+}
+
+/**
+ * Update a line that the current access hit.
+ *
+ * @param h The Hawkeye state of the cache.
+ * @param set The index of the set.
+ * @param way The way of the line.
+ */
+void hawkeye_hit(Hawkeye *h, unsigned int set, unsigned int way)
+{
+    if (h->cur_writeback)
+    {
+        return;
+    }
+
+    uint64_t i = (uint64_t)set * h->ways + way;
+    h->rrpv[i] = h->cur_friendly ? 0 : HAWKEYE_RRPV_MAX;
+    h->signature[i] = h->cur_signature;
+}
+
+/**
+ * Update the lines of a set after the current access installed a line.
+ *
+ * @param h The Hawkeye state of the cache.
+ * @param c The cache.
+ * @param set The index of the set.
+ * @param way The way the line was installed in.
+ */
+void hawkeye_fill(Hawkeye *h, const Cache *c, unsigned int set,
+                  unsigned int way)
+{
+    uint64_t base = (uint64_t)set * h->ways;
+    h->signature[base + way] = h->cur_signature;
+
+    if (!h->cur_friendly)
+    {
+        h->rrpv[base + way] = HAWKEYE_RRPV_MAX;
+        return;
+    }
+
+    // Age the other friendly lines, keeping them ahead of averse ones.
+    for (unsigned int w = 0; w < h->ways; w++)
+    {
+        if (w != way && c->cacheGrid[set].row[w].valid &&
+            h->rrpv[base + w] < HAWKEYE_RRPV_MAX - 1)
+        {
+            h->rrpv[base + w]++;
+        }
+    }
+    h->rrpv[base + way] = 0;
+}
+
+/**
+ * Choose the line of a full set to evict: one predicted cache-averse if any,
+ * otherwise the oldest friendly line, whose prediction is then weakened.
+ * Pinned lines are skipped.
+ *
+ * @param h The Hawkeye state of the cache.
+ * @param c The cache.
+ * @param set The index of the set.
+ * @return The way to evict.
+ */
+unsigned int hawkeye_victim(Hawkeye *h, const Cache *c, unsigned int set)
+{
+    const uint8_t *rrpv = h->rrpv + (uint64_t)set * h->ways;
+    const CacheLine *row = c->cacheGrid[set].row;
+    unsigned int victim = 0;
+    while (row[victim].pinned)
+    {
+        victim++;
+    }
+    for (unsigned int w = victim; w < h->ways; w++)
+    {
+        if (row[w].pinned)
+        {
+            continue;
+        }
+        if (rrpv[w] == HAWKEYE_RRPV_MAX)
+        {
+            return w;
+        }
+        if (rrpv[w] > rrpv[victim])
+        {
+            victim = w;
+        }
+    }
+
+    uint16_t signature = h->signature[(uint64_t)set * h->ways + victim];
+    if (signature != HAWKEYE_NO_SIGNATURE)
+    {
+        hawkeye_train(h, signature, false);
+    }
+    return victim;
+}
+
+/**
+ * Reset the statistics of the Hawkeye state.
+ *
+ * @param h The Hawkeye state.
+ */
+void hawkeye_clear_stats(Hawkeye *h)
+{
+    h->stat_friendly = 0;
+    h->stat_predictions = 0;
+    h->stat_optgen_hits = 0;
+    h->stat_optgen_accesses = 0;
+}
+
+/**
+ * Add the statistics of one Hawkeye state to those of another.
+ *
+ * @param dst The state whose statistics are increased.
+ * @param src The state whose statistics are added.
+ */
+void hawkeye_add_stats(Hawkeye *dst, const Hawkeye *src)
+{
+    dst->stat_friendly += src->stat_friendly;
+    dst->stat_predictions += src->stat_predictions;
+    dst->stat_optgen_hits += src->stat_optgen_hits;
+    dst->stat_optgen_accesses += src->stat_optgen_accesses;
+}
+
+/**
+ * Free the Hawkeye state of a cache.
+ *
+ * @param h The Hawkeye state.
+ */
+void hawkeye_free(Hawkeye *h)
+{
+    for (unsigned int i = 0; i < HAWKEYE_SAMPLED_SETS; i++)
+    {
+        free(h->sampled[i].occupancy);
+        free(h->sampled[i].samples);
+    }
+    free(h->rrpv);
+    free(h->signature);
+    free(h);
+}
+
+/**
+ * Print the statistics of the Hawkeye state.
+ *
+ * @param h The Hawkeye state.
+ * @param label A label for the cache, which is used as a prefix for each
+ *              statistic.
+ */
+void hawkeye_print_stats(Hawkeye *h, const char *label)
+{
+    double friendly_percent = 0.0;
+    double optgen_hit_percent = 0.0;
+
+    if (h->stat_predictions)
+    {
+        friendly_percent = 100.0 * (double)h->stat_friendly /
+                           (double)h->stat_predictions;
+    }
+    if (h->stat_optgen_accesses)
+    {
+        optgen_hit_percent = 100.0 * (double)h->stat_optgen_hits /
+                             (double)h->stat_optgen_accesses;
+    }
+
+    printf("%s_FRIENDLY_PERC   \t\t : %10.3f\n", label, friendly_percent);
+    printf("%s_OPTGEN_HIT_PERC \t\t : %10.3f\n", label, optgen_hit_percent);
+}
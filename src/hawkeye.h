@@ -0,0 +1,176 @@
+// hawkeye.h
+// Declares the Hawkeye replacement policy: a predictor of cache-friendly
+// instructions, trained by reconstructing OPT's decisions on sampled sets.
+
+#ifndef __HAWKEYE_H__
+#define __HAWKEYE_H__
+
+#include "types.h"
+#include "cache.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The number of sets that train the predictor. */
+#define HAWKEYE_SAMPLED_SETS 64
+
+/** The number of saturating counters in the predictor, as a power of 2. */
+#define HAWKEYE_PREDICTOR_BITS 11
+#define HAWKEYE_PREDICTOR_SIZE (1 << HAWKEYE_PREDICTOR_BITS)
+
+/** The largest value of a predictor counter; the upper half is friendly. */
+#define HAWKEYE_COUNTER_MAX 7
+
+/** The re-reference prediction value of a line to evict first. */
+#define HAWKEYE_RRPV_MAX 7
+
+/** The length of OPTgen's history, in accesses to the set per way. */
+#define HAWKEYE_HISTORY_PER_WAY 8
+
+/** The signature of a line installed by a writeback. */
+#define HAWKEYE_NO_SIGNATURE 0xffff
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The last access to a line in a sampled set. */
+typedef struct HawkeyeSample
+{
+    bool valid;
+    uint64_t line_addr;
+    uint64_t time;
+    uint16_t signature;
+} HawkeyeSample;
+
+/**
+ * OPTgen for one sampled set: the number of lines OPT would keep cached over
+ * each of the last accesses, and the last access to each line seen.
+ */
+typedef struct HawkeyeSampledSet
+{
+    uint64_t time;
+    uint8_t *occupancy;
+    HawkeyeSample *samples;
+} HawkeyeSampledSet;
+
+/** The state of the Hawkeye policy for one cache. */
+typedef struct Hawkeye
+{
+    unsigned int ways;
+    unsigned int history;
+
+    /** Every how many sets one is sampled. */
+    unsigned int sample_stride;
+    HawkeyeSampledSet sampled[HAWKEYE_SAMPLED_SETS];
+
+    uint8_t predictor[HAWKEYE_PREDICTOR_SIZE];
+
+    /** For each line of the cache, its RRPV and the signature that set it. */
+    uint8_t *rrpv;
+    uint16_t *signature;
+
+    /** The access being made, as described by hawkeye_access(). */
+    uint16_t cur_signature;
+    bool cur_friendly;
+    bool cur_writeback;
+
+    unsigned long long stat_friendly;
+    unsigned long long stat_predictions;
+    unsigned long long stat_optgen_hits;
+    unsigned long long stat_optgen_accesses;
+} Hawkeye;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize the Hawkeye state of a cache.
+ *
+ * @param c The cache, which must have its sets and ways set.
+ * @return A pointer to the Hawkeye state.
+ */
+Hawkeye *hawkeye_new(const Cache *c);
+
+/**
+ * Describe the access about to be made to the cache, train OPTgen if it goes
+ * to a sampled set, and predict whether its instruction is cache-friendly.
+ *
+ * @param h The Hawkeye state of the cache.
+ * @param c The cache about to be accessed.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param pc The address of the instruction that caused the access.
+ * @param is_writeback Whether the access is a writeback, which neither trains
+ *                     nor is predicted, and is inserted for early eviction.
+ * @param core_id The CPU core ID that made the access.
+ */
+void hawkeye_access(Hawkeye *h, const Cache *c, uint64_t line_addr,
+                    uint64_t pc, bool is_writeback, unsigned int core_id);
+
+/**
+ * Update a line that the current access hit.
+ *
+ * @param h The Hawkeye state of the cache.
+ * @param set The index of the set.
+ * @param way The way of the line.
+ */
+void hawkeye_hit(Hawkeye *h, unsigned int set, unsigned int way);
+
+/**
+ * Update the lines of a set after the current access installed a line.
+ *
+ * @param h The Hawkeye state of the cache.
+ * @param c The cache.
+ * @param set The index of the set.
+ * @param way The way the line was installed in.
+ */
+void hawkeye_fill(Hawkeye *h, const Cache *c, unsigned int set,
+                  unsigned int way);
+
+/**
+ * Choose the line of a full set to evict: one predicted cache-averse if any,
+ * otherwise the oldest friendly line, whose prediction is then weakened.
+ * Pinned lines are skipped.
+ *
+ * @param h The Hawkeye state of the cache.
+ * @param c The cache.
+ * @param set The index of the set.
+ * @return The way to evict.
+ */
+unsigned int hawkeye_victim(Hawkeye *h, const Cache *c, unsigned int set);
+
+/**
+ * Reset the statistics of the Hawkeye state.
+ *
+ * @param h The Hawkeye state.
+ */
+void hawkeye_clear_stats(Hawkeye *h);
+
+/**
+ * Add the statistics of one Hawkeye state to those of another.
+ *
+ * @param dst The state whose statistics are increased.
+ * @param src The state whose statistics are added.
+ */
+void hawkeye_add_stats(Hawkeye *dst, const Hawkeye *src);
+
+/**
+ * Free the Hawkeye state of a cache.
+ *
+ * @param h The Hawkeye state.
+ */
+void hawkeye_free(Hawkeye *h);
+
+/**
+ * Print the statistics of the Hawkeye state.
+ *
+ * @param h The Hawkeye state.
+ * @param label A label for the cache, which is used as a prefix for each
+ *              statistic.
+ */
+void hawkeye_print_stats(Hawkeye *h, const char *label);
+
+#endif // __HAWKEYE_H__
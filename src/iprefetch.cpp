@@ -0,0 +1,213 @@
+// iprefetch.cpp
+// Defines the instruction prefetchers of the L1 instruction caches, and the
+// prefetches they have in flight.
+//
+// A prefetched line is installed in the instruction cache when it is issued,
+// and stays in flight until the L2 cache or DRAM would have delivered it. A
+// fetch that finds the line before then waits for the rest of the latency.
+
+#include "iprefetch.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize an instruction prefetcher.
+ *
+ * @return A pointer to the prefetcher.
+ */
+IcachePrefetcher *ipf_new()
+{
+    IcachePrefetcher *ipf = (IcachePrefetcher *)calloc(
+        1, sizeof(IcachePrefetcher));
+    ipf->last_line = UINT64_MAX;
+    return ipf;
+}
+
+/**
+ * Whether the fetch-directed prefetcher should look at the given line, which
+ * holds the next instruction of the upcoming fetch stream. Consecutive
+ * instructions in one line are looked at once.
+ *
+ * @param ipf The prefetcher.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @return Whether the line differs from the previous one.
+ */
+bool ipf_new_fetch_line(IcachePrefetcher *ipf, uint64_t line_addr)
+{
+    if (line_addr == ipf->last_line)
+    {
+        return false;
+    }
+    ipf->last_line = line_addr;
+    return true;
+}
+
+/**
+ * Retire the prefetches that have arrived, and check whether another one can
+ * be issued. Counts the prefetch as dropped if not.
+ *
+ * @param ipf The prefetcher.
+ * @param cycle The current cycle.
+ * @return Whether fewer than IPF_MAX_INFLIGHT prefetches are in flight.
+ */
+bool ipf_can_issue(IcachePrefetcher *ipf, uint64_t cycle)
+{
+    // Prefetches may arrive out of order, so one that is slow to arrive
+    // holds back the retirement of later ones, as in a queue of misses.
+    while (ipf->inflight_count &&
+           ipf->inflight[ipf->inflight_head].ready_cycle <= cycle)
+    {
+        ipf->inflight_head = (ipf->inflight_head + 1) % IPF_MAX_INFLIGHT;
+        ipf->inflight_count--;
+    }
+
+    if (ipf->inflight_count == IPF_MAX_INFLIGHT)
+    {
+        ipf->stat_dropped++;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Record a prefetch issued after ipf_can_issue() allowed it.
+ *
+ * @param ipf The prefetcher.
+ * @param line_addr The address of the cache line prefetched (in units of the
+ *                  cache line size).
+ * @param ready_cycle The cycle at which the line arrives.
+ */
+void ipf_issue(IcachePrefetcher *ipf, uint64_t line_addr,
+               uint64_t ready_cycle)
+{
+    unsigned int tail = (ipf->inflight_head + ipf->inflight_count) %
+                        IPF_MAX_INFLIGHT;
+    ipf->inflight[tail].line_addr = line_addr;
+    ipf->inflight[tail].ready_cycle = ready_cycle;
+    ipf->inflight_count++;
+    ipf->stat_issued++;
+}
+
+/**
+ * Record the first fetch from a prefetched line, and find how long it still
+ * has to wait for the line to arrive.
+ *
+ * @param ipf The prefetcher.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param cycle The current cycle.
+ * @return The number of cycles until the line arrives, or 0 if it has.
+ */
+uint64_t ipf_first_use(IcachePrefetcher *ipf, uint64_t line_addr,
+                       uint64_t cycle)
+{
+    // Look from the newest prefetch, in case the line was prefetched before,
+    // evicted unused and prefetched again.
+    for (unsigned int k = ipf->inflight_count; k > 0; k--)
+    {
+        IpfInflight *p = &ipf->inflight[(ipf->inflight_head + k - 1) %
+                                        IPF_MAX_INFLIGHT];
+        if (p->line_addr != line_addr)
+        {
+            continue;
+        }
+        if (p->ready_cycle <= cycle)
+        {
+            break;
+        }
+
+        uint64_t wait = p->ready_cycle - cycle;
+        ipf->stat_late++;
+        ipf->stat_late_cycles += wait;
+        return wait;
+    }
+
+    ipf->stat_timely++;
+    return 0;
+}
+
+/**
+ * Reset the statistics of an instruction prefetcher.
+ *
+ * @param ipf The prefetcher.
+ */
+void ipf_clear_stats(IcachePrefetcher *ipf)
+{
+    ipf->stat_issued = 0;
+    ipf->stat_dropped = 0;
+    ipf->stat_l2_misses = 0;
+    ipf->stat_timely = 0;
+    ipf->stat_late = 0;
+    ipf->stat_late_cycles = 0;
+}
+
+/**
+ * Add the statistics of one instruction prefetcher to those of another.
+ *
+ * @param dst The prefetcher whose statistics are increased.
+ * @param src The prefetcher whose statistics are added.
+ */
+void ipf_add_stats(IcachePrefetcher *dst, const IcachePrefetcher *src)
+{
+    dst->stat_issued += src->stat_issued;
+    dst->stat_dropped += src->stat_dropped;
+    dst->stat_l2_misses += src->stat_l2_misses;
+    dst->stat_timely += src->stat_timely;
+    dst->stat_late += src->stat_late;
+    dst->stat_late_cycles += src->stat_late_cycles;
+}
+
+/**
+ * Print the statistics of an instruction prefetcher, and the misses per
+ * thousand instructions of its cache with and without the prefetches that
+ * were used.
+ *
+ * @param ipf The prefetcher.
+ * @param icache The instruction cache it fills.
+ * @param header The name of the cache.
+ */
+void ipf_print_stats(IcachePrefetcher *ipf, Cache *icache,
+                     const char *header)
+{
+    // Every instruction is fetched once, so the fetches count instructions.
+    double mpki = 0.0;
+    double base_mpki = 0.0;
+    if (icache->stat_read_access)
+    {
+        mpki = 1000.0 * (double)icache->stat_read_miss /
+               (double)icache->stat_read_access;
+        base_mpki = 1000.0 *
+                    (double)(icache->stat_read_miss + icache->stat_pf_useful) /
+                    (double)icache->stat_read_access;
+    }
+
+    double timely_percent = 0.0;
+    double late_wait_avg = 0.0;
+    if (ipf->stat_timely + ipf->stat_late)
+    {
+        timely_percent = 100.0 * (double)ipf->stat_timely /
+                         (double)(ipf->stat_timely + ipf->stat_late);
+    }
+    if (ipf->stat_late)
+    {
+        late_wait_avg = (double)ipf->stat_late_cycles /
+                        (double)ipf->stat_late;
+    }
+
+    printf("\n");
+    printf("%s_PF_ISSUED       \t\t : %10llu\n", header, ipf->stat_issued);
+    printf("%s_PF_DROPPED      \t\t : %10llu\n", header, ipf->stat_dropped);
+    printf("%s_PF_L2_MISSES    \t\t : %10llu\n", header,
+           ipf->stat_l2_misses);
+    printf("%s_PF_TIMELY       \t\t : %10llu\n", header, ipf->stat_timely);
+    printf("%s_PF_LATE         \t\t : %10llu\n", header, ipf->stat_late);
+    printf("%s_PF_TIMELY_PERC  \t\t : %10.3f\n", header, timely_percent);
+    printf("%s_PF_LATE_AVGWAIT \t\t : %10.3f\n", header, late_wait_avg);
+    printf("%s_MPKI            \t\t : %10.3f\n", header, mpki);
+    printf("%s_MPKI_NO_PF      \t\t : %10.3f\n", header, base_mpki);
+}
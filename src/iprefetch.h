@@ -0,0 +1,156 @@
+// iprefetch.h
+// Declares the instruction prefetchers of the L1 instruction caches, and the
+// prefetches they have in flight.
+
+#ifndef __IPREFETCH_H__
+#define __IPREFETCH_H__
+
+#include "types.h"
+#include "cache.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The largest number of lines prefetched after one instruction fetch. */
+#define IPF_MAX_DEGREE 16
+
+/** The largest number of instruction prefetches in flight for one core. */
+#define IPF_MAX_INFLIGHT 16
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Possible prefetchers of the instruction cache. */
+typedef enum IcachePrefetcherEnum
+{
+    IPF_OFF = 0,       // Do not prefetch.
+    IPF_NEXT_LINE = 1, // Prefetch the next lines after a miss.
+    IPF_FDP = 2,       // Prefetch the lines of the upcoming fetch stream.
+} IcachePrefetcherType;
+
+/** A line on its way into the instruction cache. */
+typedef struct IpfInflight
+{
+    uint64_t line_addr;
+
+    /** The cycle at which the line arrives. */
+    uint64_t ready_cycle;
+} IpfInflight;
+
+/** The state of the instruction prefetcher of one core. */
+typedef struct IcachePrefetcher
+{
+    /** The prefetches in flight, oldest first, as a ring. */
+    IpfInflight inflight[IPF_MAX_INFLIGHT];
+    unsigned int inflight_head;
+    unsigned int inflight_count;
+
+    /** The line the fetch-directed prefetcher looked at last. */
+    uint64_t last_line;
+
+    /**
+     * The total number of prefetches issued, and how many were dropped
+     * because IPF_MAX_INFLIGHT prefetches were already in flight.
+     */
+    unsigned long long stat_issued;
+    unsigned long long stat_dropped;
+
+    /** The prefetches that missed in the L2 cache and read DRAM. */
+    unsigned long long stat_l2_misses;
+
+    /**
+     * The total number of prefetched lines first fetched after they arrived,
+     * and before; and the cycles the late ones still had to wait.
+     */
+    unsigned long long stat_timely;
+    unsigned long long stat_late;
+    unsigned long long stat_late_cycles;
+} IcachePrefetcher;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize an instruction prefetcher.
+ *
+ * @return A pointer to the prefetcher.
+ */
+IcachePrefetcher *ipf_new();
+
+/**
+ * Whether the fetch-directed prefetcher should look at the given line, which
+ * holds the next instruction of the upcoming fetch stream. Consecutive
+ * instructions in one line are looked at once.
+ *
+ * @param ipf The prefetcher.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @return Whether the line differs from the previous one.
+ */
+bool ipf_new_fetch_line(IcachePrefetcher *ipf, uint64_t line_addr);
+
+/**
+ * Retire the prefetches that have arrived, and check whether another one can
+ * be issued. Counts the prefetch as dropped if not.
+ *
+ * @param ipf The prefetcher.
+ * @param cycle The current cycle.
+ * @return Whether fewer than IPF_MAX_INFLIGHT prefetches are in flight.
+ */
+bool ipf_can_issue(IcachePrefetcher *ipf, uint64_t cycle);
+
+/**
+ * Record a prefetch issued after ipf_can_issue() allowed it.
+ *
+ * @param ipf The prefetcher.
+ * @param line_addr The address of the cache line prefetched (in units of the
+ *                  cache line size).
+ * @param ready_cycle The cycle at which the line arrives.
+ */
+void ipf_issue(IcachePrefetcher *ipf, uint64_t line_addr,
+               uint64_t ready_cycle);
+
+/**
+ * Record the first fetch from a prefetched line, and find how long it still
+ * has to wait for the line to arrive.
+ *
+ * @param ipf The prefetcher.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param cycle The current cycle.
+ * @return The number of cycles until the line arrives, or 0 if it has.
+ */
+uint64_t ipf_first_use(IcachePrefetcher *ipf, uint64_t line_addr,
+                       uint64_t cycle);
+
+/**
+ * Reset the statistics of an instruction prefetcher.
+ *
+ * @param ipf The prefetcher.
+ */
+void ipf_clear_stats(IcachePrefetcher *ipf);
+
+/**
+ * Add the statistics of one instruction prefetcher to those of another.
+ *
+ * @param dst The prefetcher whose statistics are increased.
+ * @param src The prefetcher whose statistics are added.
+ */
+void ipf_add_stats(IcachePrefetcher *dst, const IcachePrefetcher *src);
+
+/**
+ * Print the statistics of an instruction prefetcher, and the misses per
+ * thousand instructions of its cache with and without the prefetches that
+ * were used.
+ *
+ * @param ipf The prefetcher.
+ * @param icache The instruction cache it fills.
+ * @param header The name of the cache.
+ */
+void ipf_print_stats(IcachePrefetcher *ipf, Cache *icache,
+                     const char *header);
+
+#endif // __IPREFETCH_H__
@@ -0,0 +1,193 @@
+// lanes.cpp
+// Defines the engine that simulates several mode A data caches side by side
+// over one shared address stream.
+
+#include "lanes.h"
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The tag stored in an invalid line. No real tag reaches this value. */
+#define LANE_INVALID_TAG UINT64_MAX
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The number of bytes in a cache line. */
+extern uint64_t CACHE_LINESIZE;
+
+/** The data cache configurations simulated in mode A, one per lane. */
+extern LaneConfig LANE_CONFIG[MAX_LANES];
+
+/** The number of lanes configured. */
+extern unsigned int NUM_LANES;
+
+///////////////////////////////////////////////////////////////////////////////
+//                              GLOBAL VARIABLES                             //
+///////////////////////////////////////////////////////////////////////////////
+
+static CacheLane *lanes[MAX_LANES];
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+static CacheLane *lane_new(const LaneConfig *cfg)
+{
+    CacheLane *l = (CacheLane *)calloc(1, sizeof(CacheLane));
+    l->ways = cfg->assoc;
+    l->sets = (cfg->size / CACHE_LINESIZE) / cfg->assoc;
+    l->policy = cfg->policy;
+    l->index_bits = (unsigned)(std::log2(l->sets));
+    l->index_mask = ((1U << l->index_bits) - 1);
+
+    uint64_t num_lines = (uint64_t)l->sets * l->ways;
+    l->tags = (uint64_t *)malloc(num_lines * sizeof(uint64_t));
+    l->stamps = (uint64_t *)calloc(num_lines, sizeof(uint64_t));
+    l->dirty = (uint8_t *)calloc(num_lines, sizeof(uint8_t));
+    for (uint64_t i = 0; i < num_lines; i++)
+    {
+        l->tags[i] = LANE_INVALID_TAG;
+    }
+
+    initstate_r(42, l->rand_state, sizeof(l->rand_state), &l->rand_data);
+    return l;
+}
+
+/**
+ * Access one lane, with the same outcome and statistics as cache_access()
+ * followed by cache_install() on a miss.
+ */
+static void lane_access(CacheLane *l, uint64_t line_addr, bool is_write,
+                        uint64_t stamp)
+{
+    uint64_t set = line_addr & l->index_mask;
+    uint64_t tag = line_addr >> l->index_bits;
+    uint64_t *tags = l->tags + set * l->ways;
+    uint64_t *stamps = l->stamps + set * l->ways;
+    uint8_t *dirty = l->dirty + set * l->ways;
+
+    if (is_write)
+        l->stats.stat_write_access++;
+    else
+        l->stats.stat_read_access++;
+
+    // Compare all ways at once; tags are unique within a set.
+    unsigned hits = 0;
+    unsigned empty = 0;
+    for (unsigned w = 0; w < l->ways; w++)
+    {
+        hits |= (unsigned)(tags[w] == tag) << w;
+        empty |= (unsigned)(tags[w] == LANE_INVALID_TAG) << w;
+    }
+
+    if (hits)
+    {
+        unsigned w = __builtin_ctz(hits);
+        stamps[w] = stamp;
+        dirty[w] |= is_write;
+        return;
+    }
+
+    if (is_write)
+        l->stats.stat_write_miss++;
+    else
+        l->stats.stat_read_miss++;
+
+    unsigned victim = 0;
+    if (empty)
+    {
+        victim = __builtin_ctz(empty);
+    }
+    else if (l->policy == RANDOM)
+    {
+        int32_t r;
+        random_r(&l->rand_data, &r);
+        victim = (unsigned)(r % l->ways);
+    }
+    else
+    {
+        for (unsigned w = 1; w < l->ways; w++)
+        {
+            if (stamps[w] < stamps[victim])
+            {
+                victim = w;
+            }
+        }
+    }
+
+    if (tags[victim] != LANE_INVALID_TAG && dirty[victim])
+    {
+        l->stats.stat_dirty_evicts++;
+    }
+
+    tags[victim] = tag;
+    stamps[victim] = stamp;
+    dirty[victim] = is_write;
+}
+
+/**
+ * Run the trace of the given core to completion through every configured
+ * lane.
+ *
+ * @param core The (only) core, whose trace is consumed.
+ * @return The number of cycles the serial simulation loop would have run.
+ */
+uint64_t lanes_run(Core *core)
+{
+    for (unsigned int i = 0; i < NUM_LANES; i++)
+    {
+        lanes[i] = lane_new(&LANE_CONFIG[i]);
+    }
+
+    // Mode A never stalls, so instruction n runs in cycle n, and its cycle
+    // number doubles as the LRU timestamp.
+    uint64_t seq = 0;
+    while (!core->done)
+    {
+        seq++;
+        core->inst_count++;
+
+        if (core->trace_inst_type == INST_TYPE_LOAD ||
+            core->trace_inst_type == INST_TYPE_STORE)
+        {
+            uint64_t line_addr = core->trace_ldst_addr / CACHE_LINESIZE;
+            bool is_write = (core->trace_inst_type == INST_TYPE_STORE);
+            for (unsigned int i = 0; i < NUM_LANES; i++)
+            {
+                lane_access(lanes[i], line_addr, is_write, seq);
+            }
+        }
+
+        core_read_trace(core);
+    }
+
+    core->done_inst_count = core->inst_count;
+    core->done_cycle_count = seq;
+    return seq + 1;
+}
+
+/**
+ * Print the configuration and statistics of every lane.
+ */
+void lanes_print_stats()
+{
+    static const char *policy_names[] = {"LRU", "RANDOM", "SWP", "DWP"};
+    char label[32];
+
+    for (unsigned int i = 0; i < NUM_LANES; i++)
+    {
+        printf("\n");
+        printf("LANE_%02u_CONFIG       \t\t : %4lluKB %2u-way %s\n", i,
+               (unsigned long long)(LANE_CONFIG[i].size / 1024),
+               lanes[i]->ways, policy_names[lanes[i]->policy]);
+
+        snprintf(label, sizeof(label), "LANE_%02u_DCACHE", i);
+        cache_print_stats(&lanes[i]->stats, label);
+    }
+}
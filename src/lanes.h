@@ -0,0 +1,84 @@
+// lanes.h
+// Declares the engine that simulates several mode A data caches side by side.
+
+#ifndef __LANES_H__
+#define __LANES_H__
+
+#include "types.h"
+#include "cache.h"
+#include "core.h"
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The maximum number of cache configurations simulated in one run. */
+#define MAX_LANES 16
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The configuration of the data cache simulated in one lane. */
+typedef struct LaneConfig
+{
+    uint64_t size;
+    uint64_t assoc;
+    ReplacementPolicy policy;
+} LaneConfig;
+
+/**
+ * One data cache of the batch.
+ *
+ * The tags, timestamps and dirty bits of all lines are kept in separate
+ * set-major arrays, so that the ways of a set are compared in one vectorised
+ * pass.
+ */
+typedef struct CacheLane
+{
+    unsigned ways;
+    unsigned sets;
+    unsigned index_bits;
+    uint64_t index_mask;
+    ReplacementPolicy policy;
+
+    /** The tag of each line, or LANE_INVALID_TAG if the line is invalid. */
+    uint64_t *tags;
+    /** The timestamp of the last access to each line, for LRU. */
+    uint64_t *stamps;
+    uint8_t *dirty;
+
+    /**
+     * A private copy of the generator behind rand(), seeded like the serial
+     * simulator, so random replacement makes the same choices as a separate
+     * run of this configuration.
+     */
+    struct random_data rand_data;
+    char rand_state[128];
+
+    /**
+     * The statistics of this lane, laid out like those of a Cache.
+     */
+    Cache stats;
+} CacheLane;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Run the trace of the given core to completion through every configured
+ * lane.
+ *
+ * @param core The (only) core, whose trace is consumed.
+ * @return The number of cycles the serial simulation loop would have run.
+ */
+uint64_t lanes_run(Core *core);
+
+/**
+ * Print the configuration and statistics of every lane.
+ */
+void lanes_print_stats();
+
+#endif // __LANES_H__
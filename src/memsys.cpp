@@ -2,6 +2,9 @@
 // Defines the functions for the memory system.
 
 #include "memsys.h"
+#include "hawkeye.h"
+#include "pin.h"
+#include "temporal.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,14 +17,8 @@
 /** The number of bytes in a page. */
 #define PAGE_SIZE 4096
 
-/** The hit time of the data cache in cycles. */
-#define DCACHE_HIT_LATENCY 1
-
-/** The hit time of the instruction cache in cycles. */
-#define ICACHE_HIT_LATENCY 1
-
-/** The hit time of the L2 cache in cycles. */
-#define L2CACHE_HIT_LATENCY 10
+/** The number of cache slots of a memory system, used or not. */
+#define MEMSYS_CACHE_SLOTS (3 + 2 * MAX_CORES)
 
 ///////////////////////////////////////////////////////////////////////////////
 //                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
@@ -59,16 +56,53 @@ extern uint64_t L2CACHE_ASSOC;
 /** The replacement policy to use for the L2 cache. */
 extern ReplacementPolicy L2CACHE_REPL;
 
+/** Whether L2CACHE_REPL also applies to the L2 cache in modes B and C. */
+extern bool L2CACHE_REPL_SET;
+
+/** The levels of the L2 zcache replacement walk, or 0 if not a zcache. */
+extern unsigned int L2CACHE_ZCACHE_LEVELS;
+
 /** The number of cores being simulated. */
 extern unsigned int NUM_CORES;
 
+/** How the L2 cache is split into banks. */
+extern NucaMode NUCA_MODE;
+
 /** The current clock cycle number. */
-extern uint64_t current_cycle;
+extern thread_local uint64_t current_cycle;
+
+/** The number of pinned address ranges. */
+extern unsigned int NUM_PIN_RANGES;
+
+/** The largest number of pinned lines in each L2 cache set. */
+extern unsigned int PIN_MAX_WAYS;
+
+/** When dirty L2 lines are written back to DRAM. */
+extern L2WritebackPolicy L2CACHE_WB_POLICY;
+
+/** The prefetcher of the L2 cache. */
+extern L2PrefetcherType L2_PREFETCHER;
+
+/** How many least recently used lines of a set eager writeback examines. */
+extern unsigned int L2CACHE_WB_EAGER_WAYS;
+
+/** The prefetcher of the instruction caches. */
+extern IcachePrefetcherType ICACHE_PREFETCHER;
+
+/** The number of lines the next-line instruction prefetcher fetches. */
+extern unsigned int ICACHE_PF_DEGREE;
+
+/** One set of the L2 cache in this many is simulated. */
+extern unsigned int L2CACHE_SAMPLE_RATIO;
 
 ///////////////////////////////////////////////////////////////////////////////
 //                           FUNCTION DEFINITIONS                            //
 ///////////////////////////////////////////////////////////////////////////////
 
+static uint64_t memsys_l2_ifetch_prefetch(MemorySystem *sys,
+                                          uint64_t line_addr,
+                                          unsigned int core_id);
+
 /**
  * Allocate and initialize the memory system.
  * 
@@ -90,15 +124,19 @@ MemorySystem *memsys_new()
                                 REPL_POLICY);
         sys->icache = cache_new(ICACHE_SIZE, ICACHE_ASSOC, CACHE_LINESIZE,
                                 REPL_POLICY);
-        sys->l2cache = cache_new(L2CACHE_SIZE, L2CACHE_ASSOC, CACHE_LINESIZE,
-                                 REPL_POLICY);
+        sys->l2cache = cache_new(L2CACHE_SIZE / L2CACHE_SAMPLE_RATIO,
+                                 L2CACHE_ASSOC, CACHE_LINESIZE,
+                                 L2CACHE_REPL_SET ? L2CACHE_REPL
+                                                  : REPL_POLICY);
+        sys->l2cache->zcache_levels = L2CACHE_ZCACHE_LEVELS;
         sys->dram = dram_new();
     }
 
     if (SIM_MODE == SIM_MODE_DEF)
     {
-        sys->l2cache = cache_new(L2CACHE_SIZE, L2CACHE_ASSOC, CACHE_LINESIZE,
-                                 L2CACHE_REPL);
+        sys->l2cache = cache_new(L2CACHE_SIZE / L2CACHE_SAMPLE_RATIO,
+                                 L2CACHE_ASSOC, CACHE_LINESIZE, L2CACHE_REPL);
+        sys->l2cache->zcache_levels = L2CACHE_ZCACHE_LEVELS;
         sys->dram = dram_new();
         for (unsigned int i = 0; i < NUM_CORES; i++)
         {
@@ -109,6 +147,45 @@ MemorySystem *memsys_new()
         }
     }
 
+    if (sys->l2cache && L2CACHE_SAMPLE_RATIO > 1)
+    {
+        sys->l2_sample = setsample_new(sys->l2cache->sets,
+                                       L2CACHE_SAMPLE_RATIO);
+    }
+
+    if (sys->l2cache && NUM_PIN_RANGES)
+    {
+        sys->l2cache->pin_max_ways = PIN_MAX_WAYS;
+    }
+
+    if (sys->l2cache && NUCA_MODE != NUCA_OFF)
+    {
+        sys->nuca = nuca_new();
+    }
+
+    if (sys->l2cache && L2_PREFETCHER != L2PF_OFF)
+    {
+        sys->l2pf = temporal_new(L2_PREFETCHER);
+        sys->l2cache->prefetch_stats = true;
+    }
+
+    if (ICACHE_PREFETCHER != IPF_OFF)
+    {
+        for (unsigned int i = 0; i < NUM_CORES; i++)
+        {
+            Cache *icache = (SIM_MODE == SIM_MODE_DEF) ? sys->icache_coreid[i]
+                                                       : sys->icache;
+            sys->ipf[i] = ipf_new();
+            icache->prefetch_stats = true;
+        }
+    }
+
+    if (sys->l2cache && L2CACHE_WB_POLICY != L2_WB_EVICT)
+    {
+        sys->dbi = dbi_new((uint64_t)sys->l2cache->sets * sys->l2cache->ways,
+                           dram_row_line_bits(sys->dram));
+    }
+
     return sys;
 }
 
@@ -119,10 +196,11 @@ MemorySystem *memsys_new()
  * @param addr The address to access (in bytes).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param pc The address of the instruction that made the access.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access(MemorySystem *sys, uint64_t addr, AccessType type,
-                       unsigned int core_id)
+                       unsigned int core_id, uint64_t pc)
 {
     uint64_t delay = 0;
 
@@ -137,12 +215,12 @@ uint64_t memsys_access(MemorySystem *sys, uint64_t addr, AccessType type,
 
     if (SIM_MODE == SIM_MODE_B || SIM_MODE == SIM_MODE_C)
     {
-        delay = memsys_access_modeBC(sys, line_addr, type, core_id);
+        delay = memsys_access_modeBC(sys, line_addr, type, core_id, pc);
     }
 
     if (SIM_MODE == SIM_MODE_DEF)
     {
-        delay = memsys_access_modeDEF(sys, line_addr, type, core_id);
+        delay = memsys_access_modeDEF(sys, line_addr, type, core_id, pc);
     }
 
     // Update the statistics.
@@ -214,6 +292,101 @@ uint64_t memsys_access_modeA(MemorySystem *sys, uint64_t line_addr,
 }
 
 
+/**
+ * After a demand access to the L2 cache, pin the line if it lies in a pinned
+ * range, and count the access towards the hit rate of the pinned ranges.
+ */
+static void memsys_l2_pin(MemorySystem *sys, uint64_t v_line_addr,
+                          uint64_t p_line_addr, unsigned int core_id, bool hit)
+{
+    if (sys->l2cache->pin_max_ways == 0 ||
+        !pin_contains(v_line_addr, p_line_addr, core_id))
+    {
+        return;
+    }
+
+    sys->stat_pin_access++;
+    if (hit)
+    {
+        sys->stat_pin_hits++;
+    }
+    cache_pin_line(sys->l2cache, p_line_addr, core_id);
+}
+
+/**
+ * Prefetch a line into the instruction cache of a core through the L2 cache,
+ * unless the line is cached already or too many prefetches are in flight.
+ */
+static void memsys_icache_prefetch(MemorySystem *sys, uint64_t v_line_addr,
+                                   unsigned int core_id)
+{
+    Cache *icache = sys->icache;
+    uint64_t p_line_addr = v_line_addr;
+    if (SIM_MODE == SIM_MODE_DEF)
+    {
+        icache = sys->icache_coreid[core_id];
+        p_line_addr = memsys_translate_line_addr(sys, v_line_addr, core_id);
+    }
+
+    IcachePrefetcher *ipf = sys->ipf[core_id];
+    if (cache_probe(icache, p_line_addr, core_id) ||
+        !ipf_can_issue(ipf, current_cycle))
+    {
+        return;
+    }
+
+    uint64_t delay = memsys_l2_ifetch_prefetch(sys, p_line_addr, core_id);
+    cache_install_prefetch(icache, p_line_addr, core_id);
+    ipf_issue(ipf, p_line_addr, current_cycle + delay);
+}
+
+/**
+ * After an instruction fetch, wait for a prefetched line that has not
+ * arrived yet, and let the next-line prefetcher follow a miss or the first
+ * use of a prefetched line.
+ *
+ * @return The cycles the fetch still waits for a prefetched line.
+ */
+static uint64_t memsys_icache_train(MemorySystem *sys, Cache *icache,
+                                    uint64_t v_line_addr, uint64_t p_line_addr,
+                                    CacheResult outcome, unsigned int core_id)
+{
+    uint64_t wait = 0;
+    if (outcome == HIT && icache->last_hit_prefetched)
+    {
+        wait = ipf_first_use(sys->ipf[core_id], p_line_addr, current_cycle);
+    }
+
+    if (ICACHE_PREFETCHER == IPF_NEXT_LINE &&
+        (outcome == MISS || icache->last_hit_prefetched))
+    {
+        for (unsigned int k = 1; k <= ICACHE_PF_DEGREE; k++)
+        {
+            memsys_icache_prefetch(sys, v_line_addr + k, core_id);
+        }
+    }
+    return wait;
+}
+
+/**
+ * Let the fetch-directed prefetcher of a core see an instruction of its
+ * upcoming fetch stream, and prefetch its line into the instruction cache
+ * if it is not there.
+ *
+ * @param sys The memory system.
+ * @param addr The address of the instruction (in bytes).
+ * @param core_id The CPU core ID that will fetch the instruction.
+ */
+void memsys_fetch_directed(MemorySystem *sys, uint64_t addr,
+                           unsigned int core_id)
+{
+    uint64_t line_addr = addr / CACHE_LINESIZE;
+    if (ipf_new_fetch_line(sys->ipf[core_id], line_addr))
+    {
+        memsys_icache_prefetch(sys, line_addr, core_id);
+    }
+}
+
 /**
  * In mode B or C, access the given memory address from an instruction fetch or
  * load/store.
@@ -223,10 +396,12 @@ uint64_t memsys_access_modeA(MemorySystem *sys, uint64_t line_addr,
  *                  cache line size, i.e., excluding the line offset bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param pc The address of the instruction that made the access.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
-                              AccessType type, unsigned int core_id)
+                              AccessType type, unsigned int core_id,
+                              uint64_t pc)
 {
     uint64_t delay = 0;
     CacheResult outcome;
@@ -268,7 +443,10 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
         if (outcome == MISS)
         {
             // Access l2 cache
-            delay += memsys_l2_access(sys, line_addr, false, core_id);
+            unsigned long long l2_misses = sys->l2cache->stat_read_miss;
+            delay += memsys_l2_access(sys, line_addr, false, core_id, pc);
+            memsys_l2_pin(sys, line_addr, line_addr, core_id,
+                          sys->l2cache->stat_read_miss == l2_misses);
             cache_install(c, line_addr, is_write, core_id);
             if (type != ACCESS_TYPE_IFETCH)
             {
@@ -279,15 +457,187 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
                     unsigned evicted_address = c->lastEvictedLine.tag << c->index_bits;
                     evicted_address = evicted_address | index;
 
-                    memsys_l2_access(sys, evicted_address, true, core_id);
+                    memsys_l2_access(sys, evicted_address, true, core_id, 0);
                 }
             }
         }
+        if (type == ACCESS_TYPE_IFETCH && sys->ipf[core_id])
+        {
+            delay += memsys_icache_train(sys, c, line_addr, line_addr,
+                                         outcome, core_id);
+        }
     }
 
     return delay;
 }
 
+/**
+ * Write a dirty L2 line back to DRAM. With row-aware writeback, also write
+ * the other dirty L2 lines in the same DRAM row, which are row hits.
+ *
+ * @param sys The memory system.
+ * @param line_addr The address of the cache line written back (in units of
+ *                  the cache line size), already clean or evicted.
+ */
+static void memsys_l2_writeback(MemorySystem *sys, uint64_t line_addr)
+{
+    dram_access(sys->dram, line_addr, true);
+    if (L2CACHE_WB_POLICY != L2_WB_ROW && L2CACHE_WB_POLICY != L2_WB_EAGER_ROW)
+    {
+        return;
+    }
+
+    uint64_t row_base = line_addr & ~((1ULL << sys->dbi->row_bits) - 1);
+    for (unsigned int core_id = 0; core_id < NUM_CORES; core_id++)
+    {
+        uint64_t dirty = dbi_row_dirty(sys->dbi, line_addr, core_id);
+        while (dirty)
+        {
+            uint64_t addr = row_base | __builtin_ctzll(dirty);
+            dirty &= dirty - 1;
+            dbi_clear(sys->dbi, addr, core_id);
+            if (cache_clean_line(sys->l2cache, addr, core_id))
+            {
+                dram_access(sys->dram, addr, true);
+                sys->stat_wb_row++;
+            }
+        }
+    }
+}
+
+/**
+ * If the DRAM is idle, clean the least recently used dirty line among the
+ * L2CACHE_WB_EAGER_WAYS least recently used lines of the set that an address
+ * maps to, so that a later miss in the set need not wait to write it back.
+ *
+ * @param sys The memory system.
+ * @param line_addr The address of the cache line about to be accessed (in
+ *                  units of the cache line size).
+ */
+static void memsys_l2_eager_writeback(MemorySystem *sys, uint64_t line_addr)
+{
+    uint64_t dirty_addr;
+    unsigned int owner;
+    if (!dram_idle(sys->dram) ||
+        !cache_lru_dirty_line(sys->l2cache, line_addr, L2CACHE_WB_EAGER_WAYS,
+                              &dirty_addr, &owner))
+    {
+        return;
+    }
+
+    cache_clean_line(sys->l2cache, dirty_addr, owner);
+    dbi_clear(sys->dbi, dirty_addr, owner);
+    memsys_l2_writeback(sys, dirty_addr);
+    sys->stat_wb_eager++;
+}
+
+/**
+ * Write the line that the last install into the L2 cache evicted back to
+ * DRAM, if it was dirty.
+ *
+ * @param sys The memory system.
+ * @param line_addr The address of the line installed (in units of the cache
+ *                  line size).
+ */
+static void memsys_l2_write_victim(MemorySystem *sys, uint64_t line_addr)
+{
+    if (sys->l2cache->lastEvictedLine.valid &&
+        sys->l2cache->lastEvictedLine.dirty)
+    {
+        // Writeback
+        uint64_t evicted_address = cache_evicted_line_addr(sys->l2cache,
+                                                           line_addr);
+        if (sys->l2_sample)
+        {
+            evicted_address = setsample_from_cache(sys->l2_sample,
+                                                   evicted_address);
+        }
+
+        if (sys->dbi)
+        {
+            dbi_clear(sys->dbi, evicted_address,
+                      sys->l2cache->lastEvictedLine.coreID);
+            memsys_l2_writeback(sys, evicted_address);
+        }
+        else
+        {
+            dram_access(sys->dram, evicted_address, true);
+        }
+    }
+}
+
+/**
+ * Train the L2 prefetcher on a demand access and fill the L2 cache with the
+ * lines it predicts. The fills read DRAM but do not delay the access.
+ *
+ * @param sys The memory system.
+ * @param line_addr The address of the cache line accessed (in units of the
+ *                  cache line size).
+ * @param pc The address of the instruction that made the access.
+ * @param core_id The CPU core ID that made the access.
+ */
+static void memsys_l2_prefetch(MemorySystem *sys, uint64_t line_addr,
+                               uint64_t pc, unsigned int core_id)
+{
+    uint64_t candidates[TEMPORAL_MAX_DEGREE];
+    unsigned n = temporal_train(sys->l2pf, sys->dram, line_addr, pc, core_id,
+                                candidates);
+    for (unsigned i = 0; i < n; i++)
+    {
+        if (cache_probe(sys->l2cache, candidates[i], core_id))
+        {
+            continue;
+        }
+        dram_access(sys->dram, candidates[i], false);
+        cache_install_prefetch(sys->l2cache, candidates[i], core_id);
+        memsys_l2_write_victim(sys, candidates[i]);
+    }
+}
+
+/**
+ * Read a line an instruction prefetch asks for from the L2 cache, and prefetch
+ * it from DRAM into the L2 cache as well if it misses, as the L2 prefetcher
+ * does. Neither demand statistics nor Hawkeye see the request, and NUCA hops
+ * are charged without being counted.
+ *
+ * @return The cycles until the line reaches the instruction cache.
+ */
+static uint64_t memsys_l2_ifetch_prefetch(MemorySystem *sys,
+                                          uint64_t line_addr,
+                                          unsigned int core_id)
+{
+    uint64_t delay = L2CACHE_HIT_LATENCY;
+    uint64_t l2_line = line_addr;
+    if (sys->l2_sample)
+    {
+        if (!setsample_is_sampled(sys->l2_sample, line_addr))
+        {
+            return delay;
+        }
+        l2_line = setsample_to_cache(sys->l2_sample, line_addr);
+    }
+
+    if (sys->nuca)
+    {
+        delay += nuca_access(sys->nuca, sys->l2cache, line_addr, true,
+                             core_id);
+    }
+    if (cache_probe(sys->l2cache, l2_line, core_id))
+    {
+        return delay;
+    }
+
+    sys->ipf[core_id]->stat_l2_misses++;
+    delay += dram_access(sys->dram, line_addr, false);
+    cache_install_prefetch(sys->l2cache, l2_line, core_id);
+    if (sys->nuca)
+    {
+        nuca_install(sys->nuca, sys->l2cache, line_addr, core_id);
+    }
+    memsys_l2_write_victim(sys, l2_line);
+    return delay;
+}
+
 /**
  * Access the given address through the shared L2 cache.
  * 
@@ -297,28 +647,99 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
  *                  offset bits).
  * @param is_writeback Whether this access is a writeback from an L1 cache.
  * @param core_id The CPU core ID that requested this access.
+ * @param pc The address of the instruction whose L1 miss caused the access,
+ *           or 0 for a writeback.
  * @return The delay in cycles incurred by this access.
  */
 uint64_t memsys_l2_access(MemorySystem *sys, uint64_t line_addr,
-                          bool is_writeback, unsigned int core_id)
+                          bool is_writeback, unsigned int core_id,
+                          uint64_t pc)
 {
     uint64_t delay = L2CACHE_HIT_LATENCY;
 
+    // Only the sampled sets are simulated. The others are charged the
+    // average latency of a DRAM read as often as the recent sampled reads
+    // missed.
+    uint64_t l2_line = line_addr;
+    if (sys->l2_sample)
+    {
+        if (!setsample_is_sampled(sys->l2_sample, line_addr))
+        {
+            if (setsample_skip(sys->l2_sample, is_writeback) &&
+                sys->dram->stat_read_access)
+            {
+                delay += sys->dram->stat_read_delay /
+                         sys->dram->stat_read_access;
+            }
+            return delay;
+        }
+        l2_line = setsample_to_cache(sys->l2_sample, line_addr);
+    }
+
+    // Reach the bank that holds the line.
+    if (sys->nuca)
+    {
+        delay += nuca_access(sys->nuca, sys->l2cache, line_addr, is_writeback,
+                             core_id);
+    }
+
+    if (sys->l2cache->hawkeye)
+    {
+        hawkeye_access(sys->l2cache->hawkeye, sys->l2cache, l2_line, pc,
+                       is_writeback, core_id);
+    }
+
+    if (L2CACHE_WB_POLICY == L2_WB_EAGER ||
+        L2CACHE_WB_POLICY == L2_WB_EAGER_ROW)
+    {
+        if (!is_writeback)
+        {
+            memsys_l2_eager_writeback(sys, line_addr);
+        }
+    }
+
     // L2 cache access.
-    CacheResult outcome = cache_access(sys->l2cache, line_addr, is_writeback, core_id);
+    CacheResult outcome = cache_access(sys->l2cache, l2_line, is_writeback, core_id);
+    bool dram_write = false;
     if (outcome == MISS)
     {
         // Dram access delay
-        delay += dram_access(sys->dram, line_addr, false);
-        cache_install(sys->l2cache, line_addr, is_writeback, core_id);
-        if (sys->l2cache->lastEvictedLine.valid && sys->l2cache->lastEvictedLine.dirty)
+        if (is_writeback)
         {
-            // Writeback
-            unsigned index = line_addr & sys->l2cache->index_mask;
-            unsigned evicted_address = (sys->l2cache->lastEvictedLine.tag << sys->l2cache->index_bits) | index;
-
-            dram_access(sys->dram, evicted_address, true);
+            delay += dram_access(sys->dram, line_addr, false);
+        }
+        else
+        {
+            delay += dram_demand_read(sys->dram, line_addr, core_id);
+        }
+        cache_install(sys->l2cache, l2_line, is_writeback, core_id);
+        if (sys->nuca)
+        {
+            nuca_install(sys->nuca, sys->l2cache, line_addr, core_id);
         }
+        dram_write = sys->l2cache->lastEvictedLine.valid &&
+                     sys->l2cache->lastEvictedLine.dirty;
+        memsys_l2_write_victim(sys, l2_line);
+    }
+
+    if (sys->l2_sample)
+    {
+        setsample_record(sys->l2_sample,
+                         (unsigned int)(l2_line & sys->l2cache->index_mask),
+                         is_writeback, outcome == MISS, dram_write);
+    }
+
+    if (sys->dbi && is_writeback)
+    {
+        dbi_mark(sys->dbi, line_addr, core_id);
+    }
+
+    // Train the prefetcher on misses and on the first use of prefetched
+    // lines, which would have been misses without it.
+    if (sys->l2pf && !is_writeback &&
+        (outcome == MISS || sys->l2cache->last_hit_prefetched))
+    {
+        memsys_l2_prefetch(sys, line_addr, pc, core_id);
     }
 
     return delay;
@@ -334,20 +755,16 @@ uint64_t memsys_l2_access(MemorySystem *sys, uint64_t line_addr,
  *                    bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param pc The address of the instruction that made the access.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
-                               AccessType type, unsigned int core_id)
+                               AccessType type, unsigned int core_id,
+                               uint64_t pc)
 {
     uint64_t delay = 0;
-    uint64_t p_line_addr = 0;
-    
-    // Convert lineaddr from virtual (v) to physical (p)
-    int offset_bits = static_cast<unsigned>(std::log2(PAGE_SIZE)) - static_cast<unsigned>(std::log2(CACHE_LINESIZE)); // since 4KB
-    uint64_t offset_mask = ((1U << offset_bits) - 1);
-    uint64_t vfn = v_line_addr >> offset_bits;
-    uint64_t pfn = memsys_convert_vpn_to_pfn(sys, vfn, core_id); 
-    p_line_addr = (pfn << offset_bits) | (v_line_addr & offset_mask);
+    uint64_t p_line_addr = memsys_translate_line_addr(sys, v_line_addr,
+                                                      core_id);
 
     CacheResult outcome;
     bool needs_cache_access = false;
@@ -388,7 +805,10 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
         if (outcome == MISS)
         {
             // Access l2 cache
-            delay += memsys_l2_access(sys, p_line_addr, false, core_id);
+            unsigned long long l2_misses = sys->l2cache->stat_read_miss;
+            delay += memsys_l2_access(sys, p_line_addr, false, core_id, pc);
+            memsys_l2_pin(sys, v_line_addr, p_line_addr, core_id,
+                          sys->l2cache->stat_read_miss == l2_misses);
             cache_install(c, p_line_addr, is_write, core_id);
             if (type != ACCESS_TYPE_IFETCH)
             {
@@ -398,15 +818,41 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
                     unsigned index = (unsigned) (p_line_addr & c->index_mask);
                     unsigned evicted_address = (c->lastEvictedLine.tag << c->index_bits) | index;
 
-                    memsys_l2_access(sys, evicted_address, true, core_id);
+                    memsys_l2_access(sys, evicted_address, true, core_id, 0);
                 }
             }
         }
+        if (type == ACCESS_TYPE_IFETCH && sys->ipf[core_id])
+        {
+            delay += memsys_icache_train(sys, c, v_line_addr, p_line_addr,
+                                         outcome, core_id);
+        }
     }
 
     return delay;
 }
 
+/**
+ * Convert the given virtual cache line address to its physical cache line
+ * address.
+ *
+ * @param sys The memory system being used.
+ * @param v_line_addr The virtual address of the cache line (in units of the
+ *                    cache line size).
+ * @param core_id The CPU core ID that requested this access.
+ * @return The physical address of the cache line.
+ */
+uint64_t memsys_translate_line_addr(MemorySystem *sys, uint64_t v_line_addr,
+                                    unsigned int core_id)
+{
+    // Convert lineaddr from virtual (v) to physical (p)
+    int offset_bits = static_cast<unsigned>(std::log2(PAGE_SIZE)) - static_cast<unsigned>(std::log2(CACHE_LINESIZE)); // since 4KB
+    uint64_t offset_mask = ((1U << offset_bits) - 1);
+    uint64_t vfn = v_line_addr >> offset_bits;
+    uint64_t pfn = memsys_convert_vpn_to_pfn(sys, vfn, core_id);
+    return (pfn << offset_bits) | (v_line_addr & offset_mask);
+}
+
 /**
  * Convert the given virtual page number (VPN) to its corresponding physical
  * frame number (PFN; also known as physical page number, or PPN).
@@ -426,6 +872,314 @@ uint64_t memsys_convert_vpn_to_pfn(MemorySystem *sys, uint64_t vpn,
     return pfn;
 }
 
+/**
+ * Ask the host to prefetch the simulated state that a future access to the
+ * given address will touch: the L1 and L2 sets and the DRAM row buffer.
+ *
+ * This does not change any simulated state.
+ *
+ * @param sys The memory system that will be accessed.
+ * @param addr The address that will be accessed (in bytes).
+ * @param type The type of the future memory access.
+ * @param core_id The CPU core ID that will request the access.
+ */
+void memsys_host_prefetch(MemorySystem *sys, uint64_t addr, AccessType type,
+                          unsigned int core_id)
+{
+    uint64_t line_addr = addr / CACHE_LINESIZE;
+    Cache *l1 = NULL;
+
+    if (SIM_MODE == SIM_MODE_A)
+    {
+        if (type != ACCESS_TYPE_IFETCH)
+        {
+            cache_prefetch_set(sys->dcache, line_addr);
+        }
+        return;
+    }
+
+    if (SIM_MODE == SIM_MODE_DEF)
+    {
+        line_addr = memsys_translate_line_addr(sys, line_addr, core_id);
+        l1 = (type == ACCESS_TYPE_IFETCH) ? sys->icache_coreid[core_id]
+                                          : sys->dcache_coreid[core_id];
+    }
+    else
+    {
+        l1 = (type == ACCESS_TYPE_IFETCH) ? sys->icache : sys->dcache;
+    }
+
+    cache_prefetch_set(l1, line_addr);
+    if (!sys->l2_sample)
+    {
+        cache_prefetch_set(sys->l2cache, line_addr);
+    }
+    else if (setsample_is_sampled(sys->l2_sample, line_addr))
+    {
+        cache_prefetch_set(sys->l2cache,
+                           setsample_to_cache(sys->l2_sample, line_addr));
+    }
+    dram_prefetch_row(sys->dram, line_addr);
+}
+
+/**
+ * List every cache slot of the memory system, in a fixed order. Unused slots
+ * are NULL.
+ */
+static unsigned int memsys_caches(const MemorySystem *sys, Cache **caches)
+{
+    unsigned int n = 0;
+    caches[n++] = sys->dcache;
+    caches[n++] = sys->icache;
+    for (unsigned int i = 0; i < MAX_CORES; i++)
+    {
+        caches[n++] = sys->dcache_coreid[i];
+        caches[n++] = sys->icache_coreid[i];
+    }
+    caches[n++] = sys->l2cache;
+    return n;
+}
+
+/**
+ * Call the given function on every cache of the memory system.
+ */
+static void memsys_for_each_cache(MemorySystem *sys, void (*fn)(Cache *))
+{
+    Cache *caches[MEMSYS_CACHE_SLOTS];
+    unsigned int n = memsys_caches(sys, caches);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        if (caches[i])
+        {
+            fn(caches[i]);
+        }
+    }
+}
+
+/**
+ * While warming the empty caches from a trace scanned backwards, place the
+ * line of the given access in each cache it would have reached.
+ *
+ * The L2 cache is filled with every access, not only those that miss in the
+ * L1 caches, and is marked dirty by stores whose line the L1 data cache does
+ * not hold, since those were written back.
+ *
+ * @param sys The memory system to warm.
+ * @param addr The address accessed (in bytes).
+ * @param type The type of memory access.
+ * @param core_id The CPU core ID that made the access.
+ * @return Whether every set of every cache is now full.
+ */
+bool memsys_reverse_fill(MemorySystem *sys, uint64_t addr, AccessType type,
+                         unsigned int core_id)
+{
+    uint64_t line_addr = addr / CACHE_LINESIZE;
+    bool is_write = (type == ACCESS_TYPE_STORE);
+    Cache *l1 = NULL;
+    Cache *other_l1 = NULL;
+
+    if (SIM_MODE == SIM_MODE_A)
+    {
+        if (type != ACCESS_TYPE_IFETCH)
+        {
+            cache_reverse_fill(sys->dcache, line_addr, is_write, core_id);
+        }
+        return sys->dcache->full_sets == sys->dcache->sets;
+    }
+
+    if (SIM_MODE == SIM_MODE_DEF)
+    {
+        line_addr = memsys_translate_line_addr(sys, line_addr, core_id);
+        l1 = (type == ACCESS_TYPE_IFETCH) ? sys->icache_coreid[core_id]
+                                          : sys->dcache_coreid[core_id];
+        other_l1 = (type == ACCESS_TYPE_IFETCH) ? sys->dcache_coreid[core_id]
+                                                : sys->icache_coreid[core_id];
+    }
+    else
+    {
+        l1 = (type == ACCESS_TYPE_IFETCH) ? sys->icache : sys->dcache;
+        other_l1 = (type == ACCESS_TYPE_IFETCH) ? sys->dcache : sys->icache;
+    }
+
+    bool in_l1 = cache_reverse_fill(l1, line_addr, is_write, core_id);
+    bool l2_dirty = is_write && !in_l1;
+    if (!sys->l2_sample)
+    {
+        if (cache_reverse_fill(sys->l2cache, line_addr, l2_dirty, core_id) &&
+            l2_dirty && sys->dbi)
+        {
+            dbi_mark(sys->dbi, line_addr, core_id);
+        }
+    }
+    else if (setsample_is_sampled(sys->l2_sample, line_addr))
+    {
+        cache_reverse_fill(sys->l2cache,
+                           setsample_to_cache(sys->l2_sample, line_addr),
+                           l2_dirty, core_id);
+    }
+
+    return l1->full_sets == l1->sets && other_l1->full_sets == other_l1->sets &&
+           sys->l2cache->full_sets == sys->l2cache->sets;
+}
+
+/**
+ * Normalise the LRU state of every cache after warming them with a clock that
+ * the detailed simulation will restart. See cache_normalize_lru().
+ *
+ * @param sys The memory system to normalise.
+ */
+void memsys_normalize_lru(MemorySystem *sys)
+{
+    memsys_for_each_cache(sys, cache_normalize_lru);
+}
+
+/**
+ * Restart the clock of the DRAM after warming the caches with a clock that
+ * the detailed simulation will restart. See dram_reset_clock().
+ *
+ * @param sys The memory system whose DRAM clock restarts.
+ */
+void memsys_reset_clock(MemorySystem *sys)
+{
+    if (sys->dram)
+    {
+        dram_reset_clock(sys->dram);
+    }
+}
+
+/**
+ * Reset the statistics of the memory system and all of its components.
+ *
+ * @param sys The memory system to reset the statistics of.
+ */
+void memsys_clear_stats(MemorySystem *sys)
+{
+    sys->stat_ifetch_access = 0;
+    sys->stat_load_access = 0;
+    sys->stat_store_access = 0;
+    sys->stat_ifetch_delay = 0;
+    sys->stat_load_delay = 0;
+    sys->stat_store_delay = 0;
+    sys->stat_pin_access = 0;
+    sys->stat_pin_hits = 0;
+    sys->stat_wb_eager = 0;
+    sys->stat_wb_row = 0;
+
+    memsys_for_each_cache(sys, cache_clear_stats);
+    if (sys->dram)
+    {
+        dram_clear_stats(sys->dram);
+    }
+    if (sys->nuca)
+    {
+        nuca_clear_stats(sys->nuca);
+    }
+    if (sys->l2pf)
+    {
+        temporal_clear_stats(sys->l2pf);
+    }
+    if (sys->l2_sample)
+    {
+        setsample_clear_stats(sys->l2_sample);
+    }
+    for (unsigned int i = 0; i < MAX_CORES; i++)
+    {
+        if (sys->ipf[i])
+        {
+            ipf_clear_stats(sys->ipf[i]);
+        }
+    }
+}
+
+/**
+ * Add the statistics of one memory system to those of another with the same
+ * configuration.
+ *
+ * @param dst The memory system whose statistics are increased.
+ * @param src The memory system whose statistics are added.
+ */
+void memsys_add_stats(MemorySystem *dst, const MemorySystem *src)
+{
+    dst->stat_ifetch_access += src->stat_ifetch_access;
+    dst->stat_load_access += src->stat_load_access;
+    dst->stat_store_access += src->stat_store_access;
+    dst->stat_ifetch_delay += src->stat_ifetch_delay;
+    dst->stat_load_delay += src->stat_load_delay;
+    dst->stat_store_delay += src->stat_store_delay;
+    dst->stat_pin_access += src->stat_pin_access;
+    dst->stat_pin_hits += src->stat_pin_hits;
+    dst->stat_wb_eager += src->stat_wb_eager;
+    dst->stat_wb_row += src->stat_wb_row;
+
+    Cache *dst_caches[MEMSYS_CACHE_SLOTS];
+    Cache *src_caches[MEMSYS_CACHE_SLOTS];
+    unsigned int n = memsys_caches(dst, dst_caches);
+    memsys_caches(src, src_caches);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        if (dst_caches[i] && src_caches[i])
+        {
+            cache_add_stats(dst_caches[i], src_caches[i]);
+        }
+    }
+
+    if (dst->dram && src->dram)
+    {
+        dram_add_stats(dst->dram, src->dram);
+    }
+    if (dst->nuca && src->nuca)
+    {
+        nuca_add_stats(dst->nuca, src->nuca);
+    }
+    if (dst->l2pf && src->l2pf)
+    {
+        temporal_add_stats(dst->l2pf, src->l2pf);
+    }
+    if (dst->l2_sample && src->l2_sample)
+    {
+        setsample_add_stats(dst->l2_sample, src->l2_sample);
+    }
+    for (unsigned int i = 0; i < MAX_CORES; i++)
+    {
+        if (dst->ipf[i] && src->ipf[i])
+        {
+            ipf_add_stats(dst->ipf[i], src->ipf[i]);
+        }
+    }
+}
+
+/**
+ * Free the memory system and all of its components.
+ *
+ * @param sys The memory system to free.
+ */
+void memsys_free(MemorySystem *sys)
+{
+    memsys_for_each_cache(sys, cache_free);
+    if (sys->dram)
+    {
+        dram_free(sys->dram);
+    }
+    free(sys->nuca);
+    if (sys->dbi)
+    {
+        dbi_free(sys->dbi);
+    }
+    if (sys->l2pf)
+    {
+        temporal_free(sys->l2pf);
+    }
+    if (sys->l2_sample)
+    {
+        setsample_free(sys->l2_sample);
+    }
+    for (unsigned int i = 0; i < MAX_CORES; i++)
+    {
+        free(sys->ipf[i]);
+    }
+    free(sys);
+}
+
 /**
  * Print the statistics of the memory system.
  * 
@@ -483,4 +1237,60 @@ void memsys_print_stats(MemorySystem *sys)
         cache_print_stats(sys->l2cache, "L2CACHE");
         dram_print_stats(sys->dram);
     }
+
+    if (sys->l2_sample)
+    {
+        setsample_print_stats(sys->l2_sample, "L2CACHE");
+    }
+
+    if (sys->nuca)
+    {
+        nuca_print_stats(sys->nuca);
+    }
+
+    if (sys->l2cache && sys->l2cache->pin_max_ways)
+    {
+        uint64_t lines = (uint64_t)sys->l2cache->sets * sys->l2cache->ways;
+        uint64_t pinned = cache_pinned_lines(sys->l2cache);
+        double hit_percent = 0.0;
+        if (sys->stat_pin_access)
+        {
+            hit_percent = 100.0 * (double)sys->stat_pin_hits /
+                          (double)sys->stat_pin_access;
+        }
+
+        printf("\n");
+        printf("PIN_L2_LINES         \t\t : %10llu\n",
+               (unsigned long long)pinned);
+        printf("PIN_L2_OCCUPANCY_PERC\t\t : %10.3f\n",
+               100.0 * (double)pinned / (double)lines);
+        printf("PIN_L2_ACCESS        \t\t : %10llu\n", sys->stat_pin_access);
+        printf("PIN_L2_HIT_PERC      \t\t : %10.3f\n", hit_percent);
+    }
+
+    if (sys->ipf[0] && SIM_MODE == SIM_MODE_DEF)
+    {
+        for (unsigned int i = 0; i < NUM_CORES; i++)
+        {
+            char header[16];
+            snprintf(header, sizeof(header), "ICACHE_%u", i);
+            ipf_print_stats(sys->ipf[i], sys->icache_coreid[i], header);
+        }
+    }
+    else if (sys->ipf[0])
+    {
+        ipf_print_stats(sys->ipf[0], sys->icache, "ICACHE");
+    }
+
+    if (sys->l2pf)
+    {
+        temporal_print_stats(sys->l2pf);
+    }
+
+    if (sys->dbi)
+    {
+        printf("\n");
+        printf("L2CACHE_WB_EAGER     \t\t : %10llu\n", sys->stat_wb_eager);
+        printf("L2CACHE_WB_ROW       \t\t : %10llu\n", sys->stat_wb_row);
+    }
 }
@@ -7,6 +7,27 @@
 #include "types.h"
 #include "cache.h"
 #include "dram.h"
+#include "nuca.h"
+#include "dbi.h"
+#include "temporal.h"
+#include "iprefetch.h"
+#include "setsample.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The largest number of cores a memory system serves. */
+#define MAX_CORES 2
+
+/** The hit time of the data cache in cycles. */
+#define DCACHE_HIT_LATENCY 1
+
+/** The hit time of the instruction cache in cycles. */
+#define ICACHE_HIT_LATENCY 1
+
+/** The hit time of the L2 cache in cycles. */
+#define L2CACHE_HIT_LATENCY 10
 
 ///////////////////////////////////////////////////////////////////////////////
 //                              DATA STRUCTURES                              //
@@ -22,16 +43,26 @@ typedef struct MemorySystem
     /**
      * The data caches for each core in a multicore system.
      */
-    Cache *dcache_coreid[2];
+    Cache *dcache_coreid[MAX_CORES];
     /**
      * The instruction caches for each core in a multicore system. 
      */
-    Cache *icache_coreid[2];
+    Cache *icache_coreid[MAX_CORES];
 
     /** The shared L2 cache. */
     Cache *l2cache;
     /** The DRAM module. */
     DRAM *dram;
+    /** The banks of the L2 cache, when it has non-uniform latency. */
+    Nuca *nuca;
+    /** The dirty lines of the L2 cache by DRAM row, for early writebacks. */
+    Dbi *dbi;
+    /** The temporal prefetcher of the L2 cache. */
+    TemporalPrefetcher *l2pf;
+    /** The prefetchers of the instruction caches, one for each core. */
+    IcachePrefetcher *ipf[MAX_CORES];
+    /** The sets of the L2 cache simulated, when not all of them are. */
+    SetSample *l2_sample;
 
     /**
      * The total number of times the memory system was accessed for an
@@ -60,6 +91,20 @@ typedef struct MemorySystem
      * The total number of cycles spent on data stores. 
      */
     uint64_t stat_store_delay;
+
+    /**
+     * The total number of demand accesses to the L2 cache in pinned ranges,
+     * and how many of them hit.
+     */
+    unsigned long long stat_pin_access;
+    unsigned long long stat_pin_hits;
+
+    /**
+     * The total number of dirty L2 lines written back while the DRAM was
+     * idle, and along with a writeback to the same DRAM row.
+     */
+    unsigned long long stat_wb_eager;
+    unsigned long long stat_wb_row;
 } MemorySystem;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -80,10 +125,11 @@ MemorySystem *memsys_new();
  * @param addr The address to access (in bytes).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param pc The address of the instruction that made the access.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access(MemorySystem *sys, uint64_t addr, AccessType type,
-                       unsigned int core_id);
+                       unsigned int core_id, uint64_t pc);
 
 /**
  * In mode A, access the given memory address from a load or store.
@@ -107,10 +153,12 @@ uint64_t memsys_access_modeA(MemorySystem *sys, uint64_t line_addr,
  *                  cache line size, i.e., excluding the line offset bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param pc The address of the instruction that made the access.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
-                              AccessType type, unsigned int core_id);
+                              AccessType type, unsigned int core_id,
+                              uint64_t pc);
 
 /**
  * Access the given address through the shared L2 cache.
@@ -121,10 +169,13 @@ uint64_t memsys_access_modeBC(MemorySystem *sys, uint64_t line_addr,
  *                  offset bits).
  * @param is_writeback Whether this access is a writeback from an L1 cache.
  * @param core_id The CPU core ID that requested this access.
+ * @param pc The address of the instruction whose L1 miss caused the access,
+ *           or 0 for a writeback.
  * @return The delay in cycles incurred by this access.
  */
 uint64_t memsys_l2_access(MemorySystem *sys, uint64_t line_addr,
-                          bool is_writeback, unsigned int core_id);
+                          bool is_writeback, unsigned int core_id,
+                          uint64_t pc);
 
 /**
  * In mode D, E, or F, access the given virtual address from an instruction
@@ -136,10 +187,25 @@ uint64_t memsys_l2_access(MemorySystem *sys, uint64_t line_addr,
  *                    bits).
  * @param type The type of memory access.
  * @param core_id The CPU core ID that requested this access.
+ * @param pc The address of the instruction that made the access.
  * @return The delay in cycles incurred by this memory access.
  */
 uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
-                               AccessType type, unsigned int core_id);
+                               AccessType type, unsigned int core_id,
+                               uint64_t pc);
+
+/**
+ * Convert the given virtual cache line address to its physical cache line
+ * address.
+ *
+ * @param sys The memory system being used.
+ * @param v_line_addr The virtual address of the cache line (in units of the
+ *                    cache line size).
+ * @param core_id The CPU core ID that requested this access.
+ * @return The physical address of the cache line.
+ */
+uint64_t memsys_translate_line_addr(MemorySystem *sys, uint64_t v_line_addr,
+                                    unsigned int core_id);
 
 /**
  * Convert the given virtual page number (VPN) to its corresponding physical
@@ -153,6 +219,88 @@ uint64_t memsys_access_modeDEF(MemorySystem *sys, uint64_t v_line_addr,
 uint64_t memsys_convert_vpn_to_pfn(MemorySystem *sys, uint64_t vpn,
                                    unsigned int core_id);
 
+/**
+ * Let the fetch-directed prefetcher of a core see an instruction of its
+ * upcoming fetch stream, and prefetch its line into the instruction cache
+ * if it is not there.
+ *
+ * @param sys The memory system.
+ * @param addr The address of the instruction (in bytes).
+ * @param core_id The CPU core ID that will fetch the instruction.
+ */
+void memsys_fetch_directed(MemorySystem *sys, uint64_t addr,
+                           unsigned int core_id);
+
+/**
+ * Ask the host to prefetch the simulated state that a future access to the
+ * given address will touch: the L1 and L2 sets and the DRAM row buffer.
+ *
+ * This does not change any simulated state.
+ *
+ * @param sys The memory system that will be accessed.
+ * @param addr The address that will be accessed (in bytes).
+ * @param type The type of the future memory access.
+ * @param core_id The CPU core ID that will request the access.
+ */
+void memsys_host_prefetch(MemorySystem *sys, uint64_t addr, AccessType type,
+                          unsigned int core_id);
+
+/**
+ * While warming the empty caches from a trace scanned backwards, place the
+ * line of the given access in each cache it would have reached.
+ *
+ * The L2 cache is filled with every access, not only those that miss in the
+ * L1 caches, and is marked dirty by stores whose line the L1 data cache does
+ * not hold, since those were written back.
+ *
+ * @param sys The memory system to warm.
+ * @param addr The address accessed (in bytes).
+ * @param type The type of memory access.
+ * @param core_id The CPU core ID that made the access.
+ * @return Whether every set of every cache is now full.
+ */
+bool memsys_reverse_fill(MemorySystem *sys, uint64_t addr, AccessType type,
+                         unsigned int core_id);
+
+/**
+ * Normalise the LRU state of every cache after warming them with a clock that
+ * the detailed simulation will restart. See cache_normalize_lru().
+ *
+ * @param sys The memory system to normalise.
+ */
+void memsys_normalize_lru(MemorySystem *sys);
+
+/**
+ * Restart the clock of the DRAM after warming the caches with a clock that
+ * the detailed simulation will restart. See dram_reset_clock().
+ *
+ * @param sys The memory system whose DRAM clock restarts.
+ */
+void memsys_reset_clock(MemorySystem *sys);
+
+/**
+ * Reset the statistics of the memory system and all of its components.
+ *
+ * @param sys The memory system to reset the statistics of.
+ */
+void memsys_clear_stats(MemorySystem *sys);
+
+/**
+ * Add the statistics of one memory system to those of another with the same
+ * configuration.
+ *
+ * @param dst The memory system whose statistics are increased.
+ * @param src The memory system whose statistics are added.
+ */
+void memsys_add_stats(MemorySystem *dst, const MemorySystem *src);
+
+/**
+ * Free the memory system and all of its components.
+ *
+ * @param sys The memory system to free.
+ */
+void memsys_free(MemorySystem *sys);
+
 /**
  * Print the statistics of the memory system.
  * 
@@ -0,0 +1,240 @@
+// nuca.cpp
+// Defines the non-uniform access latency of a banked L2 cache.
+
+#include "nuca.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** How the L2 cache is split into banks. */
+extern NucaMode NUCA_MODE;
+
+/** The number of L2 cache banks. */
+extern unsigned int NUCA_BANKS;
+
+/** The latency of one hop between adjacent banks, in cycles. */
+extern unsigned int NUCA_HOP_LATENCY;
+
+/** The number of cores being simulated. */
+extern unsigned int NUM_CORES;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize the banks of the L2 cache.
+ *
+ * @return A pointer to the bank layout.
+ */
+Nuca *nuca_new()
+{
+    Nuca *n = (Nuca *)calloc(1, sizeof(Nuca));
+    n->banks = NUCA_BANKS;
+
+    // Spread the cores evenly along the chain, from one end to the other.
+    for (unsigned int i = 0; i < NUM_CORES && i < NUCA_MAX_CORES; i++)
+    {
+        n->core_bank[i] = (NUM_CORES > 1)
+                              ? i * (n->banks - 1) / (NUM_CORES - 1)
+                              : 0;
+    }
+    return n;
+}
+
+static unsigned int distance(unsigned int a, unsigned int b)
+{
+    return (a > b) ? a - b : b - a;
+}
+
+/** The bank holding a way, in D-NUCA. */
+static unsigned int way_bank(const Nuca *n, const Cache *l2, unsigned int way)
+{
+    return way * n->banks / l2->ways;
+}
+
+/** The bank of a core's chain farthest from it. */
+static unsigned int far_bank(const Nuca *n, unsigned int core_id)
+{
+    return (n->core_bank[core_id] * 2 < n->banks - 1) ? n->banks - 1 : 0;
+}
+
+/** Find the way holding the given line, or -1. */
+static int find_way(const Cache *l2, unsigned int set, uint64_t line_addr,
+                    unsigned int core_id)
+{
+    unsigned long tag = line_addr >> l2->index_bits;
+    const CacheLine *row = l2->cacheGrid[set].row;
+    for (unsigned int w = 0; w < l2->ways; w++)
+    {
+        if (row[w].valid && row[w].coreID == core_id && row[w].tag == tag)
+        {
+            return (int)w;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Swap the line in way w with the least recently used line of the given
+ * bank, which is where it ends up.
+ */
+static void move_to_bank(const Nuca *n, Cache *l2, unsigned int set,
+                         unsigned int w, unsigned int bank)
+{
+    CacheLine *row = l2->cacheGrid[set].row;
+    int target = -1;
+    for (unsigned int v = 0; v < l2->ways; v++)
+    {
+        if (way_bank(n, l2, v) != bank)
+        {
+            continue;
+        }
+        if (!row[v].valid)
+        {
+            target = (int)v;
+            break;
+        }
+        if (target < 0 || row[v].lastAccessTime < row[target].lastAccessTime)
+        {
+            target = (int)v;
+        }
+    }
+
+    if (target >= 0 && (unsigned int)target != w)
+    {
+        CacheLine tmp = row[w];
+        row[w] = row[target];
+        row[target] = tmp;
+    }
+}
+
+/**
+ * Find the bank a request for the given line goes to, count its hops, and in
+ * D-NUCA move a hit line one bank closer to the requesting core. Call before
+ * the L2 cache is accessed.
+ *
+ * @param n The bank layout.
+ * @param l2 The L2 cache.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param is_writeback Whether the request is a writeback from an L1 cache,
+ *                     which neither counts nor moves lines.
+ * @param core_id The CPU core ID that made the request.
+ * @return The extra latency in cycles of reaching the bank and back.
+ */
+uint64_t nuca_access(Nuca *n, Cache *l2, uint64_t line_addr,
+                     bool is_writeback, unsigned int core_id)
+{
+    unsigned int set = (line_addr & l2->index_mask) % l2->sets;
+    unsigned int home = n->core_bank[core_id];
+    unsigned int bank;
+
+    if (NUCA_MODE == NUCA_STATIC)
+    {
+        bank = set % n->banks;
+    }
+    else
+    {
+        // All banks are searched at once; a miss is known once the farthest
+        // one answers.
+        int way = find_way(l2, set, line_addr, core_id);
+        bank = (way < 0) ? far_bank(n, core_id)
+                         : way_bank(n, l2, (unsigned int)way);
+
+        if (way >= 0 && !is_writeback && bank != home)
+        {
+            unsigned int closer = (bank < home) ? bank + 1 : bank - 1;
+            move_to_bank(n, l2, set, (unsigned int)way, closer);
+            n->stat_migrations++;
+        }
+    }
+
+    unsigned int hops = distance(home, bank);
+    if (!is_writeback)
+    {
+        n->stat_hops[core_id] += hops;
+        n->stat_requests[core_id]++;
+    }
+    return 2 * (uint64_t)hops * NUCA_HOP_LATENCY;
+}
+
+/**
+ * In D-NUCA, move a line just installed into the L2 cache to the bank
+ * farthest from the requesting core.
+ *
+ * @param n The bank layout.
+ * @param l2 The L2 cache.
+ * @param line_addr The address of the installed line (in units of the cache
+ *                  line size).
+ * @param core_id The CPU core ID that installed it.
+ */
+void nuca_install(Nuca *n, Cache *l2, uint64_t line_addr,
+                  unsigned int core_id)
+{
+    if (NUCA_MODE != NUCA_DYNAMIC)
+    {
+        return;
+    }
+
+    unsigned int set = (line_addr & l2->index_mask) % l2->sets;
+    int way = find_way(l2, set, line_addr, core_id);
+    unsigned int tail = far_bank(n, core_id);
+    if (way >= 0 && way_bank(n, l2, (unsigned int)way) != tail)
+    {
+        move_to_bank(n, l2, set, (unsigned int)way, tail);
+    }
+}
+
+/**
+ * Reset the statistics of the bank layout.
+ *
+ * @param n The bank layout.
+ */
+void nuca_clear_stats(Nuca *n)
+{
+    memset(n->stat_hops, 0, sizeof(n->stat_hops));
+    memset(n->stat_requests, 0, sizeof(n->stat_requests));
+    n->stat_migrations = 0;
+}
+
+/**
+ * Add the statistics of one bank layout to those of another.
+ *
+ * @param dst The bank layout whose statistics are increased.
+ * @param src The bank layout whose statistics are added.
+ */
+void nuca_add_stats(Nuca *dst, const Nuca *src)
+{
+    for (unsigned int i = 0; i < NUCA_MAX_CORES; i++)
+    {
+        dst->stat_hops[i] += src->stat_hops[i];
+        dst->stat_requests[i] += src->stat_requests[i];
+    }
+    dst->stat_migrations += src->stat_migrations;
+}
+
+/**
+ * Print the average hop count of each core and the number of migrations.
+ *
+ * @param n The bank layout.
+ */
+void nuca_print_stats(Nuca *n)
+{
+    printf("\n");
+    for (unsigned int i = 0; i < NUM_CORES && i < NUCA_MAX_CORES; i++)
+    {
+        double avg_hops = 0.0;
+        if (n->stat_requests[i])
+        {
+            avg_hops = (double)(n->stat_hops[i]) /
+                       (double)(n->stat_requests[i]);
+        }
+        printf("NUCA_CORE_%01u_AVG_HOPS \t\t : %10.3f\n", i, avg_hops);
+    }
+    printf("NUCA_MIGRATIONS      \t\t : %10llu\n", n->stat_migrations);
+}
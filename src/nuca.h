@@ -0,0 +1,113 @@
+// nuca.h
+// Declares the non-uniform access latency of a banked L2 cache.
+
+#ifndef __NUCA_H__
+#define __NUCA_H__
+
+#include "types.h"
+#include "cache.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The largest number of cores whose hop counts are tracked. */
+#define NUCA_MAX_CORES 16
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Possible organisations of the L2 cache banks. */
+typedef enum NucaModeEnum
+{
+    NUCA_OFF = 0,     // One bank with a uniform hit latency.
+    NUCA_STATIC = 1,  // S-NUCA: each set lives in a fixed bank.
+    NUCA_DYNAMIC = 2, // D-NUCA: the ways of a set are spread over the banks,
+                      // and lines move toward the core that hits them.
+} NucaMode;
+
+/**
+ * The banks of the L2 cache, laid out on a chain that the cores attach to at
+ * evenly spaced positions. An access pays a round trip of hops to the bank
+ * that holds (or would hold) the line.
+ */
+typedef struct Nuca
+{
+    unsigned int banks;
+
+    /** The bank each core attaches to. */
+    unsigned int core_bank[NUCA_MAX_CORES];
+
+    /** The total hops and number of requests of each core. */
+    unsigned long long stat_hops[NUCA_MAX_CORES];
+    unsigned long long stat_requests[NUCA_MAX_CORES];
+
+    /** The number of lines moved one bank closer to a core. */
+    unsigned long long stat_migrations;
+} Nuca;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize the banks of the L2 cache.
+ *
+ * @return A pointer to the bank layout.
+ */
+Nuca *nuca_new();
+
+/**
+ * Find the bank a request for the given line goes to, count its hops, and in
+ * D-NUCA move a hit line one bank closer to the requesting core. Call before
+ * the L2 cache is accessed.
+ *
+ * @param n The bank layout.
+ * @param l2 The L2 cache.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @param is_writeback Whether the request is a writeback from an L1 cache,
+ *                     which neither counts nor moves lines.
+ * @param core_id The CPU core ID that made the request.
+ * @return The extra latency in cycles of reaching the bank and back.
+ */
+uint64_t nuca_access(Nuca *n, Cache *l2, uint64_t line_addr,
+                     bool is_writeback, unsigned int core_id);
+
+/**
+ * In D-NUCA, move a line just installed into the L2 cache to the bank
+ * farthest from the requesting core.
+ *
+ * @param n The bank layout.
+ * @param l2 The L2 cache.
+ * @param line_addr The address of the installed line (in units of the cache
+ *                  line size).
+ * @param core_id The CPU core ID that installed it.
+ */
+void nuca_install(Nuca *n, Cache *l2, uint64_t line_addr,
+                  unsigned int core_id);
+
+/**
+ * Reset the statistics of the bank layout.
+ *
+ * @param n The bank layout.
+ */
+void nuca_clear_stats(Nuca *n);
+
+/**
+ * Add the statistics of one bank layout to those of another.
+ *
+ * @param dst The bank layout whose statistics are increased.
+ * @param src The bank layout whose statistics are added.
+ */
+void nuca_add_stats(Nuca *dst, const Nuca *src);
+
+/**
+ * Print the average hop count of each core and the number of migrations.
+ *
+ * @param n The bank layout.
+ */
+void nuca_print_stats(Nuca *n);
+
+#endif // __NUCA_H__
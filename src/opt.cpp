@@ -0,0 +1,346 @@
+// opt.cpp
+// Defines the oracle that lets a cache evict the line reused furthest in the
+// future (Belady's MIN), from a pre-pass over the trace.
+//
+// The access stream of a cache in a single-core simulation depends only on
+// the trace and on the replacement decisions of the caches above it, not on
+// timing. So a cache's stream can be recorded by a functional pass, once the
+// caches above it replace lines exactly as they will in the simulation.
+
+#include "opt.h"
+#include "core.h"
+#include "tracecache.h"
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The caches that may use OPT, each recorded in the pass of its level. */
+#define OPT_ROLES 3
+#define OPT_ROLE_DCACHE 0
+#define OPT_ROLE_ICACHE 1
+#define OPT_ROLE_L2CACHE 2
+
+/** The number of levels of caches, and so of recording passes. */
+#define OPT_LEVELS 2
+
+static const unsigned int role_level[OPT_ROLES] = {0, 0, 1};
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The current clock cycle number. */
+extern thread_local uint64_t current_cycle;
+
+///////////////////////////////////////////////////////////////////////////////
+//                              GLOBAL VARIABLES                             //
+///////////////////////////////////////////////////////////////////////////////
+
+static OptOracle *oracles[OPT_ROLES];
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+static Cache *role_cache(MemorySystem *sys, unsigned int role)
+{
+    Cache *c = NULL;
+    if (role == OPT_ROLE_DCACHE)
+        c = sys->dcache;
+    if (role == OPT_ROLE_ICACHE)
+        c = sys->icache;
+    if (role == OPT_ROLE_L2CACHE)
+        c = sys->l2cache;
+    return (c && c->policy == OPT) ? c : NULL;
+}
+
+/**
+ * Attach an oracle to a cache, starting its replay (or recording) from the
+ * first access.
+ */
+static void opt_attach(Cache *c, OptOracle *o)
+{
+    free(o->line_next_use);
+    o->line_next_use = (uint64_t *)malloc((uint64_t)c->sets * c->ways *
+                                          sizeof(uint64_t));
+    for (uint64_t i = 0; i < (uint64_t)c->sets * c->ways; i++)
+    {
+        o->line_next_use[i] = OPT_NEVER;
+    }
+
+    o->pending_next_use = OPT_NEVER;
+    o->block_len = 0;
+    o->block_pos = 0;
+    o->pos = 0;
+    fseeko(o->addr_file, 0, SEEK_SET);
+    fseeko(o->dist_file, 0, SEEK_SET);
+    c->opt = o;
+}
+
+static OptOracle *opt_new()
+{
+    OptOracle *o = (OptOracle *)calloc(1, sizeof(OptOracle));
+    o->recording = true;
+    o->addr_file = tmpfile();
+    o->dist_file = tmpfile();
+    if (o->addr_file == NULL || o->dist_file == NULL)
+    {
+        perror("Couldn't create OPT oracle file");
+        return NULL;
+    }
+    return o;
+}
+
+static bool opt_flush(OptOracle *o)
+{
+    bool ok = fwrite(o->addr_block, sizeof(uint32_t), o->block_len,
+                     o->addr_file) == o->block_len;
+    o->block_len = 0;
+    return ok;
+}
+
+/**
+ * Compute the reuse distance of every recorded access by scanning the
+ * addresses backwards one block at a time, then switch to replaying.
+ */
+static bool opt_build(OptOracle *o)
+{
+    if (!opt_flush(o))
+    {
+        perror("Couldn't write OPT oracle file");
+        return false;
+    }
+
+    // The index of the next access to each line seen so far.
+    std::unordered_map<uint32_t, uint64_t> next_access;
+
+    uint64_t n = o->num_accesses;
+    uint64_t blocks = (n + OPT_BLOCK_ENTRIES - 1) / OPT_BLOCK_ENTRIES;
+    for (uint64_t b = blocks; b-- > 0;)
+    {
+        uint64_t first = b * OPT_BLOCK_ENTRIES;
+        unsigned int len = (n - first < OPT_BLOCK_ENTRIES)
+                               ? (unsigned int)(n - first)
+                               : OPT_BLOCK_ENTRIES;
+
+        fseeko(o->addr_file, first * sizeof(uint32_t), SEEK_SET);
+        if (fread(o->addr_block, sizeof(uint32_t), len, o->addr_file) != len)
+        {
+            perror("Couldn't read OPT oracle file");
+            return false;
+        }
+
+        for (unsigned int k = len; k-- > 0;)
+        {
+            uint64_t i = first + k;
+            uint32_t dist = UINT32_MAX;
+            auto it = next_access.find(o->addr_block[k]);
+            if (it != next_access.end())
+            {
+                dist = (it->second - i < UINT32_MAX)
+                           ? (uint32_t)(it->second - i)
+                           : UINT32_MAX;
+                it->second = i;
+            }
+            else
+            {
+                next_access[o->addr_block[k]] = i;
+            }
+            o->dist_block[k] = dist;
+        }
+
+        fseeko(o->dist_file, first * sizeof(uint32_t), SEEK_SET);
+        if (fwrite(o->dist_block, sizeof(uint32_t), len, o->dist_file) != len)
+        {
+            perror("Couldn't write OPT oracle file");
+            return false;
+        }
+    }
+
+    fflush(o->dist_file);
+    o->recording = false;
+    return true;
+}
+
+/**
+ * Run the whole trace through a memory system, one cycle per instruction,
+ * making the accesses that core_cycle() would make.
+ */
+static int opt_record_pass(MemorySystem *sys, const char *trace_filename)
+{
+    Core *core = core_new(sys, trace_filename, 0);
+    if (core == NULL)
+    {
+        return 1;
+    }
+
+    // Caches using random replacement must draw the same numbers as they will
+    // in the simulation.
+    cache_seed_random(42);
+
+    for (uint64_t n = 1; !core->done; n++)
+    {
+        current_cycle = n;
+        memsys_access(sys, core->trace_inst_addr, ACCESS_TYPE_IFETCH,
+                      core->core_id, core->trace_inst_addr);
+        if (core->trace_inst_type == INST_TYPE_LOAD)
+        {
+            memsys_access(sys, core->trace_ldst_addr, ACCESS_TYPE_LOAD,
+                          core->core_id, core->trace_inst_addr);
+        }
+        if (core->trace_inst_type == INST_TYPE_STORE)
+        {
+            memsys_access(sys, core->trace_ldst_addr, ACCESS_TYPE_STORE,
+                          core->core_id, core->trace_inst_addr);
+        }
+        core_read_trace(core);
+    }
+    current_cycle = 0;
+
+    if (core->trace_cache)
+    {
+        tracecache_close(core->trace_cache);
+    }
+    else
+    {
+        close(core->trace_fd);
+        waitpid(core->pid, NULL, 0);
+    }
+    free(core);
+    return 0;
+}
+
+/**
+ * If any cache of the memory system uses the OPT replacement policy, run the
+ * trace through scratch copies of the memory system to learn the future
+ * accesses of those caches, and attach the results to them.
+ *
+ * The L1 caches are recorded first; the L2 cache is recorded in a second pass
+ * whose L1 caches already replace lines as they will in the simulation.
+ *
+ * @param sys The memory system about to be simulated.
+ * @param trace_filename The trace file of the (only) core.
+ * @return 0 on success, or nonzero on error.
+ */
+int opt_prepare(MemorySystem *sys, const char *trace_filename)
+{
+    bool needed = false;
+    for (unsigned int role = 0; role < OPT_ROLES; role++)
+    {
+        needed = needed || role_cache(sys, role) != NULL;
+    }
+    if (!needed)
+    {
+        return 0;
+    }
+
+    for (unsigned int level = 0; level < OPT_LEVELS; level++)
+    {
+        // Caches below the level being recorded fall back to LRU, since they
+        // have no oracle; their accesses are discarded with the pass.
+        MemorySystem *scratch = memsys_new();
+        bool recording = false;
+        for (unsigned int role = 0; role < OPT_ROLES; role++)
+        {
+            Cache *c = role_cache(scratch, role);
+            if (c == NULL || role_level[role] > level)
+            {
+                continue;
+            }
+            if (role_level[role] == level)
+            {
+                oracles[role] = opt_new();
+                if (oracles[role] == NULL)
+                {
+                    return 1;
+                }
+                recording = true;
+            }
+            opt_attach(c, oracles[role]);
+        }
+
+        int status = recording ? opt_record_pass(scratch, trace_filename) : 0;
+        memsys_free(scratch);
+        if (status != 0)
+        {
+            return status;
+        }
+
+        for (unsigned int role = 0; role < OPT_ROLES; role++)
+        {
+            if (oracles[role] && role_level[role] == level &&
+                !opt_build(oracles[role]))
+            {
+                return 1;
+            }
+        }
+    }
+
+    for (unsigned int role = 0; role < OPT_ROLES; role++)
+    {
+        if (oracles[role])
+        {
+            opt_attach(role_cache(sys, role), oracles[role]);
+        }
+    }
+
+    cache_seed_random(42);
+    return 0;
+}
+
+/**
+ * Record an access to a cache with the OPT policy, or while replaying, find
+ * out when its line is next used.
+ *
+ * @param o The oracle of the cache.
+ * @param line_addr The address of the cache line accessed (in units of the
+ *                  cache line size).
+ * @return The index of the next access to the same line, or OPT_NEVER.
+ */
+uint64_t opt_observe(OptOracle *o, uint64_t line_addr)
+{
+    if (o->recording)
+    {
+        if (o->block_len == OPT_BLOCK_ENTRIES && !opt_flush(o))
+        {
+            perror("Couldn't write OPT oracle file");
+            exit(1);
+        }
+        o->addr_block[o->block_len++] = (uint32_t)line_addr;
+        o->num_accesses++;
+        return OPT_NEVER;
+    }
+
+    if (o->block_pos == o->block_len)
+    {
+        uint64_t left = o->num_accesses - o->pos;
+        unsigned int len = (left < OPT_BLOCK_ENTRIES) ? (unsigned int)left
+                                                      : OPT_BLOCK_ENTRIES;
+        if (len == 0 ||
+            fread(o->addr_block, sizeof(uint32_t), len, o->addr_file) != len ||
+            fread(o->dist_block, sizeof(uint32_t), len, o->dist_file) != len)
+        {
+            fprintf(stderr, "Error: OPT oracle ran out of recorded accesses\n");
+            exit(1);
+        }
+        o->block_len = len;
+        o->block_pos = 0;
+    }
+
+    if (o->addr_block[o->block_pos] != (uint32_t)line_addr)
+    {
+        fprintf(stderr, "Error: access %llu does not match the OPT pre-pass\n",
+                (unsigned long long)o->pos);
+        exit(1);
+    }
+
+    uint32_t dist = o->dist_block[o->block_pos++];
+    uint64_t next_use = (dist == UINT32_MAX) ? OPT_NEVER : o->pos + dist;
+    o->pos++;
+    return next_use;
+}
@@ -0,0 +1,95 @@
+// opt.h
+// Declares the oracle that lets a cache evict the line reused furthest in the
+// future (Belady's MIN), from a pre-pass over the trace.
+
+#ifndef __OPT_H__
+#define __OPT_H__
+
+#include "types.h"
+#include "memsys.h"
+#include <stdio.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The number of accesses read or written at once from the oracle files. */
+#define OPT_BLOCK_ENTRIES (64 * 1024)
+
+/** The next use of a line that is never used again. */
+#define OPT_NEVER UINT64_MAX
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The future accesses of one cache.
+ *
+ * A pre-pass records the line address of every access the cache receives.
+ * The addresses are then scanned backwards to find, for each access, how many
+ * accesses later its line is used again. During the simulation proper the
+ * cache reads both streams forward, one block at a time, so memory use does
+ * not grow with the length of the trace.
+ */
+typedef struct OptOracle
+{
+    /** Whether accesses are being recorded rather than replayed. */
+    bool recording;
+
+    /** The line address of each access, in order. */
+    FILE *addr_file;
+
+    /**
+     * For each access, the number of accesses until its line is next used,
+     * or UINT32_MAX if it never is (or not within 2^32 accesses).
+     */
+    FILE *dist_file;
+
+    /** The block of each stream being written or read. */
+    uint32_t addr_block[OPT_BLOCK_ENTRIES];
+    uint32_t dist_block[OPT_BLOCK_ENTRIES];
+    unsigned int block_len;
+    unsigned int block_pos;
+
+    /** The number of accesses replayed so far, and recorded in total. */
+    uint64_t pos;
+    uint64_t num_accesses;
+
+    /** For each line of the cache, the access that next uses it. */
+    uint64_t *line_next_use;
+
+    /** The next use of the line that the last (missing) access installs. */
+    uint64_t pending_next_use;
+} OptOracle;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * If any cache of the memory system uses the OPT replacement policy, run the
+ * trace through scratch copies of the memory system to learn the future
+ * accesses of those caches, and attach the results to them.
+ *
+ * The L1 caches are recorded first; the L2 cache is recorded in a second pass
+ * whose L1 caches already replace lines as they will in the simulation.
+ *
+ * @param sys The memory system about to be simulated.
+ * @param trace_filename The trace file of the (only) core.
+ * @return 0 on success, or nonzero on error.
+ */
+int opt_prepare(MemorySystem *sys, const char *trace_filename);
+
+/**
+ * Record an access to a cache with the OPT policy, or while replaying, find
+ * out when its line is next used.
+ *
+ * @param o The oracle of the cache.
+ * @param line_addr The address of the cache line accessed (in units of the
+ *                  cache line size).
+ * @return The index of the next access to the same line, or OPT_NEVER.
+ */
+uint64_t opt_observe(OptOracle *o, uint64_t line_addr);
+
+#endif // __OPT_H__
@@ -0,0 +1,74 @@
+// pin.cpp
+// Defines the address ranges whose lines are pinned in the L2 cache.
+
+#include "pin.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The number of bytes in a cache line. */
+extern uint64_t CACHE_LINESIZE;
+
+/** The address ranges pinned in the L2 cache. */
+extern PinRange PIN_RANGES[MAX_PIN_RANGES];
+
+/** The number of pinned address ranges. */
+extern unsigned int NUM_PIN_RANGES;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Add a range of addresses whose lines are pinned in the L2 cache.
+ *
+ * @param core_id The CPU core ID whose accesses the range applies to.
+ * @param is_virtual Whether the range is of virtual addresses.
+ * @param begin The first byte address of the range.
+ * @param end The byte address one past the end of the range.
+ * @return Whether the range was added; false if it is empty or the table of
+ *         ranges is full.
+ */
+bool pin_add_range(unsigned int core_id, bool is_virtual, uint64_t begin,
+                   uint64_t end)
+{
+    if (begin >= end || NUM_PIN_RANGES >= MAX_PIN_RANGES)
+    {
+        return false;
+    }
+
+    PinRange *r = &PIN_RANGES[NUM_PIN_RANGES++];
+    r->core_id = core_id;
+    r->is_virtual = is_virtual;
+    r->begin = begin;
+    r->end = end;
+    return true;
+}
+
+/**
+ * Check whether a cache line lies (partly) in a pinned range.
+ *
+ * @param v_line_addr The virtual address of the cache line (in units of the
+ *                    cache line size).
+ * @param p_line_addr The physical address of the cache line (in units of the
+ *                    cache line size).
+ * @param core_id The CPU core ID that accessed the line.
+ * @return Whether the line is to be pinned.
+ */
+bool pin_contains(uint64_t v_line_addr, uint64_t p_line_addr,
+                  unsigned int core_id)
+{
+    for (unsigned int i = 0; i < NUM_PIN_RANGES; i++)
+    {
+        const PinRange *r = &PIN_RANGES[i];
+        uint64_t line_addr = r->is_virtual ? v_line_addr : p_line_addr;
+        if (r->core_id == core_id &&
+            line_addr * CACHE_LINESIZE < r->end &&
+            (line_addr + 1) * CACHE_LINESIZE > r->begin)
+        {
+            return true;
+        }
+    }
+    return false;
+}
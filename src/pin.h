@@ -0,0 +1,66 @@
+// pin.h
+// Declares the address ranges whose lines are pinned in the L2 cache.
+
+#ifndef __PIN_H__
+#define __PIN_H__
+
+#include "types.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The largest number of pinned address ranges. */
+#define MAX_PIN_RANGES 16
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** A range of addresses of one core whose lines are pinned in the L2 cache. */
+typedef struct PinRange
+{
+    unsigned int core_id;
+
+    /**
+     * Whether the range is of virtual addresses, which are translated page by
+     * page in modes D through F, rather than physical ones.
+     */
+    bool is_virtual;
+
+    /** The first byte address of the range, and the one past its end. */
+    uint64_t begin;
+    uint64_t end;
+} PinRange;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Add a range of addresses whose lines are pinned in the L2 cache.
+ *
+ * @param core_id The CPU core ID whose accesses the range applies to.
+ * @param is_virtual Whether the range is of virtual addresses.
+ * @param begin The first byte address of the range.
+ * @param end The byte address one past the end of the range.
+ * @return Whether the range was added; false if it is empty or the table of
+ *         ranges is full.
+ */
+bool pin_add_range(unsigned int core_id, bool is_virtual, uint64_t begin,
+                   uint64_t end);
+
+/**
+ * Check whether a cache line lies (partly) in a pinned range.
+ *
+ * @param v_line_addr The virtual address of the cache line (in units of the
+ *                    cache line size).
+ * @param p_line_addr The physical address of the cache line (in units of the
+ *                    cache line size).
+ * @param core_id The CPU core ID that accessed the line.
+ * @return Whether the line is to be pinned.
+ */
+bool pin_contains(uint64_t v_line_addr, uint64_t p_line_addr,
+                  unsigned int core_id);
+
+#endif // __PIN_H__
@@ -0,0 +1,448 @@
+// pipeline.cpp
+// Defines the pipelined multi-threaded engine for the single-core modes.
+//
+// The L1 caches, the L2 cache and the DRAM each run on their own host thread
+// and are linked by single-producer single-consumer queues of miss and
+// writeback events. Each level accumulates the delays it contributes, and the
+// cycle count of the serial simulation is rebuilt from them at the end.
+
+#include "pipeline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The number of events each queue can hold. Must be a power of two. */
+#define PIPELINE_QUEUE_SIZE (1 << 16)
+
+/** The number of events pushed or popped before the shared index is updated. */
+#define PIPELINE_BATCH 256
+
+/** Event kind for a writeback, extending the AccessType values. */
+#define PIPELINE_EVENT_WRITEBACK 3
+
+/** Event kind marking the end of the stream. */
+#define PIPELINE_EVENT_END 4
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The current mode under which the simulation is running.
+ */
+extern Mode SIM_MODE;
+
+/** The number of bytes in a cache line. */
+extern uint64_t CACHE_LINESIZE;
+
+/** The replacement policy to use for the L1 data and instruction caches. */
+extern ReplacementPolicy REPL_POLICY;
+
+/** The replacement policy to use for the L2 cache. */
+extern ReplacementPolicy L2CACHE_REPL;
+
+/** Whether L2CACHE_REPL also applies to the L2 cache in modes B and C. */
+extern bool L2CACHE_REPL_SET;
+
+/** The number of cores being simulated. */
+extern unsigned int NUM_CORES;
+
+/** The current clock cycle number. */
+extern thread_local uint64_t current_cycle;
+
+/** The number of loop iterations in a fast-forward window. */
+extern unsigned int FFWD_WINDOW;
+
+/** The model of the CPU cores. */
+extern CoreModel CORE_MODEL;
+
+/** How the DRAM latency is computed in modes C through F. */
+extern DRAMModel DRAM_MODEL;
+
+/** How the L2 cache is split into banks. */
+extern NucaMode NUCA_MODE;
+
+/** The levels of the L2 zcache replacement walk, or 0 if not a zcache. */
+extern unsigned int L2CACHE_ZCACHE_LEVELS;
+
+/** The number of address ranges pinned in the L2 cache. */
+extern unsigned int NUM_PIN_RANGES;
+
+/** When dirty L2 lines are written back to DRAM. */
+extern L2WritebackPolicy L2CACHE_WB_POLICY;
+
+/** The prefetcher of the L2 cache. */
+extern L2PrefetcherType L2_PREFETCHER;
+
+/** The prefetcher of the instruction caches. */
+extern IcachePrefetcherType ICACHE_PREFETCHER;
+
+/** The RowHammer mitigation of the DRAM. */
+extern RowHammerMitigation RH_MITIGATION;
+
+/** The scheduler that orders the requests of each DRAM bank. */
+extern MemSchedulerType DRAM_SCHED;
+
+/** The idle cycles after which a DRAM rank enters power-down, or 0. */
+extern uint64_t DRAM_PD_THRESHOLD;
+
+/** The idle cycles after which a DRAM rank enters self-refresh, or 0. */
+extern uint64_t DRAM_SR_THRESHOLD;
+
+/** One set of the L2 cache in this many is simulated. */
+extern unsigned int L2CACHE_SAMPLE_RATIO;
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** A miss or writeback sent from one level of the hierarchy to the next. */
+typedef struct PipelineEvent
+{
+    uint64_t line_addr;
+    /** The index of the instruction that caused the event, starting at 1. */
+    uint64_t seq;
+    /** The AccessType of the demand access, or a PIPELINE_EVENT_* value. */
+    uint8_t kind;
+    bool is_write;
+} PipelineEvent;
+
+/**
+ * A lock-free single-producer single-consumer ring of events.
+ *
+ * Each side keeps a private copy of its index and of the other side's index,
+ * and only touches the shared atomics once per batch or when it runs out.
+ */
+typedef struct PipelineQueue
+{
+    PipelineEvent *slots;
+
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+
+    // Consumer side.
+    alignas(64) uint64_t local_head;
+    uint64_t cached_tail;
+
+    // Producer side.
+    alignas(64) uint64_t local_tail;
+    uint64_t cached_head;
+} PipelineQueue;
+
+/** The delays contributed by one level of the hierarchy. */
+typedef struct PipelineStage
+{
+    /** The total delay added to demand accesses, per AccessType. */
+    uint64_t delay[3];
+
+    /** The total stall cycles added to the core by this level. */
+    uint64_t bubble;
+
+    /** The stall cycles added to the most recent instruction seen. */
+    uint64_t last_seq;
+    uint64_t last_seq_bubble;
+} PipelineStage;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+static void queue_init(PipelineQueue *q)
+{
+    q->slots = (PipelineEvent *)calloc(PIPELINE_QUEUE_SIZE,
+                                       sizeof(PipelineEvent));
+    q->head.store(0);
+    q->tail.store(0);
+    q->local_head = 0;
+    q->cached_tail = 0;
+    q->local_tail = 0;
+    q->cached_head = 0;
+}
+
+static void queue_flush(PipelineQueue *q)
+{
+    q->tail.store(q->local_tail, std::memory_order_release);
+}
+
+static void queue_push(PipelineQueue *q, const PipelineEvent *ev)
+{
+    if (q->local_tail - q->cached_head == PIPELINE_QUEUE_SIZE)
+    {
+        queue_flush(q);
+        while ((q->cached_head = q->head.load(std::memory_order_acquire)) +
+                   PIPELINE_QUEUE_SIZE == q->local_tail)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    q->slots[q->local_tail & (PIPELINE_QUEUE_SIZE - 1)] = *ev;
+    q->local_tail++;
+    if (q->local_tail % PIPELINE_BATCH == 0)
+    {
+        queue_flush(q);
+    }
+}
+
+static void queue_pop(PipelineQueue *q, PipelineEvent *ev)
+{
+    if (q->local_head == q->cached_tail)
+    {
+        q->head.store(q->local_head, std::memory_order_release);
+        while ((q->cached_tail = q->tail.load(std::memory_order_acquire)) ==
+               q->local_head)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    *ev = q->slots[q->local_head & (PIPELINE_QUEUE_SIZE - 1)];
+    q->local_head++;
+    if (q->local_head % PIPELINE_BATCH == 0)
+    {
+        q->head.store(q->local_head, std::memory_order_release);
+    }
+}
+
+/**
+ * Charge a delay returned by this level to the demand access of an event.
+ */
+static void stage_charge(PipelineStage *st, const PipelineEvent *ev,
+                         uint64_t delay)
+{
+    st->delay[ev->kind] += delay;
+
+    // Stores do not stall the core.
+    if (ev->kind == ACCESS_TYPE_STORE)
+    {
+        return;
+    }
+
+    if (ev->seq != st->last_seq)
+    {
+        st->last_seq = ev->seq;
+        st->last_seq_bubble = 0;
+    }
+    st->bubble += delay;
+    st->last_seq_bubble += delay;
+}
+
+/**
+ * Issue an L2 event, mirroring the L1 miss handling of memsys_access_modeBC().
+ */
+static void l1_access(Cache *c, PipelineQueue *out, uint64_t line_addr,
+                      AccessType type, uint64_t seq)
+{
+    bool is_write = (type == ACCESS_TYPE_STORE);
+    if (cache_access(c, line_addr, is_write, 0) == HIT)
+    {
+        return;
+    }
+
+    PipelineEvent ev = {line_addr, seq, (uint8_t)type, false};
+    queue_push(out, &ev);
+    cache_install(c, line_addr, is_write, 0);
+
+    if (type != ACCESS_TYPE_IFETCH && c->lastEvictedLine.valid &&
+        c->lastEvictedLine.dirty)
+    {
+        unsigned index = line_addr & c->index_mask;
+        unsigned evicted_address = c->lastEvictedLine.tag << c->index_bits;
+        evicted_address = evicted_address | index;
+
+        PipelineEvent wb = {evicted_address, seq, PIPELINE_EVENT_WRITEBACK,
+                            false};
+        queue_push(out, &wb);
+    }
+}
+
+/**
+ * The L2 thread, mirroring memsys_l2_access().
+ */
+static void l2_stage(Cache *l2, PipelineQueue *in, PipelineQueue *out,
+                     PipelineStage *st)
+{
+    uint64_t clock = 0;
+    l2->clock = &clock;
+
+    PipelineEvent ev;
+    for (;;)
+    {
+        queue_pop(in, &ev);
+        if (ev.kind == PIPELINE_EVENT_END)
+        {
+            break;
+        }
+
+        bool is_writeback = (ev.kind == PIPELINE_EVENT_WRITEBACK);
+        clock = ev.seq;
+        if (!is_writeback)
+        {
+            stage_charge(st, &ev, L2CACHE_HIT_LATENCY);
+        }
+
+        if (cache_access(l2, ev.line_addr, is_writeback, 0) == MISS)
+        {
+            ev.is_write = false;
+            queue_push(out, &ev);
+            cache_install(l2, ev.line_addr, is_writeback, 0);
+            if (l2->lastEvictedLine.valid && l2->lastEvictedLine.dirty)
+            {
+                unsigned index = ev.line_addr & l2->index_mask;
+                unsigned evicted_address =
+                    (l2->lastEvictedLine.tag << l2->index_bits) | index;
+
+                PipelineEvent wb = {evicted_address, ev.seq,
+                                    PIPELINE_EVENT_WRITEBACK, true};
+                queue_push(out, &wb);
+            }
+        }
+    }
+
+    queue_push(out, &ev);
+    queue_flush(out);
+}
+
+/**
+ * The DRAM thread.
+ */
+static void dram_stage(DRAM *dram, PipelineQueue *in, PipelineStage *st)
+{
+    PipelineEvent ev;
+    for (;;)
+    {
+        queue_pop(in, &ev);
+        if (ev.kind == PIPELINE_EVENT_END)
+        {
+            break;
+        }
+
+        uint64_t delay = dram_access(dram, ev.line_addr, ev.is_write);
+        if (ev.kind != PIPELINE_EVENT_WRITEBACK)
+        {
+            stage_charge(st, &ev, delay);
+        }
+    }
+}
+
+/**
+ * Check whether the pipelined engine reproduces the serial simulation for the
+ * current configuration.
+ *
+ * @return Whether pipeline_run() may be used.
+ */
+bool pipeline_supported()
+{
+    return (SIM_MODE == SIM_MODE_B || SIM_MODE == SIM_MODE_C) &&
+           NUM_CORES == 1 && REPL_POLICY == LRU &&
+           (!L2CACHE_REPL_SET || L2CACHE_REPL == LRU) && FFWD_WINDOW == 0 &&
+           CORE_MODEL == CORE_MODEL_INORDER &&
+           DRAM_MODEL == DRAM_MODEL_ROWBUF && NUCA_MODE == NUCA_OFF &&
+           L2CACHE_ZCACHE_LEVELS == 0 && NUM_PIN_RANGES == 0 &&
+           L2CACHE_WB_POLICY == L2_WB_EVICT && L2_PREFETCHER == L2PF_OFF &&
+           ICACHE_PREFETCHER == IPF_OFF && RH_MITIGATION == RH_OFF &&
+           DRAM_PD_THRESHOLD == 0 && DRAM_SR_THRESHOLD == 0 &&
+           DRAM_SCHED == SCHED_OFF && L2CACHE_SAMPLE_RATIO == 1;
+}
+
+/**
+ * Run the trace of the given core to completion, simulating the L1 caches on
+ * the calling thread, the L2 cache on a second thread and the DRAM on a third.
+ *
+ * @param sys The memory system to simulate.
+ * @param core The (only) core, whose trace is consumed.
+ * @return The number of cycles the serial simulation loop would have run.
+ */
+uint64_t pipeline_run(MemorySystem *sys, Core *core)
+{
+    PipelineQueue l2_queue;
+    PipelineQueue dram_queue;
+    PipelineQueue *to_l2 = &l2_queue;
+    PipelineQueue *to_dram = &dram_queue;
+    queue_init(to_l2);
+    queue_init(to_dram);
+
+    PipelineStage l2_st = {};
+    PipelineStage dram_st = {};
+    std::thread l2_thread(l2_stage, sys->l2cache, to_l2, to_dram, &l2_st);
+    std::thread dram_thread(dram_stage, sys->dram, to_dram, &dram_st);
+
+    // The L1 caches see strictly increasing timestamps, one per instruction,
+    // which orders LRU exactly like the cycle numbers of the serial loop.
+    uint64_t seq = 0;
+    sys->icache->clock = &seq;
+    sys->dcache->clock = &seq;
+
+    while (!core->done)
+    {
+        seq++;
+        core->inst_count++;
+
+        l1_access(sys->icache, to_l2, core->trace_inst_addr / CACHE_LINESIZE,
+                  ACCESS_TYPE_IFETCH, seq);
+        sys->stat_ifetch_access++;
+
+        if (core->trace_inst_type == INST_TYPE_LOAD)
+        {
+            l1_access(sys->dcache, to_l2,
+                      core->trace_ldst_addr / CACHE_LINESIZE,
+                      ACCESS_TYPE_LOAD, seq);
+            sys->stat_load_access++;
+        }
+
+        if (core->trace_inst_type == INST_TYPE_STORE)
+        {
+            l1_access(sys->dcache, to_l2,
+                      core->trace_ldst_addr / CACHE_LINESIZE,
+                      ACCESS_TYPE_STORE, seq);
+            sys->stat_store_access++;
+        }
+
+        core_read_trace(core);
+    }
+
+    PipelineEvent end = {0, 0, PIPELINE_EVENT_END, false};
+    queue_push(to_l2, &end);
+    queue_flush(to_l2);
+    l2_thread.join();
+    dram_thread.join();
+
+    sys->stat_ifetch_delay = sys->stat_ifetch_access * ICACHE_HIT_LATENCY +
+                             l2_st.delay[ACCESS_TYPE_IFETCH] +
+                             dram_st.delay[ACCESS_TYPE_IFETCH];
+    sys->stat_load_delay = sys->stat_load_access * DCACHE_HIT_LATENCY +
+                           l2_st.delay[ACCESS_TYPE_LOAD] +
+                           dram_st.delay[ACCESS_TYPE_LOAD];
+    sys->stat_store_delay = sys->stat_store_access * DCACHE_HIT_LATENCY +
+                            l2_st.delay[ACCESS_TYPE_STORE] +
+                            dram_st.delay[ACCESS_TYPE_STORE];
+
+    // The first instruction runs in cycle 1, and each later one runs one cycle
+    // after the previous one plus its stall. The stall of the last instruction
+    // is never waited for, since the core finishes in the cycle it issues.
+    uint64_t bubble = l2_st.bubble + dram_st.bubble;
+    if (l2_st.last_seq == seq)
+    {
+        bubble -= l2_st.last_seq_bubble;
+    }
+    if (dram_st.last_seq == seq)
+    {
+        bubble -= dram_st.last_seq_bubble;
+    }
+
+    core->done_inst_count = core->inst_count;
+    core->done_cycle_count = seq ? seq + bubble : 0;
+
+    sys->icache->clock = &current_cycle;
+    sys->dcache->clock = &current_cycle;
+    sys->l2cache->clock = &current_cycle;
+    free(to_l2->slots);
+    free(to_dram->slots);
+
+    return core->done_cycle_count + 1;
+}
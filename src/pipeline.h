@@ -0,0 +1,40 @@
+// pipeline.h
+// Declares the pipelined multi-threaded engine for the single-core modes.
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include "types.h"
+#include "memsys.h"
+#include "core.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Check whether the pipelined engine reproduces the serial simulation for the
+ * current configuration.
+ *
+ * In modes B and C with a single core and LRU replacement, the contents of the
+ * caches and row buffers do not depend on timing, so the hierarchy can be
+ * simulated level by level and the cycle count reconstructed afterwards.
+ *
+ * @return Whether pipeline_run() may be used.
+ */
+bool pipeline_supported();
+
+/**
+ * Run the trace of the given core to completion, simulating the L1 caches on
+ * the calling thread, the L2 cache on a second thread and the DRAM on a third.
+ *
+ * On return, the statistics of the memory system and the core are the same as
+ * after a serial simulation of the trace.
+ *
+ * @param sys The memory system to simulate.
+ * @param core The (only) core, whose trace is consumed.
+ * @return The number of cycles the serial simulation loop would have run.
+ */
+uint64_t pipeline_run(MemorySystem *sys, Core *core);
+
+#endif // __PIPELINE_H__
@@ -0,0 +1,328 @@
+// rowhammer.cpp
+// Defines the per-bank row activation trackers of the DRAM, and the
+// RowHammer mitigations they drive.
+//
+// Each bank counts the activations of its rows in bounded memory, resetting
+// the counts every refresh window. The Misra-Gries table keeps the rows
+// activated most often and assumes every other row was activated as often as
+// the spillover count; the count-min sketch adds each activation to one
+// counter per hash function and reads the smallest. Both overestimate, so no
+// aggressor row goes unnoticed.
+
+#include "rowhammer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The number of neighbour rows refreshed to protect an aggressor row. */
+#define RH_NEIGHBORS 2
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The RowHammer mitigation of the DRAM. */
+extern RowHammerMitigation RH_MITIGATION;
+
+/** How the activations of the rows of each bank are counted. */
+extern RowHammerTracker RH_TRACKER;
+
+/** The number of counters per bank, or per row of the count-min sketch. */
+extern unsigned int RH_COUNTERS;
+
+/** The activations of a row in one refresh window that make it an aggressor. */
+extern unsigned int RH_THRESHOLD;
+
+/** The probability that PARA refreshes the neighbours of an activated row. */
+extern double RH_PARA_PROB;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize the RowHammer trackers of a DRAM module.
+ *
+ * @param num_banks The number of banks.
+ * @return A pointer to the trackers.
+ */
+RowHammer *rowhammer_new(unsigned int num_banks)
+{
+    unsigned int counters = RH_COUNTERS;
+    if (RH_TRACKER == RH_TRACKER_CMS)
+    {
+        counters *= RH_CMS_DEPTH;
+    }
+
+    RowHammer *rh = (RowHammer *)calloc(1, sizeof(RowHammer));
+    rh->num_banks = num_banks;
+    rh->banks = (RhBank *)calloc(num_banks, sizeof(RhBank));
+    for (unsigned int i = 0; i < num_banks; i++)
+    {
+        rh->banks[i].counters = (RhCounter *)calloc(counters,
+                                                    sizeof(RhCounter));
+    }
+    rh->rng = 0x2545f4914f6cdd1dULL;
+    return rh;
+}
+
+/**
+ * Forget every count at the start of a new refresh window.
+ */
+static void rowhammer_new_window(RowHammer *rh, uint64_t cycle)
+{
+    unsigned int counters = RH_COUNTERS;
+    if (RH_TRACKER == RH_TRACKER_CMS)
+    {
+        counters *= RH_CMS_DEPTH;
+    }
+
+    for (unsigned int i = 0; i < rh->num_banks; i++)
+    {
+        memset(rh->banks[i].counters, 0, counters * sizeof(RhCounter));
+        rh->banks[i].spill = 0;
+        rh->banks[i].spill_last_act = 0;
+    }
+    rh->window_start = cycle - (cycle - rh->window_start) % RH_WINDOW_CYCLES;
+}
+
+/**
+ * Count an activation in a Misra-Gries table with a spillover count.
+ *
+ * @param before Receives the estimated count before the activation.
+ * @return The counter of the row, or NULL if it has none and is counted by
+ *         the spillover count.
+ */
+static RhCounter *rowhammer_count_mg(RhBank *bank, unsigned int row_no,
+                                     uint64_t *before)
+{
+    RhCounter *free_entry = NULL;
+    for (unsigned int i = 0; i < RH_COUNTERS; i++)
+    {
+        RhCounter *e = &bank->counters[i];
+        if (e->row == row_no)
+        {
+            *before = e->count;
+            e->count++;
+            return e;
+        }
+        if (free_entry == NULL && e->count == bank->spill)
+        {
+            free_entry = e;
+        }
+    }
+
+    *before = bank->spill;
+    if (free_entry)
+    {
+        // Take over an entry no more frequent than the untracked rows.
+        free_entry->row = row_no;
+        free_entry->count = bank->spill + 1;
+        free_entry->last_act = bank->spill_last_act;
+        return free_entry;
+    }
+    bank->spill++;
+    return NULL;
+}
+
+/**
+ * The counter of a row in one row of a count-min sketch.
+ */
+static RhCounter *rowhammer_cms_cell(RhBank *bank, unsigned int d,
+                                     unsigned int row_no)
+{
+    static const uint64_t multipliers[RH_CMS_DEPTH] = {
+        0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL,
+        0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL};
+    uint64_t h = ((uint64_t)row_no + 1) * multipliers[d];
+    return &bank->counters[d * RH_COUNTERS + (h >> 32) % RH_COUNTERS];
+}
+
+/**
+ * Count the activation of a row, and find what the mitigation does about it.
+ *
+ * @param rh The trackers.
+ * @param bank_no The bank of the row.
+ * @param row_no The row activated.
+ * @param cycle The cycle of the activation.
+ * @param refreshes Receives the number of neighbour rows to refresh now.
+ * @return The cycles by which throttling delays the activation.
+ */
+uint64_t rowhammer_activate(RowHammer *rh, unsigned int bank_no,
+                            unsigned int row_no, uint64_t cycle,
+                            unsigned int *refreshes)
+{
+    if (cycle >= rh->window_start + RH_WINDOW_CYCLES)
+    {
+        rowhammer_new_window(rh, cycle);
+    }
+    rh->stat_acts++;
+    *refreshes = 0;
+
+    RhBank *bank = &rh->banks[bank_no];
+    uint64_t before;
+    uint64_t after;
+    uint64_t last_act;
+    RhCounter *mg_entry = NULL;
+    if (RH_TRACKER == RH_TRACKER_MG)
+    {
+        mg_entry = rowhammer_count_mg(bank, row_no, &before);
+        after = mg_entry ? mg_entry->count : bank->spill;
+        last_act = mg_entry ? mg_entry->last_act : bank->spill_last_act;
+    }
+    else
+    {
+        before = UINT64_MAX;
+        after = UINT64_MAX;
+        last_act = UINT64_MAX;
+        for (unsigned int d = 0; d < RH_CMS_DEPTH; d++)
+        {
+            RhCounter *cell = rowhammer_cms_cell(bank, d, row_no);
+            if (cell->count < before)
+            {
+                before = cell->count;
+            }
+            cell->count++;
+            if (cell->count < after)
+            {
+                after = cell->count;
+            }
+            if (cell->last_act < last_act)
+            {
+                last_act = cell->last_act;
+            }
+        }
+    }
+
+    if (after / RH_THRESHOLD > before / RH_THRESHOLD)
+    {
+        rh->stat_over_threshold++;
+        if (RH_MITIGATION == RH_TRR)
+        {
+            *refreshes = RH_NEIGHBORS;
+        }
+    }
+
+    if (RH_MITIGATION == RH_PARA)
+    {
+        // xorshift64, independent of the generator of random replacement.
+        rh->rng ^= rh->rng << 13;
+        rh->rng ^= rh->rng >> 7;
+        rh->rng ^= rh->rng << 17;
+        if ((double)(rh->rng >> 11) / (double)(1ULL << 53) < RH_PARA_PROB)
+        {
+            *refreshes = RH_NEIGHBORS;
+        }
+    }
+
+    // Let a row over the threshold be activated only often enough to reach
+    // the threshold again within a window.
+    uint64_t delay = 0;
+    if (RH_MITIGATION == RH_THROTTLE && after > RH_THRESHOLD)
+    {
+        uint64_t earliest = last_act + RH_WINDOW_CYCLES / RH_THRESHOLD;
+        if (earliest > cycle)
+        {
+            delay = earliest - cycle;
+            rh->stat_throttled++;
+        }
+    }
+
+    uint64_t act_cycle = cycle + delay;
+    if (RH_TRACKER == RH_TRACKER_MG)
+    {
+        if (mg_entry)
+        {
+            mg_entry->last_act = act_cycle;
+        }
+        else
+        {
+            bank->spill_last_act = act_cycle;
+        }
+    }
+    else
+    {
+        for (unsigned int d = 0; d < RH_CMS_DEPTH; d++)
+        {
+            rowhammer_cms_cell(bank, d, row_no)->last_act = act_cycle;
+        }
+    }
+
+    rh->stat_refreshes += *refreshes;
+    return delay;
+}
+
+/**
+ * Reset the statistics of the RowHammer trackers.
+ *
+ * @param rh The trackers.
+ */
+void rowhammer_clear_stats(RowHammer *rh)
+{
+    rh->stat_acts = 0;
+    rh->stat_over_threshold = 0;
+    rh->stat_refreshes = 0;
+    rh->stat_throttled = 0;
+    rh->stat_delay = 0;
+}
+
+/**
+ * Add the statistics of one set of RowHammer trackers to those of another.
+ *
+ * @param dst The trackers whose statistics are increased.
+ * @param src The trackers whose statistics are added.
+ */
+void rowhammer_add_stats(RowHammer *dst, const RowHammer *src)
+{
+    dst->stat_acts += src->stat_acts;
+    dst->stat_over_threshold += src->stat_over_threshold;
+    dst->stat_refreshes += src->stat_refreshes;
+    dst->stat_throttled += src->stat_throttled;
+    dst->stat_delay += src->stat_delay;
+}
+
+/**
+ * Free the RowHammer trackers.
+ *
+ * @param rh The trackers to free.
+ */
+void rowhammer_free(RowHammer *rh)
+{
+    for (unsigned int i = 0; i < rh->num_banks; i++)
+    {
+        free(rh->banks[i].counters);
+    }
+    free(rh->banks);
+    free(rh);
+}
+
+/**
+ * Print the statistics of the RowHammer trackers, and the slowdown of DRAM
+ * accesses caused by the mitigation.
+ *
+ * @param rh The trackers.
+ * @param dram_delay The total cycles spent on DRAM accesses, including the
+ *                   mitigation.
+ */
+void rowhammer_print_stats(RowHammer *rh, uint64_t dram_delay)
+{
+    double slowdown = 0.0;
+    if (dram_delay > rh->stat_delay)
+    {
+        slowdown = 100.0 * (double)rh->stat_delay /
+                   (double)(dram_delay - rh->stat_delay);
+    }
+
+    printf("\n");
+    printf("RH_ACTIVATES         \t\t : %10llu\n", rh->stat_acts);
+    printf("RH_OVER_THRESHOLD    \t\t : %10llu\n", rh->stat_over_threshold);
+    printf("RH_NEIGHBOR_REFRESHES\t\t : %10llu\n", rh->stat_refreshes);
+    printf("RH_THROTTLED_ACTS    \t\t : %10llu\n", rh->stat_throttled);
+    printf("RH_DELAY_CYCLES      \t\t : %10llu\n",
+           (unsigned long long)rh->stat_delay);
+    printf("RH_DRAM_SLOWDOWN_PERC\t\t : %10.3f\n", slowdown);
+}
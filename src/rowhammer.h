@@ -0,0 +1,156 @@
+// rowhammer.h
+// Declares the per-bank row activation trackers of the DRAM, and the
+// RowHammer mitigations they drive.
+
+#ifndef __ROWHAMMER_H__
+#define __ROWHAMMER_H__
+
+#include "types.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The refresh window, in cycles (64 ms at 2 GHz). Activation counts are
+ * reset at the start of each window, when every row has been refreshed.
+ */
+#define RH_WINDOW_CYCLES 128000000ULL
+
+/** The number of hash functions (rows) of a count-min sketch. */
+#define RH_CMS_DEPTH 4
+
+/** The largest number of counters per bank, or per sketch row. */
+#define RH_MAX_COUNTERS 4096
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Possible RowHammer mitigations. */
+typedef enum RowHammerMitigationEnum
+{
+    RH_OFF = 0,      // Do not track activations.
+    RH_TRACK = 1,    // Track activations and report aggressor rows only.
+    RH_PARA = 2,     // Refresh the neighbours of a row at random activations.
+    RH_TRR = 3,      // Refresh the neighbours of a row whenever its count
+                     // reaches another multiple of the threshold.
+    RH_THROTTLE = 4, // Space out the activations of rows over the threshold.
+} RowHammerMitigation;
+
+/** Possible summaries of the activation counts of the rows of a bank. */
+typedef enum RowHammerTrackerEnum
+{
+    RH_TRACKER_MG = 0,  // Misra-Gries table with a spillover count.
+    RH_TRACKER_CMS = 1, // Count-min sketch.
+} RowHammerTracker;
+
+/** One counter, for one row of a Misra-Gries table or a sketch cell. */
+typedef struct RhCounter
+{
+    unsigned row;
+    uint64_t count;
+
+    /** The cycle of the last activation counted here. */
+    uint64_t last_act;
+} RhCounter;
+
+/** The activation tracker of one bank. */
+typedef struct RhBank
+{
+    /** RH_COUNTERS table entries, or RH_CMS_DEPTH rows of them. */
+    RhCounter *counters;
+
+    /**
+     * For Misra-Gries, the count every row without an entry is assumed to
+     * have, and the last activation of any such row.
+     */
+    uint64_t spill;
+    uint64_t spill_last_act;
+} RhBank;
+
+/** The RowHammer trackers of all banks of a DRAM module. */
+typedef struct RowHammer
+{
+    RhBank *banks;
+    unsigned int num_banks;
+
+    /** The cycle at which the current refresh window started. */
+    uint64_t window_start;
+
+    /** The state of the random number generator of PARA. */
+    uint64_t rng;
+
+    /**
+     * The total number of activations tracked, of times a row reached a
+     * multiple of the threshold, of neighbour rows refreshed, and of
+     * activations delayed by throttling.
+     */
+    unsigned long long stat_acts;
+    unsigned long long stat_over_threshold;
+    unsigned long long stat_refreshes;
+    unsigned long long stat_throttled;
+
+    /** The total cycles the mitigation added to DRAM accesses. */
+    uint64_t stat_delay;
+} RowHammer;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize the RowHammer trackers of a DRAM module.
+ *
+ * @param num_banks The number of banks.
+ * @return A pointer to the trackers.
+ */
+RowHammer *rowhammer_new(unsigned int num_banks);
+
+/**
+ * Count the activation of a row, and find what the mitigation does about it.
+ *
+ * @param rh The trackers.
+ * @param bank_no The bank of the row.
+ * @param row_no The row activated.
+ * @param cycle The cycle of the activation.
+ * @param refreshes Receives the number of neighbour rows to refresh now.
+ * @return The cycles by which throttling delays the activation.
+ */
+uint64_t rowhammer_activate(RowHammer *rh, unsigned int bank_no,
+                            unsigned int row_no, uint64_t cycle,
+                            unsigned int *refreshes);
+
+/**
+ * Reset the statistics of the RowHammer trackers.
+ *
+ * @param rh The trackers.
+ */
+void rowhammer_clear_stats(RowHammer *rh);
+
+/**
+ * Add the statistics of one set of RowHammer trackers to those of another.
+ *
+ * @param dst The trackers whose statistics are increased.
+ * @param src The trackers whose statistics are added.
+ */
+void rowhammer_add_stats(RowHammer *dst, const RowHammer *src);
+
+/**
+ * Free the RowHammer trackers.
+ *
+ * @param rh The trackers to free.
+ */
+void rowhammer_free(RowHammer *rh);
+
+/**
+ * Print the statistics of the RowHammer trackers, and the slowdown of DRAM
+ * accesses caused by the mitigation.
+ *
+ * @param rh The trackers.
+ * @param dram_delay The total cycles spent on DRAM accesses, including the
+ *                   mitigation.
+ */
+void rowhammer_print_stats(RowHammer *rh, uint64_t dram_delay);
+
+#endif // __ROWHAMMER_H__
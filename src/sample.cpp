@@ -0,0 +1,238 @@
+// sample.cpp
+// Defines the engine that simulates sampling units of a trace in parallel.
+//
+// The trace is split into SAMPLE_UNITS equal periods. The last SAMPLE_INSTS
+// instructions of each period form a detailed region, and the WARM_INSTS
+// before it warm a memory system of its own. Units share nothing but the
+// decoded trace, so they run on a pool of host threads, each with its own
+// clock.
+
+#include "sample.h"
+#include "warm.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The z value of a two-sided 95% confidence interval. */
+#define SAMPLE_Z95 1.96
+
+/** The seed of the random replacement policy, as for the serial run. */
+#define SAMPLE_RANDOM_SEED 42
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The current clock cycle number. */
+extern thread_local uint64_t current_cycle;
+
+/** The number of sampling units. */
+extern unsigned int SAMPLE_UNITS;
+
+/** The number of instructions simulated in detail in each sampling unit. */
+extern uint64_t SAMPLE_INSTS;
+
+/** The number of host threads simulating sampling units. */
+extern unsigned int SAMPLE_THREADS;
+
+/** The number of instructions before each detailed region used to warm it. */
+extern uint64_t WARM_INSTS;
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** One sampling unit and its results. */
+typedef struct SampleUnit
+{
+    uint64_t warm_begin;
+    uint64_t begin;
+    uint64_t end;
+
+    unsigned long long insts;
+    unsigned long long cycles;
+} SampleUnit;
+
+///////////////////////////////////////////////////////////////////////////////
+//                              GLOBAL VARIABLES                             //
+///////////////////////////////////////////////////////////////////////////////
+
+static std::vector<SampleUnit> units;
+static uint64_t trace_insts;
+static unsigned int num_threads;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Warm and simulate one unit on a fresh memory system, then add its
+ * statistics to the shared one.
+ */
+static void sample_unit(SampleUnit *unit, TraceCache *tc, MemorySystem *total,
+                        std::mutex *total_lock)
+{
+    // Each unit starts from the same state as a serial run.
+    cache_seed_random(SAMPLE_RANDOM_SEED);
+    current_cycle = 0;
+
+    MemorySystem *sys = memsys_new();
+    warm_caches(sys, 0, tc->records + unit->warm_begin,
+                unit->begin - unit->warm_begin);
+    memsys_clear_stats(sys);
+
+    Core *core = core_new_at(sys, tc, unit->begin, unit->end, 0);
+    current_cycle = 0;
+    while (!core->done)
+    {
+        core_cycle(core);
+        current_cycle++;
+    }
+    unit->insts = core->done_inst_count;
+    unit->cycles = core->done_cycle_count;
+
+    {
+        std::lock_guard<std::mutex> guard(*total_lock);
+        memsys_add_stats(total, sys);
+    }
+
+    free(core);
+    memsys_free(sys);
+}
+
+/**
+ * Simulate SAMPLE_UNITS sampling units spread evenly over the trace of the
+ * given core, each on a fresh memory system warmed from the instructions just
+ * before it, using SAMPLE_THREADS host threads.
+ *
+ * @param sys The memory system that receives the sum of the statistics of
+ *            all units.
+ * @param core The (only) core, which must read its trace from a TraceCache.
+ *             Its counts are set to the sum over all units.
+ * @param cycles Receives the total number of cycles of the detailed regions.
+ * @return 0 on success, or 1 if the trace has fewer instructions than
+ *         sampling units.
+ */
+int sample_run(MemorySystem *sys, Core *core, uint64_t *cycles)
+{
+    TraceCache *tc = core->trace_cache;
+    trace_insts = tc->num_records;
+
+    uint64_t period = trace_insts / SAMPLE_UNITS;
+    if (period < SAMPLE_INSTS)
+    {
+        fprintf(stderr, "Error: the trace has only %llu instructions per "
+                        "sampling unit, fewer than -sample_insts\n",
+                (unsigned long long)period);
+        return 1;
+    }
+
+    units.resize(SAMPLE_UNITS);
+    for (unsigned int k = 0; k < SAMPLE_UNITS; k++)
+    {
+        SampleUnit *unit = &units[k];
+        unit->end = (k + 1) * period;
+        unit->begin = unit->end - SAMPLE_INSTS;
+        unit->warm_begin = (unit->begin > WARM_INSTS)
+                               ? unit->begin - WARM_INSTS
+                               : 0;
+    }
+
+    num_threads = SAMPLE_THREADS ? SAMPLE_THREADS
+                                 : std::thread::hardware_concurrency();
+    if (num_threads == 0)
+    {
+        num_threads = 1;
+    }
+    if (num_threads > SAMPLE_UNITS)
+    {
+        num_threads = SAMPLE_UNITS;
+    }
+
+    std::atomic<unsigned int> next_unit(0);
+    std::mutex total_lock;
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < num_threads; t++)
+    {
+        workers.push_back(std::thread([&]() {
+            for (unsigned int k = next_unit++; k < SAMPLE_UNITS;
+                 k = next_unit++)
+            {
+                sample_unit(&units[k], tc, sys, &total_lock);
+            }
+        }));
+    }
+    for (unsigned int t = 0; t < num_threads; t++)
+    {
+        workers[t].join();
+    }
+
+    unsigned long long insts = 0;
+    unsigned long long total_cycles = 0;
+    for (unsigned int k = 0; k < SAMPLE_UNITS; k++)
+    {
+        insts += units[k].insts;
+        total_cycles += units[k].cycles;
+    }
+    core->done = true;
+    core->inst_count = insts;
+    core->done_inst_count = insts;
+    core->done_cycle_count = total_cycles;
+    *cycles = total_cycles;
+    return 0;
+}
+
+/**
+ * Print the sampling statistics, including the 95% confidence interval of
+ * the cycles per instruction.
+ */
+void sample_print_stats()
+{
+    // The mean and variance of the CPI over the units.
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    unsigned int n = 0;
+    for (unsigned int k = 0; k < units.size(); k++)
+    {
+        if (units[k].insts == 0)
+        {
+            continue;
+        }
+        double cpi = (double)units[k].cycles / (double)units[k].insts;
+        sum += cpi;
+        sum_sq += cpi * cpi;
+        n++;
+    }
+
+    double mean = 0.0;
+    double ci = 0.0;
+    if (n > 0)
+    {
+        mean = sum / n;
+    }
+    if (n > 1)
+    {
+        double var = (sum_sq - n * mean * mean) / (n - 1);
+        ci = SAMPLE_Z95 * sqrt(var > 0.0 ? var : 0.0) / sqrt((double)n);
+    }
+    double ci_perc = (mean > 0.0) ? 100.0 * ci / mean : 0.0;
+
+    printf("\n");
+    printf("SAMPLE_UNITS        \t\t : %10u\n", n);
+    printf("SAMPLE_THREADS      \t\t : %10u\n", num_threads);
+    printf("SAMPLE_TRACE_INSTS  \t\t : %10llu\n",
+           (unsigned long long)trace_insts);
+    printf("SAMPLE_CPI_MEAN     \t\t : %10.3f\n", mean);
+    printf("SAMPLE_CPI_CI95     \t\t : %10.3f\n", ci);
+    printf("SAMPLE_CPI_CI95_PERC\t\t : %10.3f\n", ci_perc);
+    printf("SAMPLE_EST_CYCLES   \t\t : %10llu\n",
+           (unsigned long long)(mean * trace_insts + 0.5));
+}
@@ -0,0 +1,36 @@
+// sample.h
+// Declares the engine that simulates sampling units of a trace in parallel.
+
+#ifndef __SAMPLE_H__
+#define __SAMPLE_H__
+
+#include "types.h"
+#include "memsys.h"
+#include "core.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Simulate SAMPLE_UNITS sampling units spread evenly over the trace of the
+ * given core, each on a fresh memory system warmed from the instructions just
+ * before it, using SAMPLE_THREADS host threads.
+ *
+ * @param sys The memory system that receives the sum of the statistics of
+ *            all units.
+ * @param core The (only) core, which must read its trace from a TraceCache.
+ *             Its counts are set to the sum over all units.
+ * @param cycles Receives the total number of cycles of the detailed regions.
+ * @return 0 on success, or 1 if the trace has fewer instructions than
+ *         sampling units.
+ */
+int sample_run(MemorySystem *sys, Core *core, uint64_t *cycles);
+
+/**
+ * Print the sampling statistics, including the 95% confidence interval of
+ * the cycles per instruction.
+ */
+void sample_print_stats();
+
+#endif // __SAMPLE_H__
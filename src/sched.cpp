@@ -0,0 +1,715 @@
+// sched.cpp
+// Defines the memory request schedulers of the DRAM, and the per-bank
+// request queues they order.
+//
+// Each bank serves its requests one at a time in the order of its queue, and
+// each request is answered when it is queued, with the cycle at which it will
+// end. A later request the scheduler prefers is queued ahead of requests that
+// have not started yet, which then end later than they were answered; the
+// difference is charged to the next demand read of each core they belong to.
+// A request bypassed SCHED_BYPASS_CAP times is not bypassed again.
+
+#include "sched.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** How many later requests may be served before a request. */
+#define SCHED_BYPASS_CAP 16
+
+/** The most requests of one core per bank PAR-BS marks in a batch. */
+#define PARBS_MARKING_CAP 5
+
+/** The length of an ATLAS quantum, in cycles. */
+#define ATLAS_QUANTUM 10000000
+
+/** The weight ATLAS gives the service attained before the last quantum. */
+#define ATLAS_ALPHA 0.875
+
+/** The wait after which ATLAS serves a request before all others. */
+#define ATLAS_STARVATION_CYCLES 100000
+
+/** The length of a TCM quantum, in cycles. */
+#define TCM_QUANTUM 1000000
+
+/** The largest share of the requests the latency-sensitive cluster makes. */
+#define TCM_CLUSTER_THRESH 0.2
+
+/** How often TCM shuffles the bandwidth-sensitive cluster, in cycles. */
+#define TCM_SHUFFLE_CYCLES 800
+
+/** The requests of a core queued in a row after which BLISS blacklists it. */
+#define BLISS_STREAK 4
+
+/** How often BLISS clears its blacklist, in cycles. */
+#define BLISS_CLEAR_CYCLES 10000
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The scheduler that orders the requests of each DRAM bank. */
+extern MemSchedulerType DRAM_SCHED;
+
+/** The number of cores being simulated. */
+extern unsigned int NUM_CORES;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize the request queues and scheduler of a DRAM module.
+ *
+ * @param num_banks The number of banks.
+ * @param hit_cycles The cycles a bank takes to serve a row hit.
+ * @param closed_cycles The cycles a bank takes to open a row and serve it.
+ * @param conflict_cycles The cycles a bank takes to close a row, open another
+ *                        and serve it.
+ * @return A pointer to the scheduler.
+ */
+MemScheduler *sched_new(unsigned int num_banks, uint64_t hit_cycles,
+                        uint64_t closed_cycles, uint64_t conflict_cycles)
+{
+    MemScheduler *s = (MemScheduler *)calloc(1, sizeof(MemScheduler));
+    s->banks = (SchedBank *)calloc(num_banks, sizeof(SchedBank));
+    s->num_banks = num_banks;
+    s->hit_cycles = hit_cycles;
+    s->closed_cycles = closed_cycles;
+    s->conflict_cycles = conflict_cycles;
+    s->core_rank[SCHED_NO_CORE] = SCHED_MAX_CORES;
+    for (unsigned int c = 0; c < SCHED_MAX_CORES; c++)
+    {
+        s->intensity_order[c] = c;
+    }
+    s->streak_core = SCHED_NO_CORE;
+    return s;
+}
+
+/**
+ * Rank the cores by a key, smallest first, breaking ties by core number.
+ */
+static void sched_rank_cores(MemScheduler *s, const double *key)
+{
+    for (unsigned int c = 0; c < NUM_CORES; c++)
+    {
+        unsigned rank = 0;
+        for (unsigned int d = 0; d < NUM_CORES; d++)
+        {
+            if (key[d] < key[c] || (key[d] == key[c] && d < c))
+            {
+                rank++;
+            }
+        }
+        s->core_rank[c] = rank;
+    }
+}
+
+/**
+ * Rank the cores for TCM: the latency-sensitive cluster first, least
+ * intensive first, then the bandwidth-sensitive cluster in an order that
+ * rotates at every shuffle.
+ */
+static void sched_tcm_rank(MemScheduler *s)
+{
+    unsigned bandwidth_cores = NUM_CORES - s->latency_cores;
+    for (unsigned int c = 0; c < NUM_CORES; c++)
+    {
+        unsigned order = s->intensity_order[c];
+        if (order < s->latency_cores)
+        {
+            s->core_rank[c] = order;
+        }
+        else
+        {
+            s->core_rank[c] = s->latency_cores +
+                              (order - s->latency_cores + s->shuffle) %
+                                  bandwidth_cores;
+        }
+    }
+}
+
+/**
+ * Start the quanta and intervals of the scheduler that have come due.
+ */
+static void sched_update(MemScheduler *s, uint64_t cycle)
+{
+    if (DRAM_SCHED == SCHED_ATLAS &&
+        cycle - s->quantum_start >= ATLAS_QUANTUM)
+    {
+        for (unsigned int c = 0; c < NUM_CORES; c++)
+        {
+            s->attained[c] = ATLAS_ALPHA * s->attained[c] +
+                             (1.0 - ATLAS_ALPHA) * s->quantum_service[c];
+            s->quantum_service[c] = 0;
+        }
+        sched_rank_cores(s, s->attained);
+        s->quantum_start = cycle;
+    }
+
+    if (DRAM_SCHED == SCHED_TCM)
+    {
+        if (cycle - s->quantum_start >= TCM_QUANTUM)
+        {
+            double requests[SCHED_MAX_CORES] = {0};
+            unsigned long long total = 0;
+            for (unsigned int c = 0; c < NUM_CORES; c++)
+            {
+                requests[c] = (double)s->quantum_requests[c];
+                total += s->quantum_requests[c];
+            }
+            sched_rank_cores(s, requests);
+
+            // Grow the latency-sensitive cluster from the least intensive
+            // core while it makes few enough of the requests.
+            unsigned long long cluster = 0;
+            s->latency_cores = 0;
+            for (unsigned int order = 0; order < NUM_CORES; order++)
+            {
+                for (unsigned int c = 0; c < NUM_CORES; c++)
+                {
+                    if (s->core_rank[c] == order)
+                    {
+                        s->intensity_order[c] = order;
+                        cluster += s->quantum_requests[c];
+                    }
+                }
+                if (s->latency_cores == order &&
+                    cluster <= TCM_CLUSTER_THRESH * total)
+                {
+                    s->latency_cores++;
+                }
+            }
+            for (unsigned int c = 0; c < NUM_CORES; c++)
+            {
+                s->quantum_requests[c] = 0;
+            }
+            s->quantum_start = cycle;
+            sched_tcm_rank(s);
+        }
+
+        if (cycle - s->shuffle_start >= TCM_SHUFFLE_CYCLES)
+        {
+            s->shuffle++;
+            s->shuffle_start = cycle;
+            sched_tcm_rank(s);
+        }
+    }
+
+    if (DRAM_SCHED == SCHED_BLISS &&
+        cycle - s->blacklist_start >= BLISS_CLEAR_CYCLES)
+    {
+        memset(s->blacklisted, 0, sizeof(s->blacklisted));
+        s->blacklist_start = cycle;
+    }
+}
+
+/**
+ * Follow a request a bank serves, noting for each core the row of its last
+ * request and the core of the first request after it that opened another.
+ */
+static void sched_follow(const SchedRequest *w, unsigned *core_row,
+                         unsigned *row_closer)
+{
+    for (unsigned int c = 0; c < NUM_CORES; c++)
+    {
+        if (core_row[c] && row_closer[c] == c && core_row[c] != w->row + 1)
+        {
+            row_closer[c] = w->core;
+        }
+    }
+    if (w->core != SCHED_NO_CORE)
+    {
+        core_row[w->core] = w->row + 1;
+        row_closer[w->core] = w->core;
+    }
+}
+
+/**
+ * Drop the requests a bank has finished serving by the given cycle, keeping
+ * the row they left open, and count them by outcome.
+ */
+static void sched_retire(SchedBank *bank, uint64_t cycle,
+                         unsigned long long *served)
+{
+    unsigned done = 0;
+    while (done < bank->count && bank->queue[done].end <= cycle)
+    {
+        served[bank->queue[done].outcome]++;
+        sched_follow(&bank->queue[done], bank->core_row, bank->row_closer);
+        done++;
+    }
+    if (done == 0)
+    {
+        return;
+    }
+
+    bank->open_valid = true;
+    bank->open_row = bank->queue[done - 1].row;
+    bank->free_at = bank->queue[done - 1].end;
+    bank->count -= done;
+    memmove(bank->queue, bank->queue + done,
+            bank->count * sizeof(SchedRequest));
+}
+
+/**
+ * Whether a core finds the row it left open in a bank closed by a request of
+ * another core served before the given place in the queue.
+ */
+static bool sched_row_stolen(const SchedBank *bank, unsigned pos,
+                             unsigned row_no, unsigned int core_id)
+{
+    unsigned core_row[SCHED_MAX_CORES];
+    unsigned row_closer[SCHED_MAX_CORES];
+    memcpy(core_row, bank->core_row, sizeof(core_row));
+    memcpy(row_closer, bank->row_closer, sizeof(row_closer));
+    for (unsigned i = 0; i < pos; i++)
+    {
+        sched_follow(&bank->queue[i], core_row, row_closer);
+    }
+    return core_row[core_id] == row_no + 1 &&
+           row_closer[core_id] != core_id &&
+           row_closer[core_id] != SCHED_NO_CORE;
+}
+
+/**
+ * Whether a request at the given place in the queue of a bank finds its row
+ * open, and the cycles the bank takes to serve it.
+ */
+static uint64_t sched_service(MemScheduler *s, SchedBank *bank, unsigned pos,
+                              unsigned row_no, unsigned int *outcome)
+{
+    bool open_valid = pos ? true : bank->open_valid;
+    unsigned open_row = pos ? bank->queue[pos - 1].row : bank->open_row;
+    if (open_valid && open_row == row_no)
+    {
+        *outcome = 0;
+        return s->hit_cycles;
+    }
+    if (!open_valid)
+    {
+        *outcome = 1;
+        return s->closed_cycles;
+    }
+    *outcome = 2;
+    return s->conflict_cycles;
+}
+
+/**
+ * The priority of a request, lower first, if the bank served it next.
+ */
+static uint64_t sched_priority(MemScheduler *s, const SchedRequest *r,
+                               bool hit, uint64_t cycle)
+{
+    uint64_t miss = hit ? 0 : 1;
+    uint64_t rank = s->core_rank[r->core];
+    switch (DRAM_SCHED)
+    {
+    case SCHED_FRFCFS:
+        return miss;
+    case SCHED_PARBS:
+        return (uint64_t)!r->marked << 32 | miss << 31 | rank;
+    case SCHED_ATLAS:
+        return (uint64_t)(cycle - r->arrival < ATLAS_STARVATION_CYCLES) << 32 |
+               rank << 1 | miss;
+    case SCHED_TCM:
+        return rank << 1 | miss;
+    case SCHED_BLISS:
+        return (uint64_t)(r->core == SCHED_NO_CORE ||
+                          s->blacklisted[r->core]) << 1 |
+               miss;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * For PAR-BS, form a new batch if every request of the last one has been
+ * served: mark up to PARBS_MARKING_CAP of the oldest waiting requests of each
+ * core in each bank, the new request included, and rank the cores with the
+ * fewest marked requests in any one bank, then in all banks, first.
+ */
+static void sched_parbs_mark(MemScheduler *s, unsigned int bank_no,
+                             SchedRequest *r, uint64_t cycle)
+{
+    for (unsigned int b = 0; b < s->num_banks; b++)
+    {
+        SchedBank *bank = &s->banks[b];
+        for (unsigned i = 0; i < bank->count; i++)
+        {
+            if (bank->queue[i].marked && bank->queue[i].end > cycle)
+            {
+                return;
+            }
+        }
+    }
+
+    double max_load[SCHED_MAX_CORES] = {0};
+    unsigned total_load[SCHED_MAX_CORES] = {0};
+    for (unsigned int b = 0; b < s->num_banks; b++)
+    {
+        SchedBank *bank = &s->banks[b];
+        unsigned load[SCHED_MAX_CORES] = {0};
+        for (unsigned i = 0; i <= bank->count; i++)
+        {
+            SchedRequest *w = i < bank->count ? &bank->queue[i] : NULL;
+            if (w == NULL && b != bank_no)
+            {
+                break;
+            }
+            if (w == NULL)
+            {
+                w = r;
+            }
+            else if (w->start <= cycle)
+            {
+                continue;
+            }
+            if (w->core != SCHED_NO_CORE && load[w->core] < PARBS_MARKING_CAP)
+            {
+                w->marked = true;
+                load[w->core]++;
+            }
+        }
+        for (unsigned int c = 0; c < NUM_CORES; c++)
+        {
+            if (load[c] > max_load[c])
+            {
+                max_load[c] = load[c];
+            }
+            total_load[c] += load[c];
+        }
+    }
+
+    // Order by the largest load, then the total, as one key.
+    double key[SCHED_MAX_CORES] = {0};
+    for (unsigned int c = 0; c < NUM_CORES; c++)
+    {
+        key[c] = max_load[c] * (SCHED_QUEUE_SIZE * SCHED_MAX_CORES + 1) +
+                 total_load[c];
+    }
+    sched_rank_cores(s, key);
+    s->stat_batches++;
+}
+
+/**
+ * Queue a request at a bank where the scheduler places it, and find when it
+ * ends. Requests it is served before are pushed back.
+ *
+ * @param s The scheduler.
+ * @param bank_no The bank of the request.
+ * @param row_no The row of the request.
+ * @param core_id The core waiting for the request, or SCHED_NO_CORE.
+ * @param cycle The cycle at which the request arrives.
+ * @param served Receives the number of requests the bank finished serving
+ *               since it was last accessed that were row hits, that opened a
+ *               row in a closed bank, and that closed another row first.
+ * @return The cycles from arrival until the bank has served the request,
+ *         plus the cycles earlier requests of the core were pushed back by.
+ */
+uint64_t sched_access(MemScheduler *s, unsigned int bank_no,
+                      unsigned int row_no, unsigned int core_id,
+                      uint64_t cycle, unsigned long long served[3])
+{
+    sched_update(s, cycle);
+    SchedBank *bank = &s->banks[bank_no];
+    memset(served, 0, 3 * sizeof(unsigned long long));
+    sched_retire(bank, cycle, served);
+    if (bank->count == SCHED_QUEUE_SIZE)
+    {
+        // Let the oldest request go as if served; its timing stands.
+        sched_retire(bank, bank->queue[0].end, served);
+    }
+
+    SchedRequest r;
+    memset(&r, 0, sizeof(r));
+    r.row = row_no;
+    r.core = core_id;
+    r.arrival = cycle;
+    if (DRAM_SCHED == SCHED_PARBS)
+    {
+        sched_parbs_mark(s, bank_no, &r, cycle);
+    }
+    if (DRAM_SCHED == SCHED_BLISS && core_id != SCHED_NO_CORE)
+    {
+        s->streak = core_id == s->streak_core ? s->streak + 1 : 1;
+        s->streak_core = core_id;
+        if (s->streak >= BLISS_STREAK)
+        {
+            s->blacklisted[core_id] = true;
+        }
+    }
+
+    // Requests that have started keep their place. Among the others, the
+    // new request goes before the first one it is preferred to.
+    unsigned pos = 0;
+    while (pos < bank->count && bank->queue[pos].start <= cycle)
+    {
+        pos++;
+    }
+    for (; DRAM_SCHED != SCHED_FCFS && pos < bank->count; pos++)
+    {
+        SchedRequest *w = &bank->queue[pos];
+        unsigned int r_outcome;
+        unsigned int w_outcome;
+        sched_service(s, bank, pos, r.row, &r_outcome);
+        sched_service(s, bank, pos, w->row, &w_outcome);
+        if (w->bypassed < SCHED_BYPASS_CAP &&
+            sched_priority(s, &r, r_outcome == 0, cycle) <
+                sched_priority(s, w, w_outcome == 0, cycle))
+        {
+            break;
+        }
+    }
+    if (DRAM_SCHED == SCHED_FCFS)
+    {
+        pos = bank->count;
+    }
+
+    // The requests of other cores served before this one delay it.
+    uint64_t interference = 0;
+    for (unsigned i = 0; core_id != SCHED_NO_CORE && i < pos; i++)
+    {
+        SchedRequest *w = &bank->queue[i];
+        if (w->core != core_id && w->core != SCHED_NO_CORE)
+        {
+            interference += w->end - (w->start > cycle ? w->start : cycle);
+        }
+    }
+
+    memmove(bank->queue + pos + 1, bank->queue + pos,
+            (bank->count - pos) * sizeof(SchedRequest));
+    bank->queue[pos] = r;
+    bank->count++;
+    if (pos + 1 < bank->count)
+    {
+        s->stat_reordered++;
+    }
+
+    // Time the new request and those it was put before.
+    uint64_t prev_end = pos ? bank->queue[pos - 1].end : bank->free_at;
+    uint64_t service = 0;
+    for (unsigned i = pos; i < bank->count; i++)
+    {
+        SchedRequest *w = &bank->queue[i];
+        unsigned int w_outcome;
+        uint64_t w_service = sched_service(s, bank, i, w->row, &w_outcome);
+        uint64_t old_end = w->end;
+        w->start = w->arrival > prev_end ? w->arrival : prev_end;
+        w->end = w->start + w_service;
+        w->outcome = w_outcome;
+        prev_end = w->end;
+
+        if (i == pos)
+        {
+            service = w_service;
+            continue;
+        }
+        w->bypassed++;
+        if (w->core != SCHED_NO_CORE && w->end > old_end)
+        {
+            s->debt[w->core] += w->end - old_end;
+            if (core_id != SCHED_NO_CORE && core_id != w->core)
+            {
+                s->stat_interference[w->core] += w->end - old_end;
+            }
+        }
+    }
+
+    uint64_t delay = bank->queue[pos].end - cycle;
+    if (core_id == SCHED_NO_CORE)
+    {
+        return delay;
+    }
+
+    // A row the core left open that another core closed would have hit.
+    if (bank->queue[pos].outcome != 0 &&
+        sched_row_stolen(bank, pos, row_no, core_id))
+    {
+        interference += service - s->hit_cycles;
+    }
+
+    s->quantum_service[core_id] += service;
+    s->quantum_requests[core_id]++;
+
+    delay += s->debt[core_id];
+    s->debt[core_id] = 0;
+    s->stat_reads[core_id]++;
+    s->stat_read_cycles[core_id] += delay;
+    s->stat_interference[core_id] += interference;
+    return delay;
+}
+
+/**
+ * Let a range of banks finish the requests they hold and close their rows,
+ * as a rank entering self-refresh does.
+ *
+ * @param s The scheduler.
+ * @param first_bank The first bank of the range.
+ * @param num_banks The number of banks in the range.
+ * @param served Receives the number of requests the banks finished serving
+ *               since they were last accessed that were row hits, that opened
+ *               a row in a closed bank, and that closed another row first.
+ * @return The number of rows closed.
+ */
+unsigned int sched_close_rows(MemScheduler *s, unsigned int first_bank,
+                              unsigned int num_banks,
+                              unsigned long long served[3])
+{
+    unsigned int closed = 0;
+    served[0] = served[1] = served[2] = 0;
+    for (unsigned int b = first_bank; b < first_bank + num_banks; b++)
+    {
+        SchedBank *bank = &s->banks[b];
+        if (bank->count)
+        {
+            sched_retire(bank, bank->queue[bank->count - 1].end, served);
+        }
+        if (bank->open_valid)
+        {
+            bank->open_valid = false;
+            closed++;
+        }
+
+        // No core finds its row closed by another one.
+        memset(bank->core_row, 0, sizeof(bank->core_row));
+    }
+    return closed;
+}
+
+/**
+ * Let every bank finish the requests it holds, and restart the clock of the
+ * scheduler at cycle 0, when the simulation restarts its own.
+ *
+ * @param s The scheduler.
+ */
+void sched_reset_clock(MemScheduler *s)
+{
+    unsigned long long served[3] = {0};
+    for (unsigned int b = 0; b < s->num_banks; b++)
+    {
+        SchedBank *bank = &s->banks[b];
+        if (bank->count)
+        {
+            sched_retire(bank, bank->queue[bank->count - 1].end, served);
+        }
+        bank->free_at = 0;
+    }
+    memset(s->debt, 0, sizeof(s->debt));
+    s->quantum_start = 0;
+    s->shuffle_start = 0;
+    s->blacklist_start = 0;
+}
+
+/**
+ * Reset the statistics of the scheduler.
+ *
+ * @param s The scheduler.
+ */
+void sched_clear_stats(MemScheduler *s)
+{
+    memset(s->stat_reads, 0, sizeof(s->stat_reads));
+    memset(s->stat_read_cycles, 0, sizeof(s->stat_read_cycles));
+    memset(s->stat_interference, 0, sizeof(s->stat_interference));
+    s->stat_reordered = 0;
+    s->stat_batches = 0;
+}
+
+/**
+ * Add the statistics of one scheduler to those of another.
+ *
+ * @param dst The scheduler whose statistics are increased.
+ * @param src The scheduler whose statistics are added.
+ */
+void sched_add_stats(MemScheduler *dst, const MemScheduler *src)
+{
+    for (unsigned int c = 0; c < SCHED_MAX_CORES; c++)
+    {
+        dst->stat_reads[c] += src->stat_reads[c];
+        dst->stat_read_cycles[c] += src->stat_read_cycles[c];
+        dst->stat_interference[c] += src->stat_interference[c];
+    }
+    dst->stat_reordered += src->stat_reordered;
+    dst->stat_batches += src->stat_batches;
+}
+
+/**
+ * Free the scheduler.
+ *
+ * @param s The scheduler to free.
+ */
+void sched_free(MemScheduler *s)
+{
+    free(s->banks);
+    free(s);
+}
+
+/**
+ * Print the reads, read latency and interference of each core.
+ *
+ * @param s The scheduler.
+ */
+void sched_print_stats(MemScheduler *s)
+{
+    printf("\n");
+    printf("DRAM_SCHED_REORDERED \t\t : %10llu\n", s->stat_reordered);
+    if (DRAM_SCHED == SCHED_PARBS)
+    {
+        printf("DRAM_SCHED_BATCHES   \t\t : %10llu\n", s->stat_batches);
+    }
+    for (unsigned int c = 0; c < NUM_CORES; c++)
+    {
+        double avg_cycles = 0.0;
+        if (s->stat_reads[c])
+        {
+            avg_cycles = (double)s->stat_read_cycles[c] /
+                         (double)s->stat_reads[c];
+        }
+        printf("DRAM_CORE_%01u_READS    \t\t : %10llu\n", c, s->stat_reads[c]);
+        printf("DRAM_CORE_%01u_READ_AVG \t\t : %10.3f\n", c, avg_cycles);
+        printf("DRAM_CORE_%01u_INTERFERENCE\t : %10llu\n", c,
+               (unsigned long long)s->stat_interference[c]);
+    }
+}
+
+/**
+ * Print the estimated slowdown of each core caused by requests of the other
+ * cores, the largest of them, and the ratio of the largest to the smallest.
+ *
+ * @param s The scheduler.
+ * @param cycles The cycles each core ran for.
+ * @param num_cores The number of cores.
+ */
+void sched_print_slowdown(MemScheduler *s, const uint64_t *cycles,
+                          unsigned int num_cores)
+{
+    double max_slowdown = 0.0;
+    double min_slowdown = 0.0;
+    printf("\n");
+    for (unsigned int c = 0; c < num_cores; c++)
+    {
+        // Without the other cores, the core would not have waited for them.
+        double slowdown = 1.0;
+        if (cycles[c] > s->stat_interference[c])
+        {
+            slowdown = (double)cycles[c] /
+                       (double)(cycles[c] - s->stat_interference[c]);
+        }
+        printf("CORE_%01u_SLOWDOWN     \t\t : %10.3f\n", c, slowdown);
+        if (c == 0 || slowdown > max_slowdown)
+        {
+            max_slowdown = slowdown;
+        }
+        if (c == 0 || slowdown < min_slowdown)
+        {
+            min_slowdown = slowdown;
+        }
+    }
+    printf("MAX_SLOWDOWN         \t\t : %10.3f\n", max_slowdown);
+    printf("UNFAIRNESS           \t\t : %10.3f\n",
+           min_slowdown > 0.0 ? max_slowdown / min_slowdown : 0.0);
+}
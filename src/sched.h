@@ -0,0 +1,257 @@
+// sched.h
+// Declares the memory request schedulers of the DRAM, and the per-bank
+// request queues they order.
+
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+#include "types.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The largest number of cores whose requests are told apart. */
+#define SCHED_MAX_CORES 16
+
+/** The core of a request that no core waits for, such as a writeback. */
+#define SCHED_NO_CORE SCHED_MAX_CORES
+
+/** The largest number of requests queued at, or served by, one bank. */
+#define SCHED_QUEUE_SIZE 64
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Possible memory request schedulers. */
+typedef enum MemSchedulerEnum
+{
+    SCHED_OFF = 0,    // Serve every request at once, without bank queues.
+    SCHED_FCFS = 1,   // Serve the requests of each bank in arrival order.
+    SCHED_FRFCFS = 2, // Serve row hits first, then the oldest request.
+    SCHED_PARBS = 3,  // Serve batches of requests, shortest core first.
+    SCHED_ATLAS = 4,  // Serve the core with the least attained service first.
+    SCHED_TCM = 5,    // Serve light cores first, and shuffle the heavy ones.
+    SCHED_BLISS = 6,  // Serve cores served many times in a row last.
+} MemSchedulerType;
+
+/** A request queued at, or being served by, a bank. */
+typedef struct SchedRequest
+{
+    unsigned row;
+
+    /** The core waiting for the request, or SCHED_NO_CORE. */
+    unsigned core;
+
+    /** Whether PAR-BS marked the request as part of the current batch. */
+    bool marked;
+
+    /** How many later requests were served before this one. */
+    unsigned bypassed;
+
+    /**
+     * How the bank serves the request as now timed: 0 for a row hit, 1 if it
+     * opens a row in a closed bank, and 2 if it closes another row first.
+     */
+    unsigned outcome;
+
+    /** The cycles at which the request arrived, starts and ends. */
+    uint64_t arrival;
+    uint64_t start;
+    uint64_t end;
+} SchedRequest;
+
+/** The requests of one bank, in the order it serves them. */
+typedef struct SchedBank
+{
+    SchedRequest queue[SCHED_QUEUE_SIZE];
+    unsigned count;
+
+    /** The row left open by the requests already served, if any. */
+    bool open_valid;
+    unsigned open_row;
+
+    /** The cycle at which the requests already served ended. */
+    uint64_t free_at;
+
+    /**
+     * The row of the last request of each core the bank served, plus one, or
+     * 0, and the core of the first request served after it that opened
+     * another row, or the core itself if none did.
+     */
+    unsigned core_row[SCHED_MAX_CORES];
+    unsigned row_closer[SCHED_MAX_CORES];
+} SchedBank;
+
+/** The request queues of a DRAM module, and the state of its scheduler. */
+typedef struct MemScheduler
+{
+    SchedBank *banks;
+    unsigned int num_banks;
+
+    /**
+     * The cycles a bank takes to serve a row hit, an access to a closed bank,
+     * and a row conflict.
+     */
+    uint64_t hit_cycles;
+    uint64_t closed_cycles;
+    uint64_t conflict_cycles;
+
+    /**
+     * The priority of each core, lower first, as PAR-BS, ATLAS and TCM rank
+     * them. Requests of no core come after every core.
+     */
+    unsigned core_rank[SCHED_MAX_CORES + 1];
+
+    /**
+     * The cycles by which requests already answered were pushed back by later
+     * ones served first, per core. Charged to the next request of the core.
+     */
+    uint64_t debt[SCHED_MAX_CORES];
+
+    /** For ATLAS and TCM, when the current quantum started. */
+    uint64_t quantum_start;
+
+    /** For ATLAS, the service each core attained before and in the quantum. */
+    double attained[SCHED_MAX_CORES];
+    uint64_t quantum_service[SCHED_MAX_CORES];
+
+    /**
+     * For TCM, the requests of each core in the quantum, the place of each
+     * core by the requests of the last quantum, fewest first, how many of
+     * the first cores form the latency-sensitive cluster, and how far and
+     * since when the others have been shuffled.
+     */
+    unsigned long long quantum_requests[SCHED_MAX_CORES];
+    unsigned intensity_order[SCHED_MAX_CORES];
+    unsigned latency_cores;
+    unsigned shuffle;
+    uint64_t shuffle_start;
+
+    /**
+     * For BLISS, the core queued last, how many of its requests were queued
+     * in a row, which cores are blacklisted, and since when.
+     */
+    unsigned streak_core;
+    unsigned streak;
+    bool blacklisted[SCHED_MAX_CORES];
+    uint64_t blacklist_start;
+
+    /**
+     * The number of demand reads of each core, the cycles they took, and the
+     * cycles requests of other cores made them wait.
+     */
+    unsigned long long stat_reads[SCHED_MAX_CORES];
+    uint64_t stat_read_cycles[SCHED_MAX_CORES];
+    uint64_t stat_interference[SCHED_MAX_CORES];
+
+    /**
+     * The number of requests served before an earlier one, and of PAR-BS
+     * batches formed.
+     */
+    unsigned long long stat_reordered;
+    unsigned long long stat_batches;
+} MemScheduler;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize the request queues and scheduler of a DRAM module.
+ *
+ * @param num_banks The number of banks.
+ * @param hit_cycles The cycles a bank takes to serve a row hit.
+ * @param closed_cycles The cycles a bank takes to open a row and serve it.
+ * @param conflict_cycles The cycles a bank takes to close a row, open another
+ *                        and serve it.
+ * @return A pointer to the scheduler.
+ */
+MemScheduler *sched_new(unsigned int num_banks, uint64_t hit_cycles,
+                        uint64_t closed_cycles, uint64_t conflict_cycles);
+
+/**
+ * Queue a request at a bank where the scheduler places it, and find when it
+ * ends. Requests it is served before are pushed back.
+ *
+ * @param s The scheduler.
+ * @param bank_no The bank of the request.
+ * @param row_no The row of the request.
+ * @param core_id The core waiting for the request, or SCHED_NO_CORE.
+ * @param cycle The cycle at which the request arrives.
+ * @param served Receives the number of requests the bank finished serving
+ *               since it was last accessed that were row hits, that opened a
+ *               row in a closed bank, and that closed another row first.
+ * @return The cycles from arrival until the bank has served the request,
+ *         plus the cycles earlier requests of the core were pushed back by.
+ */
+uint64_t sched_access(MemScheduler *s, unsigned int bank_no,
+                      unsigned int row_no, unsigned int core_id,
+                      uint64_t cycle, unsigned long long served[3]);
+
+/**
+ * Let a range of banks finish the requests they hold and close their rows,
+ * as a rank entering self-refresh does.
+ *
+ * @param s The scheduler.
+ * @param first_bank The first bank of the range.
+ * @param num_banks The number of banks in the range.
+ * @param served Receives the number of requests the banks finished serving
+ *               since they were last accessed that were row hits, that opened
+ *               a row in a closed bank, and that closed another row first.
+ * @return The number of rows closed.
+ */
+unsigned int sched_close_rows(MemScheduler *s, unsigned int first_bank,
+                              unsigned int num_banks,
+                              unsigned long long served[3]);
+
+/**
+ * Let every bank finish the requests it holds, and restart the clock of the
+ * scheduler at cycle 0, when the simulation restarts its own.
+ *
+ * @param s The scheduler.
+ */
+void sched_reset_clock(MemScheduler *s);
+
+/**
+ * Reset the statistics of the scheduler.
+ *
+ * @param s The scheduler.
+ */
+void sched_clear_stats(MemScheduler *s);
+
+/**
+ * Add the statistics of one scheduler to those of another.
+ *
+ * @param dst The scheduler whose statistics are increased.
+ * @param src The scheduler whose statistics are added.
+ */
+void sched_add_stats(MemScheduler *dst, const MemScheduler *src);
+
+/**
+ * Free the scheduler.
+ *
+ * @param s The scheduler to free.
+ */
+void sched_free(MemScheduler *s);
+
+/**
+ * Print the reads, read latency and interference of each core.
+ *
+ * @param s The scheduler.
+ */
+void sched_print_stats(MemScheduler *s);
+
+/**
+ * Print the estimated slowdown of each core caused by requests of the other
+ * cores, the largest of them, and the ratio of the largest to the smallest.
+ *
+ * @param s The scheduler.
+ * @param cycles The cycles each core ran for.
+ * @param num_cores The number of cores.
+ */
+void sched_print_slowdown(MemScheduler *s, const uint64_t *cycles,
+                          unsigned int num_cores);
+
+#endif // __SCHED_H__
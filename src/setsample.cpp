@@ -0,0 +1,279 @@
+// setsample.cpp
+// Defines the set sampling of the L2 cache, which simulates one set in every
+// L2CACHE_SAMPLE_RATIO and estimates the miss rate and DRAM traffic of the
+// whole cache from them.
+//
+// The simulated sets are those whose lowest log2(ratio) index bits equal the
+// next log2(ratio) bits, so that every alignment of a line within a page is
+// sampled alike. The cache holding them is the ratio times smaller and drops
+// the lowest index bits of each address, which the next bits restore. Each
+// simulated set is one cluster of a cluster sample; the miss rate and the
+// writebacks per access are ratio estimates over the clusters, scaled by every
+// access the cache received.
+
+#include "setsample.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The quantile of the normal distribution for a 95% confidence interval. */
+#define SETSAMPLE_Z95 1.96
+
+/**
+ * The weight of each sampled read in the recent read miss ratio that the
+ * unsampled reads are charged by.
+ */
+#define SETSAMPLE_MISS_WEIGHT (1.0 / 256)
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize the set sampling of a cache.
+ *
+ * @param sets The number of sets simulated.
+ * @param ratio One set is simulated in every this many (a power of two).
+ * @return A pointer to the set sampling.
+ */
+SetSample *setsample_new(unsigned int sets, unsigned int ratio)
+{
+    SetSample *ss = (SetSample *)calloc(1, sizeof(SetSample));
+    ss->ratio_bits = (unsigned int)std::log2(ratio);
+    ss->sets = sets;
+    ss->set_access = (unsigned long long *)calloc(
+        sets, sizeof(unsigned long long));
+    ss->set_miss = (unsigned long long *)calloc(
+        sets, sizeof(unsigned long long));
+    ss->set_writeback = (unsigned long long *)calloc(
+        sets, sizeof(unsigned long long));
+    return ss;
+}
+
+/**
+ * Check whether a line maps to a set that is simulated.
+ *
+ * @param ss The set sampling.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @return Whether the set of the line is simulated.
+ */
+bool setsample_is_sampled(const SetSample *ss, uint64_t line_addr)
+{
+    uint64_t mask = (1ULL << ss->ratio_bits) - 1;
+    return (line_addr & mask) == ((line_addr >> ss->ratio_bits) & mask);
+}
+
+/**
+ * Convert the address of a line in a simulated set to the address the smaller
+ * simulated cache knows it by, which maps to the same set among those
+ * simulated and has the same tag.
+ *
+ * @param ss The set sampling.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @return The address of the line in the simulated cache.
+ */
+uint64_t setsample_to_cache(const SetSample *ss, uint64_t line_addr)
+{
+    return line_addr >> ss->ratio_bits;
+}
+
+/**
+ * Convert an address in the simulated cache back to the address of the line.
+ *
+ * @param ss The set sampling.
+ * @param cache_addr The address of the line in the simulated cache.
+ * @return The address of the cache line (in units of the cache line size).
+ */
+uint64_t setsample_from_cache(const SetSample *ss, uint64_t cache_addr)
+{
+    uint64_t mask = (1ULL << ss->ratio_bits) - 1;
+    return (cache_addr << ss->ratio_bits) | (cache_addr & mask);
+}
+
+/**
+ * Record an access to a simulated set.
+ *
+ * @param ss The set sampling.
+ * @param set The index of the set in the simulated cache.
+ * @param is_writeback Whether the access is a writeback from an L1 cache.
+ * @param miss Whether the access missed.
+ * @param writeback Whether it made the cache write a dirty line to DRAM.
+ */
+void setsample_record(SetSample *ss, unsigned int set, bool is_writeback,
+                      bool miss, bool writeback)
+{
+    if (!is_writeback)
+    {
+        ss->read_miss_ratio += ((miss ? 1.0 : 0.0) - ss->read_miss_ratio) *
+                               SETSAMPLE_MISS_WEIGHT;
+    }
+    ss->set_access[set]++;
+    ss->set_miss[set] += miss;
+    ss->set_writeback[set] += writeback;
+}
+
+/**
+ * Count an access to a set that is not simulated, and decide whether to
+ * charge it as a miss so that the unsampled reads miss as often as the
+ * recent sampled ones.
+ *
+ * @param ss The set sampling.
+ * @param is_writeback Whether the access is a writeback from an L1 cache.
+ * @return Whether the access is charged the latency of a miss.
+ */
+bool setsample_skip(SetSample *ss, bool is_writeback)
+{
+    if (is_writeback)
+    {
+        ss->stat_skipped_writebacks++;
+        return false;
+    }
+
+    ss->stat_skipped_reads++;
+    ss->miss_credit += ss->read_miss_ratio;
+    if (ss->miss_credit < 1.0)
+    {
+        return false;
+    }
+    ss->miss_credit -= 1.0;
+    ss->stat_charged_misses++;
+    return true;
+}
+
+/**
+ * Reset the statistics of the set sampling.
+ *
+ * @param ss The set sampling.
+ */
+void setsample_clear_stats(SetSample *ss)
+{
+    memset(ss->set_access, 0, ss->sets * sizeof(unsigned long long));
+    memset(ss->set_miss, 0, ss->sets * sizeof(unsigned long long));
+    memset(ss->set_writeback, 0, ss->sets * sizeof(unsigned long long));
+    ss->stat_skipped_reads = 0;
+    ss->stat_skipped_writebacks = 0;
+    ss->stat_charged_misses = 0;
+}
+
+/**
+ * Add the statistics of one set sampling to those of another with the same
+ * configuration.
+ *
+ * @param dst The set sampling whose statistics are increased.
+ * @param src The set sampling whose statistics are added.
+ */
+void setsample_add_stats(SetSample *dst, const SetSample *src)
+{
+    for (unsigned int i = 0; i < dst->sets; i++)
+    {
+        dst->set_access[i] += src->set_access[i];
+        dst->set_miss[i] += src->set_miss[i];
+        dst->set_writeback[i] += src->set_writeback[i];
+    }
+    dst->stat_skipped_reads += src->stat_skipped_reads;
+    dst->stat_skipped_writebacks += src->stat_skipped_writebacks;
+    dst->stat_charged_misses += src->stat_charged_misses;
+}
+
+/**
+ * Free the set sampling.
+ *
+ * @param ss The set sampling to free.
+ */
+void setsample_free(SetSample *ss)
+{
+    free(ss->set_access);
+    free(ss->set_miss);
+    free(ss->set_writeback);
+    free(ss);
+}
+
+/**
+ * Estimate the ratio of a per-set count to the accesses over all sets, and
+ * the standard error of the estimate, from the simulated sets.
+ */
+static double setsample_ratio(const SetSample *ss,
+                              const unsigned long long *count, double *se)
+{
+    double accesses = 0.0;
+    double total = 0.0;
+    for (unsigned int i = 0; i < ss->sets; i++)
+    {
+        accesses += (double)ss->set_access[i];
+        total += (double)count[i];
+    }
+
+    *se = 0.0;
+    if (accesses == 0.0)
+    {
+        return 0.0;
+    }
+    double ratio = total / accesses;
+    if (ss->sets < 2)
+    {
+        return ratio;
+    }
+
+    double residuals = 0.0;
+    for (unsigned int i = 0; i < ss->sets; i++)
+    {
+        double r = (double)count[i] - ratio * (double)ss->set_access[i];
+        residuals += r * r;
+    }
+    double mean_accesses = accesses / ss->sets;
+    double fraction = 1.0 / (double)(1ULL << ss->ratio_bits);
+    *se = std::sqrt((1.0 - fraction) * residuals / (ss->sets - 1) /
+                    ss->sets) /
+          mean_accesses;
+    return ratio;
+}
+
+/**
+ * Print the accesses seen with and without simulation, and the miss rate,
+ * misses and DRAM writebacks estimated for the whole cache, each with the
+ * half-width of its 95% confidence interval.
+ *
+ * @param ss The set sampling.
+ * @param header The name of the cache.
+ */
+void setsample_print_stats(SetSample *ss, const char *header)
+{
+    unsigned long long sampled = 0;
+    for (unsigned int i = 0; i < ss->sets; i++)
+    {
+        sampled += ss->set_access[i];
+    }
+    double accesses = (double)(sampled + ss->stat_skipped_reads +
+                               ss->stat_skipped_writebacks);
+
+    double miss_se;
+    double wb_se;
+    double miss_rate = setsample_ratio(ss, ss->set_miss, &miss_se);
+    double wb_rate = setsample_ratio(ss, ss->set_writeback, &wb_se);
+
+    printf("\n");
+    printf("%s_SAMPLE_SETS     \t\t : %10u\n", header, ss->sets);
+    printf("%s_SAMPLED_ACCESS  \t\t : %10llu\n", header, sampled);
+    printf("%s_SKIPPED_READS   \t\t : %10llu\n", header,
+           ss->stat_skipped_reads);
+    printf("%s_SKIPPED_WBS     \t\t : %10llu\n", header,
+           ss->stat_skipped_writebacks);
+    printf("%s_CHARGED_MISSES  \t\t : %10llu\n", header,
+           ss->stat_charged_misses);
+    printf("%s_EST_MISS_PERC   \t\t : %10.3f\n", header, 100.0 * miss_rate);
+    printf("%s_EST_MISS_CI95   \t\t : %10.3f\n", header,
+           100.0 * SETSAMPLE_Z95 * miss_se);
+    printf("%s_EST_MISSES      \t\t : %10.0f\n", header, miss_rate * accesses);
+    printf("%s_EST_MISSES_CI95 \t\t : %10.0f\n", header,
+           SETSAMPLE_Z95 * miss_se * accesses);
+    printf("%s_EST_DRAM_WB     \t\t : %10.0f\n", header, wb_rate * accesses);
+    printf("%s_EST_DRAM_WB_CI95\t\t : %10.0f\n", header,
+           SETSAMPLE_Z95 * wb_se * accesses);
+}
@@ -0,0 +1,148 @@
+// setsample.h
+// Declares the set sampling of the L2 cache, which simulates one set in every
+// L2CACHE_SAMPLE_RATIO and estimates the miss rate and DRAM traffic of the
+// whole cache from them.
+
+#ifndef __SETSAMPLE_H__
+#define __SETSAMPLE_H__
+
+#include "types.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The sampled sets of the L2 cache, and what they saw. */
+typedef struct SetSample
+{
+    /** The base-2 logarithm of the sampling ratio. */
+    unsigned int ratio_bits;
+
+    /** The number of sets simulated. */
+    unsigned int sets;
+
+    /**
+     * The miss ratio of the recent reads of the simulated sets, and the
+     * misses the unsampled reads are charged for, as a running sum.
+     */
+    double read_miss_ratio;
+    double miss_credit;
+
+    /**
+     * For each set simulated, the number of accesses, of misses, and of
+     * dirty lines it wrote back to DRAM.
+     */
+    unsigned long long *set_access;
+    unsigned long long *set_miss;
+    unsigned long long *set_writeback;
+
+    /**
+     * The number of reads and writebacks that reached the L2 cache in sets
+     * not simulated, and how many of the reads were charged as misses.
+     */
+    unsigned long long stat_skipped_reads;
+    unsigned long long stat_skipped_writebacks;
+    unsigned long long stat_charged_misses;
+} SetSample;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize the set sampling of a cache.
+ *
+ * @param sets The number of sets simulated.
+ * @param ratio One set is simulated in every this many (a power of two).
+ * @return A pointer to the set sampling.
+ */
+SetSample *setsample_new(unsigned int sets, unsigned int ratio);
+
+/**
+ * Check whether a line maps to a set that is simulated.
+ *
+ * @param ss The set sampling.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @return Whether the set of the line is simulated.
+ */
+bool setsample_is_sampled(const SetSample *ss, uint64_t line_addr);
+
+/**
+ * Convert the address of a line in a simulated set to the address the smaller
+ * simulated cache knows it by, which maps to the same set among those
+ * simulated and has the same tag.
+ *
+ * @param ss The set sampling.
+ * @param line_addr The address of the cache line (in units of the cache line
+ *                  size).
+ * @return The address of the line in the simulated cache.
+ */
+uint64_t setsample_to_cache(const SetSample *ss, uint64_t line_addr);
+
+/**
+ * Convert an address in the simulated cache back to the address of the line.
+ *
+ * @param ss The set sampling.
+ * @param cache_addr The address of the line in the simulated cache.
+ * @return The address of the cache line (in units of the cache line size).
+ */
+uint64_t setsample_from_cache(const SetSample *ss, uint64_t cache_addr);
+
+/**
+ * Record an access to a simulated set.
+ *
+ * @param ss The set sampling.
+ * @param set The index of the set in the simulated cache.
+ * @param is_writeback Whether the access is a writeback from an L1 cache.
+ * @param miss Whether the access missed.
+ * @param writeback Whether it made the cache write a dirty line to DRAM.
+ */
+void setsample_record(SetSample *ss, unsigned int set, bool is_writeback,
+                      bool miss, bool writeback);
+
+/**
+ * Count an access to a set that is not simulated, and decide whether to
+ * charge it as a miss so that the unsampled reads miss as often as the
+ * recent sampled ones.
+ *
+ * @param ss The set sampling.
+ * @param is_writeback Whether the access is a writeback from an L1 cache.
+ * @return Whether the access is charged the latency of a miss.
+ */
+bool setsample_skip(SetSample *ss, bool is_writeback);
+
+/**
+ * Reset the statistics of the set sampling.
+ *
+ * @param ss The set sampling.
+ */
+void setsample_clear_stats(SetSample *ss);
+
+/**
+ * Add the statistics of one set sampling to those of another with the same
+ * configuration.
+ *
+ * @param dst The set sampling whose statistics are increased.
+ * @param src The set sampling whose statistics are added.
+ */
+void setsample_add_stats(SetSample *dst, const SetSample *src);
+
+/**
+ * Free the set sampling.
+ *
+ * @param ss The set sampling to free.
+ */
+void setsample_free(SetSample *ss);
+
+/**
+ * Print the accesses seen with and without simulation, and the miss rate,
+ * misses and DRAM writebacks estimated for the whole cache, each with the
+ * half-width of its 95% confidence interval.
+ *
+ * @param ss The set sampling.
+ * @param header The name of the cache.
+ */
+void setsample_print_stats(SetSample *ss, const char *header);
+
+#endif // __SETSAMPLE_H__
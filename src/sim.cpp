@@ -5,11 +5,18 @@
 #include "types.h"
 #include "memsys.h"
 #include "core.h"
+#include "pipeline.h"
+#include "lanes.h"
+#include "warm.h"
+#include "sample.h"
+#include "opt.h"
+#include "pin.h"
+#include "energy.h"
+#include "temporal.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <strings.h>
 
-#define MAX_CORES 2
 #define PRINT_DOTS 1
 #define DOT_INTERVAL 100000
 
@@ -45,6 +52,25 @@ uint64_t L2CACHE_ASSOC = 16;
 /** The replacement policy to use for the L2 cache. */
 ReplacementPolicy L2CACHE_REPL = LRU;
 
+/**
+ * Whether -L2repl was given. Modes B and C then use L2CACHE_REPL for the L2
+ * cache instead of REPL_POLICY.
+ */
+bool L2CACHE_REPL_SET = false;
+
+/**
+ * The levels of the replacement walk if the L2 cache is organised as a
+ * zcache, or 0 for a set-associative L2 cache.
+ */
+unsigned int L2CACHE_ZCACHE_LEVELS = 0;
+
+/**
+ * One set of the L2 cache in this many is simulated, and the misses and DRAM
+ * writebacks of the others are estimated from them, or 1 to simulate every
+ * set.
+ */
+unsigned int L2CACHE_SAMPLE_RATIO = 1;
+
 /**
  * For static way partitioning, the quota of ways in each set that can be
  * assigned to core 0.
@@ -56,13 +82,219 @@ unsigned int SWP_CORE0_WAYS = 0;
 /** The number of cores being simulated. */
 unsigned int NUM_CORES = 0;
 
+/** The address ranges pinned in the L2 cache. */
+PinRange PIN_RANGES[MAX_PIN_RANGES];
+
+/** The number of pinned address ranges. */
+unsigned int NUM_PIN_RANGES = 0;
+
+/**
+ * The largest number of pinned lines in each L2 cache set, so that the other
+ * ways stay available to unpinned lines. 0 means half the associativity.
+ */
+unsigned int PIN_MAX_WAYS = 0;
+
+/** When dirty L2 lines are written back to DRAM. */
+L2WritebackPolicy L2CACHE_WB_POLICY = L2_WB_EVICT;
+
+/**
+ * For eager writeback, how many of the least recently used lines of a set are
+ * examined for a dirty line to clean.
+ */
+unsigned int L2CACHE_WB_EAGER_WAYS = 2;
+
+/** The prefetcher of the L2 cache. */
+L2PrefetcherType L2_PREFETCHER = L2PF_OFF;
+
+/** The number of lines the L2 prefetcher fetches per training access. */
+unsigned int L2PF_DEGREE = 4;
+
+/**
+ * Whether the L2 prefetcher metadata is kept in DRAM, where every lookup and
+ * update is a DRAM access, instead of in on-chip tables.
+ */
+bool L2PF_META_IN_DRAM = false;
+
+/** The on-chip storage for the L2 prefetcher metadata, in KB. */
+unsigned int L2PF_BUDGET_KB = 64;
+
+/** The prefetcher of the instruction caches. */
+IcachePrefetcherType ICACHE_PREFETCHER = IPF_OFF;
+
+/** The number of lines the next-line instruction prefetcher fetches. */
+unsigned int ICACHE_PF_DEGREE = 2;
+
+/** How many instructions ahead the fetch-directed prefetcher runs. */
+unsigned int ICACHE_PF_DEPTH = 32;
+
 /** Which page policy the DRAM should use. */
 DRAMPolicy DRAM_PAGE_POLICY = OPEN_PAGE;
 
+/** How the L2 cache is split into banks with non-uniform latency. */
+NucaMode NUCA_MODE = NUCA_OFF;
+
+/** The number of L2 cache banks, for NUCA. */
+unsigned int NUCA_BANKS = 8;
+
+/** The latency of one hop between adjacent L2 cache banks, in cycles. */
+unsigned int NUCA_HOP_LATENCY = 2;
+
+/** How the DRAM latency is computed in modes C through F. */
+DRAMModel DRAM_MODEL = DRAM_MODEL_ROWBUF;
+
+/** How the subarrays of each DRAM bank are organised. */
+DRAMSalp DRAM_SALP = SALP_OFF;
+
+/** The number of subarrays in each DRAM bank. */
+unsigned int DRAM_SUBARRAYS = 8;
+
+/**
+ * The number of recently opened rows each DRAM bank keeps in its row buffer
+ * cache, or 0 for a single row buffer.
+ */
+unsigned int DRAM_RBC_ROWS = 0;
+
+/** The associativity of the row buffer caches. */
+unsigned int DRAM_RBC_ASSOC = 2;
+
+/** The latency of reading a line from a row buffer cache, in cycles. */
+unsigned int DRAM_RBC_LATENCY = 45;
+
+/** The scheduler that orders the requests of each DRAM bank. */
+MemSchedulerType DRAM_SCHED = SCHED_OFF;
+
+/** The number of ranks the DRAM banks are split into for low-power states. */
+unsigned int DRAM_RANKS = 1;
+
+/**
+ * The idle cycles after which a DRAM rank enters power-down, or 0 for never.
+ */
+uint64_t DRAM_PD_THRESHOLD = 0;
+
+/**
+ * The idle cycles after which a DRAM rank enters self-refresh, or 0 for
+ * never.
+ */
+uint64_t DRAM_SR_THRESHOLD = 0;
+
+/** The RowHammer mitigation of the DRAM. */
+RowHammerMitigation RH_MITIGATION = RH_OFF;
+
+/** How the activations of the rows of each DRAM bank are counted. */
+RowHammerTracker RH_TRACKER = RH_TRACKER_MG;
+
+/**
+ * The number of activation counters per DRAM bank, or per row of the
+ * count-min sketch.
+ */
+unsigned int RH_COUNTERS = 64;
+
+/** The activations of a row in one refresh window that make it an aggressor. */
+unsigned int RH_THRESHOLD = 1024;
+
+/** The probability that PARA refreshes the neighbours of an activated row. */
+double RH_PARA_PROB = 0.001;
+
+/**
+ * Whether to run modes B and C on the pipelined multi-threaded engine, when
+ * it reproduces the serial simulation.
+ */
+bool PIPELINE_ENABLED = false;
+
+/**
+ * The number of instructions to decode ahead of execution, so the host can
+ * prefetch the simulated cache sets they will touch. 0 disables lookahead.
+ */
+unsigned int TRACE_LOOKAHEAD = 0;
+
+/**
+ * Whether to read traces from a decoded copy in shared memory, which is made
+ * by the first process on the host and mapped by the others.
+ */
+bool TRACE_SHM = false;
+
+/**
+ * Whether to decode traces in this process through a sidecar index of access
+ * points, made the first time a trace is read, instead of through gunzip.
+ */
+bool TRACE_INDEX = false;
+
+/**
+ * The threads that decode a trace into shared memory through its index, or 0
+ * for one per host core.
+ */
+unsigned int TRACE_THREADS = 0;
+
+/**
+ * The data cache configurations simulated side by side in mode A, one per
+ * lane. When any are given, they replace the single data cache.
+ */
+LaneConfig LANE_CONFIG[MAX_LANES];
+
+/** The number of lanes configured. */
+unsigned int NUM_LANES = 0;
+
+/**
+ * The number of loop iterations in a fast-forward window. Steady-state loops
+ * are skipped a window at a time, extrapolating the statistics of the last
+ * window simulated. 0 disables fast-forwarding.
+ */
+unsigned int FFWD_WINDOW = 0;
+
+/**
+ * The number of instructions at the start of each trace to skip before the
+ * detailed simulation, which alone is reported.
+ */
+uint64_t SKIP_INSTS = 0;
+
+/**
+ * The number of instructions just before the detailed simulation used to warm
+ * the caches. They are part of the skipped instructions.
+ */
+uint64_t WARM_INSTS = 0;
+
+/** How the caches are warmed before the detailed simulation. */
+WarmMethod WARM_METHOD = WARM_NONE;
+
+/** The model of the CPU cores. */
+CoreModel CORE_MODEL = CORE_MODEL_INORDER;
+
+/** For the interval core model, the instructions dispatched per cycle. */
+unsigned int DISPATCH_WIDTH = 4;
+
+/** For the interval core model, the number of reorder buffer entries. */
+unsigned int ROB_SIZE = 128;
+
+/**
+ * The number of sampling units to simulate instead of the whole trace. Each
+ * unit is warmed with WARM_INSTS instructions and simulated in detail for
+ * SAMPLE_INSTS. 0 disables sampling.
+ */
+unsigned int SAMPLE_UNITS = 0;
+
+/** The number of instructions simulated in detail in each sampling unit. */
+uint64_t SAMPLE_INSTS = 10000;
+
+/**
+ * The number of host threads simulating sampling units. 0 uses one per host
+ * core.
+ */
+unsigned int SAMPLE_THREADS = 0;
+
+/** Where the per-access energies of the caches come from, if at all. */
+EnergyModel ENERGY_MODEL = ENERGY_OFF;
+
+/**
+ * The coefficients of the linear energy model, in pJ per KB or per way, and
+ * mW per KB of leakage.
+ */
+EnergyCoeffs ENERGY_COEFFS = {0.1, 2.0, 0.11, 2.2, 0.5, 0.2};
+
 /**
- * The current clock cycle number.
+ * The current clock cycle number. Each host thread that simulates its own
+ * memory system keeps its own clock.
  */
-uint64_t current_cycle;
+thread_local uint64_t current_cycle;
 
 MemorySystem *memsys;
 Core *core[MAX_CORES];
@@ -82,15 +314,65 @@ int main(int argc, char **argv)
         return status;
     }
 
-    srand(42);
+    cache_seed_random(42);
     memsys = memsys_new();
     for (unsigned int i = 0; i < NUM_CORES; i++)
     {
         core[i] = core_new(memsys, trace_filename[i], i);
+        if (core[i] == NULL)
+        {
+            return 1;
+        }
+    }
+
+    if (opt_prepare(memsys, trace_filename[0]) != 0)
+    {
+        return 1;
+    }
+
+    if (SAMPLE_UNITS)
+    {
+        uint64_t cycles;
+        if (sample_run(memsys, core[0], &cycles) != 0)
+        {
+            tracecache_close(core[0]->trace_cache);
+            return 1;
+        }
+        current_cycle = cycles;
+        print_stats();
+        return 0;
+    }
+
+    if (SKIP_INSTS)
+    {
+        warm_run(memsys, core[0]);
     }
 
     print_dots();
 
+    if (NUM_LANES || (PIPELINE_ENABLED && pipeline_supported()))
+    {
+        uint64_t total_cycles = NUM_LANES ? lanes_run(core[0])
+                                          : pipeline_run(memsys, core[0]);
+
+        // Replay the progress dots the serial loop would have printed.
+        for (current_cycle = DOT_INTERVAL; current_cycle < total_cycles;
+             current_cycle += DOT_INTERVAL)
+        {
+            print_dots();
+        }
+        current_cycle = total_cycles;
+
+        print_stats();
+        return 0;
+    }
+
+    if (PIPELINE_ENABLED)
+    {
+        fprintf(stderr, "Warning: the pipelined engine needs mode B or C, "
+                        "one core and LRU; running serially\n");
+    }
+
     // Iterate until all cores are done.
     bool all_cores_done = false;
     while (!all_cores_done)
@@ -108,7 +390,38 @@ int main(int argc, char **argv)
             print_dots();
         }
 
-        current_cycle++;
+        if (CORE_MODEL != CORE_MODEL_INTERVAL)
+        {
+            current_cycle++;
+            continue;
+        }
+
+        // The interval model moves from one miss event to the next: skip to
+        // the first cycle a core wakes up in, printing the dots on the way.
+        uint64_t next_cycle = UINT64_MAX;
+        for (unsigned int i = 0; i < NUM_CORES; i++)
+        {
+            uint64_t wake_cycle = core[i]->snooze_end_cycle + 1;
+            if (wake_cycle <= current_cycle)
+            {
+                wake_cycle = current_cycle + 1;
+            }
+            if (!core[i]->done && wake_cycle < next_cycle)
+            {
+                next_cycle = wake_cycle;
+            }
+        }
+        if (next_cycle == UINT64_MAX)
+        {
+            next_cycle = current_cycle + 1;
+        }
+        for (uint64_t dot = last_printdot_cycle + DOT_INTERVAL;
+             dot < next_cycle; dot += DOT_INTERVAL)
+        {
+            current_cycle = dot;
+            print_dots();
+        }
+        current_cycle = next_cycle;
     }
 
     print_stats();
@@ -182,9 +495,9 @@ int parse_args(int argc, char **argv)
                 }
 
                 int repl = atoi(argv[i]);
-                if (repl < 0 || repl > 3)
+                if (repl < 0 || repl > 4)
                 {
-                    fprintf(stderr, "Error: repl must be between 0 and 3\n");
+                    fprintf(stderr, "Error: repl must be between 0 and 4\n");
                     return 2;
                 }
 
@@ -221,6 +534,36 @@ int parse_args(int argc, char **argv)
                 L2CACHE_SIZE = atoi(argv[i]) * 1024;
             }
 
+            else if (strcasecmp(argv[i], "-L2assoc") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2assoc\n");
+                    return 2;
+                }
+                L2CACHE_ASSOC = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-L2zcache") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2zcache\n");
+                    return 2;
+                }
+                L2CACHE_ZCACHE_LEVELS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-L2sample") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2sample\n");
+                    return 2;
+                }
+                L2CACHE_SAMPLE_RATIO = atoi(argv[i]);
+            }
+
             else if (strcasecmp(argv[i], "-L2repl") == 0)
             {
                 if (++i >= argc)
@@ -230,13 +573,135 @@ int parse_args(int argc, char **argv)
                 }
 
                 int l2repl = atoi(argv[i]);
-                if (l2repl < 0 || l2repl > 3)
+                if (l2repl < 0 || l2repl > 5)
                 {
-                    fprintf(stderr, "Error: L2repl must be between 0 and 3\n");
+                    fprintf(stderr, "Error: L2repl must be between 0 and 5\n");
                     return 2;
                 }
 
                 L2CACHE_REPL = (ReplacementPolicy)l2repl;
+                L2CACHE_REPL_SET = true;
+            }
+
+            else if (strcasecmp(argv[i], "-L2wb") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2wb\n");
+                    return 2;
+                }
+
+                int policy = atoi(argv[i]);
+                if (policy < L2_WB_EVICT || policy > L2_WB_EAGER_ROW)
+                {
+                    fprintf(stderr, "Error: invalid L2 writeback policy: "
+                                    "%s\n", argv[i]);
+                    return 2;
+                }
+
+                L2CACHE_WB_POLICY = (L2WritebackPolicy)policy;
+            }
+
+            else if (strcasecmp(argv[i], "-L2wb_ways") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2wb_ways\n");
+                    return 2;
+                }
+                L2CACHE_WB_EAGER_WAYS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-L2pf") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2pf\n");
+                    return 2;
+                }
+
+                int pf = atoi(argv[i]);
+                if (pf < L2PF_OFF || pf > L2PF_ISB)
+                {
+                    fprintf(stderr, "Error: invalid L2 prefetcher: %s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                L2_PREFETCHER = (L2PrefetcherType)pf;
+            }
+
+            else if (strcasecmp(argv[i], "-L2pf_degree") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-L2pf_degree\n");
+                    return 2;
+                }
+                L2PF_DEGREE = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-L2pf_meta") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -L2pf_meta\n");
+                    return 2;
+                }
+                L2PF_META_IN_DRAM = atoi(argv[i]) != 0;
+            }
+
+            else if (strcasecmp(argv[i], "-L2pf_budgetKB") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-L2pf_budgetKB\n");
+                    return 2;
+                }
+                L2PF_BUDGET_KB = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-Ipf") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -Ipf\n");
+                    return 2;
+                }
+
+                int pf = atoi(argv[i]);
+                if (pf < IPF_OFF || pf > IPF_FDP)
+                {
+                    fprintf(stderr, "Error: invalid instruction prefetcher: "
+                                    "%s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                ICACHE_PREFETCHER = (IcachePrefetcherType)pf;
+            }
+
+            else if (strcasecmp(argv[i], "-Ipf_degree") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-Ipf_degree\n");
+                    return 2;
+                }
+                ICACHE_PF_DEGREE = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-Ipf_depth") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -Ipf_depth\n");
+                    return 2;
+                }
+                ICACHE_PF_DEPTH = atoi(argv[i]);
             }
 
             else if (strcasecmp(argv[i], "-SWP_core0ways") == 0)
@@ -269,23 +734,622 @@ int parse_args(int argc, char **argv)
                 DRAM_PAGE_POLICY = (DRAMPolicy)dram_policy;
             }
 
-            else
-            {
-                fprintf(stderr, "Error: unrecognized option: %s\n", argv[i]);
-                return 2;
-            }
-        }
-        else
-        {
-            // Parse trace file name.
-            if (NUM_CORES >= MAX_CORES)
+            else if (strcasecmp(argv[i], "-pipeline") == 0)
             {
-                fprintf(stderr, "Error: too many trace files specified\n");
-                return 2;
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-pipeline\n");
+                    return 2;
+                }
+                PIPELINE_ENABLED = atoi(argv[i]) != 0;
             }
 
-            trace_filename[NUM_CORES] = argv[i];
-            NUM_CORES++;
+            else if (strcasecmp(argv[i], "-pin") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -pin\n");
+                    return 2;
+                }
+
+                // A comma-separated list of core:v|p:begin:end ranges.
+                const char *spec = argv[i];
+                while (*spec)
+                {
+                    unsigned int core_id;
+                    char kind;
+                    long long begin, end;
+                    int len;
+                    if (sscanf(spec, "%u:%c:%lli:%lli%n", &core_id, &kind,
+                               &begin, &end, &len) != 4 ||
+                        (spec[len] != ',' && spec[len] != '\0') ||
+                        (kind != 'v' && kind != 'p'))
+                    {
+                        fprintf(stderr, "Error: -pin must be a list of "
+                                        "core:v|p:begin:end\n");
+                        return 2;
+                    }
+                    if (core_id >= MAX_CORES ||
+                        !pin_add_range(core_id, kind == 'v', begin, end))
+                    {
+                        fprintf(stderr, "Error: at most %d nonempty pinned "
+                                        "ranges of cores below %d\n",
+                                MAX_PIN_RANGES, MAX_CORES);
+                        return 2;
+                    }
+
+                    spec += len;
+                    if (*spec == ',')
+                    {
+                        spec++;
+                    }
+                }
+            }
+
+            else if (strcasecmp(argv[i], "-pin_ways") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -pin_ways\n");
+                    return 2;
+                }
+                PIN_MAX_WAYS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-lanes") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -lanes\n");
+                    return 2;
+                }
+
+                // A comma-separated list of assoc:sizeKB:repl triples.
+                const char *spec = argv[i];
+                while (*spec)
+                {
+                    int assoc, size_kb, repl, len;
+                    if (NUM_LANES >= MAX_LANES)
+                    {
+                        fprintf(stderr, "Error: at most %d lanes\n",
+                                MAX_LANES);
+                        return 2;
+                    }
+                    if (sscanf(spec, "%d:%d:%d%n", &assoc, &size_kb, &repl,
+                               &len) != 3 ||
+                        (spec[len] != ',' && spec[len] != '\0'))
+                    {
+                        fprintf(stderr, "Error: lanes must be a list of "
+                                        "assoc:sizeKB:repl\n");
+                        return 2;
+                    }
+                    if (assoc < 1 || assoc > MAX_WAYS_PER_CACHE_SET ||
+                        size_kb < 1 || (repl != LRU && repl != RANDOM))
+                    {
+                        fprintf(stderr, "Error: lane assoc must be between 1 "
+                                        "and %d and repl 0 or 1\n",
+                                MAX_WAYS_PER_CACHE_SET);
+                        return 2;
+                    }
+
+                    LANE_CONFIG[NUM_LANES].assoc = assoc;
+                    LANE_CONFIG[NUM_LANES].size = size_kb * 1024;
+                    LANE_CONFIG[NUM_LANES].policy = (ReplacementPolicy)repl;
+                    NUM_LANES++;
+
+                    spec += len;
+                    if (*spec == ',')
+                    {
+                        spec++;
+                    }
+                }
+            }
+
+            else if (strcasecmp(argv[i], "-trace_shm") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-trace_shm\n");
+                    return 2;
+                }
+                TRACE_SHM = atoi(argv[i]) != 0;
+            }
+
+            else if (strcasecmp(argv[i], "-trace_index") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-trace_index\n");
+                    return 2;
+                }
+                TRACE_INDEX = atoi(argv[i]) != 0;
+            }
+
+            else if (strcasecmp(argv[i], "-trace_threads") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-trace_threads\n");
+                    return 2;
+                }
+                TRACE_THREADS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-lookahead") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-lookahead\n");
+                    return 2;
+                }
+
+                int lookahead = atoi(argv[i]);
+                if (lookahead < 0 || lookahead > MAX_LOOKAHEAD)
+                {
+                    fprintf(stderr, "Error: lookahead must be between 0 and "
+                                    "%d\n", MAX_LOOKAHEAD);
+                    return 2;
+                }
+
+                TRACE_LOOKAHEAD = lookahead;
+            }
+
+            else if (strcasecmp(argv[i], "-ffwd") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -ffwd\n");
+                    return 2;
+                }
+
+                int window = atoi(argv[i]);
+                if (window < 0 || window > FFWD_MAX_WINDOW)
+                {
+                    fprintf(stderr, "Error: ffwd window must be between 0 "
+                                    "and %d\n", FFWD_MAX_WINDOW);
+                    return 2;
+                }
+
+                FFWD_WINDOW = window;
+            }
+
+            else if (strcasecmp(argv[i], "-skip_insts") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-skip_insts\n");
+                    return 2;
+                }
+                SKIP_INSTS = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-warm_insts") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-warm_insts\n");
+                    return 2;
+                }
+                WARM_INSTS = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-warm_method") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-warm_method\n");
+                    return 2;
+                }
+
+                int method = atoi(argv[i]);
+                if (method < WARM_NONE || method > WARM_REVERSE)
+                {
+                    fprintf(stderr, "Error: invalid warm method: %s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                WARM_METHOD = (WarmMethod)method;
+            }
+
+            else if (strcasecmp(argv[i], "-nuca") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -nuca\n");
+                    return 2;
+                }
+
+                int mode = atoi(argv[i]);
+                if (mode < NUCA_OFF || mode > NUCA_DYNAMIC)
+                {
+                    fprintf(stderr, "Error: invalid NUCA mode: %s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                NUCA_MODE = (NucaMode)mode;
+            }
+
+            else if (strcasecmp(argv[i], "-nuca_banks") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-nuca_banks\n");
+                    return 2;
+                }
+                NUCA_BANKS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-nuca_hop_latency") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-nuca_hop_latency\n");
+                    return 2;
+                }
+                NUCA_HOP_LATENCY = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-dram_model") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dram_model\n");
+                    return 2;
+                }
+
+                int model = atoi(argv[i]);
+                if (model < DRAM_MODEL_ROWBUF || model > DRAM_MODEL_ANALYTICAL)
+                {
+                    fprintf(stderr, "Error: invalid DRAM model: %s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                DRAM_MODEL = (DRAMModel)model;
+            }
+
+            else if (strcasecmp(argv[i], "-dram_salp") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -dram_salp\n");
+                    return 2;
+                }
+
+                int salp = atoi(argv[i]);
+                if (salp < SALP_OFF || salp > SALP_MASA)
+                {
+                    fprintf(stderr, "Error: invalid subarray organisation: "
+                                    "%s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                DRAM_SALP = (DRAMSalp)salp;
+            }
+
+            else if (strcasecmp(argv[i], "-dram_subarrays") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dram_subarrays\n");
+                    return 2;
+                }
+                DRAM_SUBARRAYS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-dram_rbc") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -dram_rbc\n");
+                    return 2;
+                }
+                DRAM_RBC_ROWS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-dram_rbc_assoc") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dram_rbc_assoc\n");
+                    return 2;
+                }
+                DRAM_RBC_ASSOC = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-dram_rbc_latency") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dram_rbc_latency\n");
+                    return 2;
+                }
+                DRAM_RBC_LATENCY = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-dram_sched") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dram_sched\n");
+                    return 2;
+                }
+
+                int sched = atoi(argv[i]);
+                if (sched < SCHED_OFF || sched > SCHED_BLISS)
+                {
+                    fprintf(stderr, "Error: invalid memory scheduler: %s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                DRAM_SCHED = (MemSchedulerType)sched;
+            }
+
+            else if (strcasecmp(argv[i], "-dram_ranks") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dram_ranks\n");
+                    return 2;
+                }
+                DRAM_RANKS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-dram_pd_idle") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dram_pd_idle\n");
+                    return 2;
+                }
+                DRAM_PD_THRESHOLD = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-dram_sr_idle") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dram_sr_idle\n");
+                    return 2;
+                }
+                DRAM_SR_THRESHOLD = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-rh_mitigation") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-rh_mitigation\n");
+                    return 2;
+                }
+
+                int rh = atoi(argv[i]);
+                if (rh < RH_OFF || rh > RH_THROTTLE)
+                {
+                    fprintf(stderr, "Error: invalid RowHammer mitigation: "
+                                    "%s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                RH_MITIGATION = (RowHammerMitigation)rh;
+            }
+
+            else if (strcasecmp(argv[i], "-rh_tracker") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -rh_tracker\n");
+                    return 2;
+                }
+
+                int tracker = atoi(argv[i]);
+                if (tracker < RH_TRACKER_MG || tracker > RH_TRACKER_CMS)
+                {
+                    fprintf(stderr, "Error: invalid RowHammer tracker: %s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                RH_TRACKER = (RowHammerTracker)tracker;
+            }
+
+            else if (strcasecmp(argv[i], "-rh_counters") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-rh_counters\n");
+                    return 2;
+                }
+                RH_COUNTERS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-rh_threshold") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-rh_threshold\n");
+                    return 2;
+                }
+                RH_THRESHOLD = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-rh_para_prob") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-rh_para_prob\n");
+                    return 2;
+                }
+                RH_PARA_PROB = atof(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-core_model") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-core_model\n");
+                    return 2;
+                }
+
+                int model = atoi(argv[i]);
+                if (model < CORE_MODEL_INORDER || model > CORE_MODEL_INTERVAL)
+                {
+                    fprintf(stderr, "Error: invalid core model: %s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                CORE_MODEL = (CoreModel)model;
+            }
+
+            else if (strcasecmp(argv[i], "-dispatch_width") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-dispatch_width\n");
+                    return 2;
+                }
+                DISPATCH_WIDTH = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-rob_size") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-rob_size\n");
+                    return 2;
+                }
+                ROB_SIZE = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-sample_units") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-sample_units\n");
+                    return 2;
+                }
+
+                int units = atoi(argv[i]);
+                if (units <= 0)
+                {
+                    fprintf(stderr, "Error: sample units must be positive\n");
+                    return 2;
+                }
+
+                SAMPLE_UNITS = units;
+            }
+
+            else if (strcasecmp(argv[i], "-sample_insts") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-sample_insts\n");
+                    return 2;
+                }
+                SAMPLE_INSTS = strtoull(argv[i], NULL, 10);
+            }
+
+            else if (strcasecmp(argv[i], "-sample_threads") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-sample_threads\n");
+                    return 2;
+                }
+                SAMPLE_THREADS = atoi(argv[i]);
+            }
+
+            else if (strcasecmp(argv[i], "-energy") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to -energy\n");
+                    return 2;
+                }
+
+                int model = atoi(argv[i]);
+                if (model < ENERGY_OFF || model > ENERGY_LINEAR)
+                {
+                    fprintf(stderr, "Error: invalid energy model: %s\n",
+                            argv[i]);
+                    return 2;
+                }
+
+                ENERGY_MODEL = (EnergyModel)model;
+            }
+
+            else if (strcasecmp(argv[i], "-energy_coeffs") == 0)
+            {
+                if (++i >= argc)
+                {
+                    fprintf(stderr, "Error: missing argument to "
+                                    "-energy_coeffs\n");
+                    return 2;
+                }
+
+                EnergyCoeffs *ec = &ENERGY_COEFFS;
+                if (sscanf(argv[i], "%lf:%lf:%lf:%lf:%lf:%lf",
+                           &ec->read_per_kb, &ec->read_per_way,
+                           &ec->write_per_kb, &ec->write_per_way,
+                           &ec->tag_per_way, &ec->leak_per_kb) != 6)
+                {
+                    fprintf(stderr, "Error: invalid energy coefficients: "
+                                    "%s\n", argv[i]);
+                    return 2;
+                }
+            }
+
+            else
+            {
+                fprintf(stderr, "Error: unrecognized option: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else
+        {
+            // Parse trace file name.
+            if (NUM_CORES >= MAX_CORES)
+            {
+                fprintf(stderr, "Error: too many trace files specified\n");
+                return 2;
+            }
+
+            trace_filename[NUM_CORES] = argv[i];
+            NUM_CORES++;
         }
     }
 
@@ -295,6 +1359,303 @@ int parse_args(int argc, char **argv)
         return 2;
     }
 
+    if (NUM_LANES && (SIM_MODE != SIM_MODE_A || NUM_CORES != 1 ||
+                      CORE_MODEL != CORE_MODEL_INORDER))
+    {
+        fprintf(stderr, "Error: -lanes needs mode 1, one trace file and the "
+                        "in-order core model\n");
+        return 2;
+    }
+
+    if ((int)L2CACHE_ASSOC <= 0 || L2CACHE_ASSOC > MAX_WAYS_PER_CACHE_SET)
+    {
+        fprintf(stderr, "Error: -L2assoc must be between 1 and %d\n",
+                MAX_WAYS_PER_CACHE_SET);
+        return 2;
+    }
+
+    ReplacementPolicy l2_repl = (SIM_MODE == SIM_MODE_DEF || L2CACHE_REPL_SET)
+                                    ? L2CACHE_REPL
+                                    : REPL_POLICY;
+    if (L2CACHE_ZCACHE_LEVELS)
+    {
+        if ((int)L2CACHE_ZCACHE_LEVELS < 0 || SIM_MODE == SIM_MODE_A ||
+            NUCA_MODE != NUCA_OFF || WARM_METHOD != WARM_NONE ||
+            SAMPLE_UNITS || l2_repl == SWP || l2_repl == DWP)
+        {
+            fprintf(stderr, "Error: -L2zcache needs an L2 cache (mode 2, 3 or "
+                            "4), and no -nuca, -warm_method, -sample_units, "
+                            "or SWP or DWP replacement\n");
+            return 2;
+        }
+    }
+
+    if (REPL_POLICY == OPT || (SIM_MODE != SIM_MODE_A && l2_repl == OPT))
+    {
+        // The pre-pass must see the accesses of the simulation in the same
+        // order, with the same lines in the caches.
+        if (SIM_MODE == SIM_MODE_DEF || NUM_CORES != 1 || NUM_LANES ||
+            CORE_MODEL != CORE_MODEL_INORDER || SKIP_INSTS || FFWD_WINDOW ||
+            SAMPLE_UNITS || L2CACHE_ZCACHE_LEVELS || NUCA_MODE == NUCA_DYNAMIC)
+        {
+            fprintf(stderr, "Error: OPT replacement needs mode 1, 2 or 3, one "
+                            "trace file and the in-order core model, and no "
+                            "-lanes, -skip_insts, -ffwd, -sample_units, "
+                            "-L2zcache or dynamic -nuca\n");
+            return 2;
+        }
+    }
+
+    if (SIM_MODE != SIM_MODE_A && l2_repl == HAWKEYE &&
+        (L2CACHE_ZCACHE_LEVELS || NUCA_MODE == NUCA_DYNAMIC))
+    {
+        fprintf(stderr, "Error: Hawkeye replacement cannot be combined with "
+                        "-L2zcache or dynamic -nuca\n");
+        return 2;
+    }
+
+    if (NUM_PIN_RANGES)
+    {
+        if (PIN_MAX_WAYS == 0)
+        {
+            PIN_MAX_WAYS = L2CACHE_ASSOC / 2;
+        }
+        if (SIM_MODE == SIM_MODE_A || L2CACHE_ZCACHE_LEVELS ||
+            (int)PIN_MAX_WAYS <= 0 || PIN_MAX_WAYS >= L2CACHE_ASSOC)
+        {
+            fprintf(stderr, "Error: -pin needs an L2 cache (mode 2, 3 or 4) "
+                            "without -L2zcache, and -pin_ways between 1 and "
+                            "%llu\n",
+                    (unsigned long long)L2CACHE_ASSOC - 1);
+            return 2;
+        }
+    }
+
+    if (L2_PREFETCHER != L2PF_OFF)
+    {
+        // Prefetches are installed outside the access stream that OPT and
+        // Hawkeye learn from, and only into set-associative caches.
+        if (SIM_MODE == SIM_MODE_A || L2CACHE_ZCACHE_LEVELS ||
+            NUCA_MODE == NUCA_DYNAMIC || l2_repl == OPT ||
+            l2_repl == HAWKEYE || (int)L2PF_DEGREE <= 0 ||
+            L2PF_DEGREE > TEMPORAL_MAX_DEGREE || (int)L2PF_BUDGET_KB <= 0)
+        {
+            fprintf(stderr, "Error: -L2pf needs an L2 cache (mode 2, 3 or 4) "
+                            "without -L2zcache, dynamic -nuca, OPT or "
+                            "Hawkeye, -L2pf_degree between 1 and %d, and a "
+                            "positive -L2pf_budgetKB\n",
+                    TEMPORAL_MAX_DEGREE);
+            return 2;
+        }
+    }
+
+    if (ICACHE_PREFETCHER != IPF_OFF)
+    {
+        // Whether a prefetch is issued depends on the cycle it would arrive,
+        // which the OPT pre-pass does not know. Lines prefetched into the L2
+        // cache are installed as the L2 prefetcher's are.
+        if (SIM_MODE == SIM_MODE_A || REPL_POLICY == OPT || l2_repl == OPT ||
+            l2_repl == HAWKEYE || L2CACHE_ZCACHE_LEVELS ||
+            (int)ICACHE_PF_DEGREE <= 0 || ICACHE_PF_DEGREE > IPF_MAX_DEGREE ||
+            (int)ICACHE_PF_DEPTH <= 0 || ICACHE_PF_DEPTH > MAX_LOOKAHEAD)
+        {
+            fprintf(stderr, "Error: -Ipf needs an instruction cache (mode 2, 3 "
+                            "or 4) without OPT replacement, an L2 cache "
+                            "without Hawkeye or -L2zcache, -Ipf_degree "
+                            "between 1 and %d, and -Ipf_depth between 1 and "
+                            "%d\n",
+                    IPF_MAX_DEGREE, MAX_LOOKAHEAD);
+            return 2;
+        }
+    }
+
+    if (L2CACHE_WB_POLICY != L2_WB_EVICT)
+    {
+        if (SIM_MODE == SIM_MODE_A || L2CACHE_ZCACHE_LEVELS ||
+            (int)L2CACHE_WB_EAGER_WAYS <= 0 ||
+            L2CACHE_WB_EAGER_WAYS > L2CACHE_ASSOC)
+        {
+            fprintf(stderr, "Error: -L2wb needs an L2 cache (mode 2, 3 or 4) "
+                            "without -L2zcache, and -L2wb_ways between 1 and "
+                            "%llu\n",
+                    (unsigned long long)L2CACHE_ASSOC);
+            return 2;
+        }
+    }
+
+    if (L2CACHE_SAMPLE_RATIO != 1)
+    {
+        // The sampled sets must see every access to them, and their
+        // evictions must not depend on the sets that are not simulated. The
+        // ratio bits of the set index are folded onto the next ones.
+        uint64_t l2_sets = L2CACHE_SIZE / CACHE_LINESIZE / L2CACHE_ASSOC;
+        if ((int)L2CACHE_SAMPLE_RATIO <= 0 ||
+            (L2CACHE_SAMPLE_RATIO & (L2CACHE_SAMPLE_RATIO - 1)) ||
+            l2_sets / L2CACHE_SAMPLE_RATIO < L2CACHE_SAMPLE_RATIO ||
+            SIM_MODE == SIM_MODE_A || l2_repl == OPT || L2CACHE_ZCACHE_LEVELS ||
+            NUCA_MODE != NUCA_OFF || NUM_PIN_RANGES ||
+            L2CACHE_WB_POLICY != L2_WB_EVICT || L2_PREFETCHER != L2PF_OFF ||
+            ENERGY_MODEL != ENERGY_OFF || DRAM_SCHED != SCHED_OFF ||
+            RH_MITIGATION != RH_OFF || DRAM_PD_THRESHOLD ||
+            DRAM_SR_THRESHOLD)
+        {
+            fprintf(stderr, "Error: -L2sample needs an L2 cache (mode 2, 3 or "
+                            "4) without OPT, -L2zcache, -nuca, -pin, -L2wb, "
+                            "-L2pf, -energy, -dram_sched, -rh_mitigation, "
+                            "-dram_pd_idle or -dram_sr_idle, and a power of "
+                            "two no larger than the sets it leaves\n");
+            return 2;
+        }
+    }
+
+    if (NUCA_MODE != NUCA_OFF)
+    {
+        uint64_t l2_sets = L2CACHE_SIZE / CACHE_LINESIZE / L2CACHE_ASSOC;
+        uint64_t max_banks = (NUCA_MODE == NUCA_STATIC) ? l2_sets
+                                                        : L2CACHE_ASSOC;
+        if (SIM_MODE == SIM_MODE_A || (int)NUCA_BANKS <= 0 ||
+            NUCA_BANKS > max_banks)
+        {
+            fprintf(stderr, "Error: -nuca needs an L2 cache (mode 2, 3 or 4) "
+                            "and between 1 and %llu banks\n",
+                    (unsigned long long)max_banks);
+            return 2;
+        }
+
+        // Warming reorders the ways of each set, and D-NUCA ties each way
+        // to a bank.
+        if (NUCA_MODE == NUCA_DYNAMIC && WARM_METHOD != WARM_NONE)
+        {
+            fprintf(stderr, "Error: dynamic -nuca needs -warm_method 0\n");
+            return 2;
+        }
+    }
+
+    if (DRAM_SALP != SALP_OFF)
+    {
+        if ((SIM_MODE != SIM_MODE_C && SIM_MODE != SIM_MODE_DEF) ||
+            DRAM_PAGE_POLICY != OPEN_PAGE || DRAM_MODEL != DRAM_MODEL_ROWBUF ||
+            (int)DRAM_SUBARRAYS <= 0 || DRAM_SUBARRAYS > MAX_SUBARRAYS)
+        {
+            fprintf(stderr, "Error: -dram_salp needs mode 3 or 4, the "
+                            "open-page policy, the row buffer DRAM model, and "
+                            "-dram_subarrays between 1 and %d\n",
+                    MAX_SUBARRAYS);
+            return 2;
+        }
+    }
+
+    if (DRAM_RBC_ROWS)
+    {
+        if ((SIM_MODE != SIM_MODE_C && SIM_MODE != SIM_MODE_DEF) ||
+            DRAM_MODEL != DRAM_MODEL_ROWBUF || DRAM_SALP != SALP_OFF ||
+            (int)DRAM_RBC_ROWS < 0 || DRAM_RBC_ROWS > MAX_RBC_ROWS ||
+            (int)DRAM_RBC_ASSOC <= 0 || DRAM_RBC_ROWS % DRAM_RBC_ASSOC ||
+            (int)DRAM_RBC_LATENCY < 0)
+        {
+            fprintf(stderr, "Error: -dram_rbc needs mode 3 or 4, the row "
+                            "buffer DRAM model and no -dram_salp, at most %d "
+                            "rows, a -dram_rbc_assoc that divides them, and "
+                            "a non-negative -dram_rbc_latency\n",
+                    MAX_RBC_ROWS);
+            return 2;
+        }
+    }
+
+    if (DRAM_SCHED != SCHED_OFF)
+    {
+        if ((SIM_MODE != SIM_MODE_C && SIM_MODE != SIM_MODE_DEF) ||
+            DRAM_PAGE_POLICY != OPEN_PAGE || DRAM_MODEL != DRAM_MODEL_ROWBUF ||
+            DRAM_SALP != SALP_OFF || DRAM_RBC_ROWS || RH_MITIGATION != RH_OFF)
+        {
+            fprintf(stderr, "Error: -dram_sched needs mode 3 or 4, the "
+                            "open-page policy and the row buffer DRAM model, "
+                            "without -dram_salp, -dram_rbc or "
+                            "-rh_mitigation\n");
+            return 2;
+        }
+    }
+
+    if ((int)DRAM_RANKS <= 0 || DRAM_RANKS > 16 || 16 % DRAM_RANKS)
+    {
+        fprintf(stderr, "Error: -dram_ranks needs a divisor of the 16 DRAM "
+                        "banks\n");
+        return 2;
+    }
+
+    if (DRAM_PD_THRESHOLD || DRAM_SR_THRESHOLD)
+    {
+        if (SIM_MODE == SIM_MODE_A ||
+            (DRAM_PD_THRESHOLD && DRAM_SR_THRESHOLD &&
+             DRAM_SR_THRESHOLD <= DRAM_PD_THRESHOLD))
+        {
+            fprintf(stderr, "Error: -dram_pd_idle and -dram_sr_idle need "
+                            "mode 2, 3 or 4, and self-refresh must come "
+                            "after power-down\n");
+            return 2;
+        }
+    }
+
+    if (RH_MITIGATION != RH_OFF)
+    {
+        if ((SIM_MODE != SIM_MODE_C && SIM_MODE != SIM_MODE_DEF) ||
+            (int)RH_COUNTERS <= 0 || RH_COUNTERS > RH_MAX_COUNTERS ||
+            (int)RH_THRESHOLD <= 0 || RH_PARA_PROB < 0.0 ||
+            RH_PARA_PROB > 1.0)
+        {
+            fprintf(stderr, "Error: -rh_mitigation needs mode 3 or 4, "
+                            "-rh_counters between 1 and %d, a positive "
+                            "-rh_threshold, and -rh_para_prob between 0 "
+                            "and 1\n",
+                    RH_MAX_COUNTERS);
+            return 2;
+        }
+    }
+
+    if ((int)DISPATCH_WIDTH <= 0 || (int)ROB_SIZE < 0)
+    {
+        fprintf(stderr, "Error: -dispatch_width must be positive and "
+                        "-rob_size must not be negative\n");
+        return 2;
+    }
+
+    if (ENERGY_MODEL != ENERGY_OFF && NUM_LANES)
+    {
+        fprintf(stderr, "Error: -energy cannot be combined with -lanes\n");
+        return 2;
+    }
+
+    // The per-set counts of -L2sample are too many to extrapolate.
+    if (FFWD_WINDOW &&
+        (NUM_LANES || NUM_CORES != 1 || L2CACHE_SAMPLE_RATIO != 1))
+    {
+        fprintf(stderr, "Error: -ffwd needs one trace file, and no -lanes or "
+                        "-L2sample\n");
+        return 2;
+    }
+
+    if (SKIP_INSTS && (NUM_LANES || NUM_CORES != 1))
+    {
+        fprintf(stderr, "Error: -skip_insts needs one trace file and no "
+                        "-lanes\n");
+        return 2;
+    }
+
+    if (SAMPLE_UNITS)
+    {
+        if (NUM_CORES != 1 || NUM_LANES || SKIP_INSTS || FFWD_WINDOW ||
+            SAMPLE_INSTS == 0)
+        {
+            fprintf(stderr, "Error: -sample_units needs one trace file, a "
+                            "nonzero -sample_insts, and no -lanes, "
+                            "-skip_insts or -ffwd\n");
+            return 2;
+        }
+
+        // Units read their instructions at random from the decoded trace.
+        TRACE_SHM = true;
+    }
+
     return 0;
 }
 
@@ -335,7 +1696,43 @@ void print_stats()
         core_print_stats(core[i]);
     }
 
+    if (SKIP_INSTS)
+    {
+        warm_print_stats();
+    }
+
+    if (SAMPLE_UNITS)
+    {
+        sample_print_stats();
+    }
+
+    if (NUM_LANES)
+    {
+        lanes_print_stats();
+        return;
+    }
+
     memsys_print_stats(memsys);
+
+    if (DRAM_SCHED != SCHED_OFF)
+    {
+        uint64_t cycles[MAX_CORES];
+        for (unsigned int i = 0; i < NUM_CORES; i++)
+        {
+            cycles[i] = core[i]->done_cycle_count;
+        }
+        sched_print_slowdown(memsys->dram->sched, cycles, NUM_CORES);
+    }
+
+    if (ENERGY_MODEL != ENERGY_OFF)
+    {
+        unsigned long long insts = 0;
+        for (unsigned int i = 0; i < NUM_CORES; i++)
+        {
+            insts += core[i]->done_inst_count;
+        }
+        energy_print_stats(memsys, current_cycle, insts);
+    }
 }
 
 void print_usage(const char *program_name)
@@ -354,8 +1751,8 @@ void print_usage(const char *program_name)
     fprintf(stderr, "                            (default: 64)\n");
     fprintf(stderr, "    -repl <num>             Set replacement policy for "
                     "L1 cache [0: LRU,\n");
-    fprintf(stderr, "                            1: random, 2: SWP, 3: DWP] "
-                    "(default: 0)\n");
+    fprintf(stderr, "                            1: random, 2: SWP, 3: DWP, "
+                    "4: OPT] (default: 0)\n");
     fprintf(stderr, "    -DsizeKB <num>          Set capacity in KB of the L1 "
                     "dcache (default: 32 KB)\n");
     fprintf(stderr, "    -Dassoc <num>           Set associativity of the L1 "
@@ -363,13 +1760,127 @@ void print_usage(const char *program_name)
     fprintf(stderr, "    -L2sizeKB <num>         Set capacity in KB of the "
                     "unified L2 cache\n");
     fprintf(stderr, "                            (default: 512 KB)\n");
+    fprintf(stderr, "    -L2assoc <num>          Set associativity of the L2 "
+                    "cache (default: 16)\n");
+    fprintf(stderr, "    -L2zcache <num>         Organise the L2 cache as a "
+                    "zcache with this many\n");
+    fprintf(stderr, "                            levels of replacement "
+                    "candidates [0: off] (default: 0)\n");
+    fprintf(stderr, "    -L2sample <num>         Simulate one L2 set in this "
+                    "many and estimate the\n");
+    fprintf(stderr, "                            misses of the rest "
+                    "(default: 1)\n");
     fprintf(stderr, "    -L2repl <num>           Set replacement policy for "
                     "L2 cache [0: LRU,\n");
-    fprintf(stderr, "                            1: random, 2: SWP, 3: DWP] "
-                    "(default: 0)\n");
+    fprintf(stderr, "                            1: random, 2: SWP, 3: DWP, "
+                    "4: OPT, 5: Hawkeye]\n");
+    fprintf(stderr, "                            (default: 0)\n");
+    fprintf(stderr, "    -L2wb <num>             Set when dirty L2 lines are "
+                    "written back [0: evict,\n");
+    fprintf(stderr, "                            1: eager, 2: row-aware, "
+                    "3: both] (default: 0)\n");
+    fprintf(stderr, "    -L2wb_ways <num>        Set the LRU lines eager "
+                    "writeback examines (default: 2)\n");
+    fprintf(stderr, "    -L2pf <num>             Set the L2 prefetcher "
+                    "[0: off, 1: GHB, 2: ISB]\n");
+    fprintf(stderr, "                            (default: 0)\n");
+    fprintf(stderr, "    -L2pf_degree <num>      Set the lines prefetched per "
+                    "L2 miss (default: 4)\n");
+    fprintf(stderr, "    -L2pf_meta <num>        Keep prefetcher metadata "
+                    "[0: on chip, 1: in DRAM]\n");
+    fprintf(stderr, "                            (default: 0)\n");
+    fprintf(stderr, "    -L2pf_budgetKB <num>    Set the on-chip prefetcher "
+                    "metadata size (default: 64)\n");
+    fprintf(stderr, "    -Ipf <num>              Set the instruction "
+                    "prefetcher [0: off,\n");
+    fprintf(stderr, "                            1: next-line, 2: "
+                    "fetch-directed] (default: 0)\n");
+    fprintf(stderr, "    -Ipf_degree <num>       Set the lines the next-line "
+                    "prefetcher fetches\n");
+    fprintf(stderr, "                            (default: 2)\n");
+    fprintf(stderr, "    -Ipf_depth <num>        Set the instructions the "
+                    "fetch-directed prefetcher\n");
+    fprintf(stderr, "                            runs ahead (default: 32)\n");
     fprintf(stderr, "    -SWP_core0ways <num>    Set static quota for core 0 "
                     "in SWP (default: 1)\n");
     fprintf(stderr, "    -dram_policy <num>      Set DRAM page policy "
                     "[0: open-page, 1: close-page]\n");
     fprintf(stderr, "                            (default: 0)\n");
+    fprintf(stderr, "    -nuca <num>             Split the L2 cache into banks "
+                    "with distance-dependent\n");
+    fprintf(stderr, "                            latency [0: off, 1: static, "
+                    "2: dynamic] (default: 0)\n");
+    fprintf(stderr, "    -nuca_banks <num>       Set the number of L2 banks "
+                    "(default: 8)\n");
+    fprintf(stderr, "    -nuca_hop_latency <num> Set the cycles per hop "
+                    "between L2 banks (default: 2)\n");
+    fprintf(stderr, "    -dram_model <num>       Set the DRAM latency model "
+                    "[0: row buffers,\n");
+    fprintf(stderr, "                            1: analytical queueing] "
+                    "(default: 0)\n");
+    fprintf(stderr, "    -dram_salp <num>        Set the subarray "
+                    "parallelism of DRAM banks [0: off,\n");
+    fprintf(stderr, "                            1: none, 2: SALP-1, "
+                    "3: SALP-2, 4: MASA] (default: 0)\n");
+    fprintf(stderr, "    -dram_subarrays <num>   Set the subarrays per DRAM "
+                    "bank (default: 8)\n");
+    fprintf(stderr, "    -dram_rbc <num>         Keep this many recently "
+                    "opened rows per DRAM bank\n");
+    fprintf(stderr, "                            [0: one row buffer] "
+                    "(default: 0)\n");
+    fprintf(stderr, "    -dram_rbc_assoc <num>   Set associativity of the row "
+                    "buffer caches (default: 2)\n");
+    fprintf(stderr, "    -dram_rbc_latency <num> Set the row buffer cache hit "
+                    "latency (default: 45)\n");
+    fprintf(stderr, "    -dram_sched <num>       Set the memory scheduler "
+                    "[0: none, 1: FCFS, 2: FR-FCFS,\n");
+    fprintf(stderr, "                            3: PAR-BS, 4: ATLAS, "
+                    "5: TCM, 6: BLISS] (default: 0)\n");
+    fprintf(stderr, "    -dram_ranks <num>       Set the ranks the DRAM "
+                    "banks are split into (default: 1)\n");
+    fprintf(stderr, "    -dram_pd_idle <num>     Set the idle cycles before "
+                    "a rank powers down\n");
+    fprintf(stderr, "                            (default: 0, never)\n");
+    fprintf(stderr, "    -dram_sr_idle <num>     Set the idle cycles before "
+                    "a rank self-refreshes\n");
+    fprintf(stderr, "                            (default: 0, never)\n");
+    fprintf(stderr, "    -rh_mitigation <num>    Set the RowHammer "
+                    "mitigation [0: off, 1: track only,\n");
+    fprintf(stderr, "                            2: PARA, 3: TRR, "
+                    "4: throttle] (default: 0)\n");
+    fprintf(stderr, "    -rh_tracker <num>       Set the activation tracker "
+                    "[0: Misra-Gries,\n");
+    fprintf(stderr, "                            1: count-min sketch] "
+                    "(default: 0)\n");
+    fprintf(stderr, "    -rh_counters <num>      Set the activation counters "
+                    "per bank (default: 64)\n");
+    fprintf(stderr, "    -rh_threshold <num>     Set the activations per "
+                    "refresh window of an\n");
+    fprintf(stderr, "                            aggressor row "
+                    "(default: 1024)\n");
+    fprintf(stderr, "    -rh_para_prob <num>     Set the PARA refresh "
+                    "probability (default: 0.001)\n");
+    fprintf(stderr, "    -pipeline <num>         Run modes B/C on one host "
+                    "thread per level [0: off,\n");
+    fprintf(stderr, "                            1: on] (default: 0)\n");
+    fprintf(stderr, "    -lanes <list>           In mode 1, simulate up to %d "
+                    "dcaches given as\n", MAX_LANES);
+    fprintf(stderr, "                            assoc:sizeKB:repl[,...] over "
+                    "one trace\n");
+    fprintf(stderr, "    -trace_shm <num>        Share decoded traces between "
+                    "processes on this host\n");
+    fprintf(stderr, "                            [0: off, 1: on] "
+                    "(default: 0)\n");
+    fprintf(stderr, "    -trace_index <num>      Decode traces through a "
+                    "sidecar index of access\n");
+    fprintf(stderr, "                            points [0: off, 1: on] "
+                    "(default: 0)\n");
+    fprintf(stderr, "    -trace_threads <num>    Decode a shared trace in "
+                    "this many segments at\n");
+    fprintf(stderr, "                            once through its index "
+                    "[0: one per core] (default: 0)\n");
+    fprintf(stderr, "    -lookahead <num>        Decode this many instructions "
+                    "ahead and prefetch\n");
+    fprintf(stderr, "                            their cache sets on the host "
+                    "(default: 0)\n");
 }
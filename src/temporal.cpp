@@ -0,0 +1,418 @@
+// temporal.cpp
+// Defines the temporal prefetchers of the L2 cache, which replay the misses
+// that followed an address the last time it missed.
+//
+// GHB keeps a ring of recent misses, each linked to the previous miss to the
+// same line, and an index from lines to their latest miss. The misses that
+// followed the previous occurrence of a line are prefetched.
+//
+// ISB (Jain and Lin, MICRO 2013) gives lines that miss one after another
+// under the same PC consecutive structural addresses, so that a correlated
+// stream becomes sequential, and prefetches the lines mapped to the next
+// structural addresses.
+
+#include "temporal.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The cache line address where metadata tables kept in DRAM start, above
+ * every physical line the traces use. Each table gets its own region.
+ */
+#define TEMPORAL_META_BASE (1ULL << 32)
+#define TEMPORAL_META_REGION_BITS 24
+
+/** The metadata tables, numbering their DRAM regions. */
+#define TABLE_GHB 0
+#define TABLE_GHB_INDEX 1
+#define TABLE_ISB_PS 2
+#define TABLE_ISB_SP 3
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The number of bytes in a cache line. */
+extern uint64_t CACHE_LINESIZE;
+
+/** The number of lines the L2 prefetcher fetches per training access. */
+extern unsigned int L2PF_DEGREE;
+
+/** Whether the L2 prefetcher metadata is kept in DRAM instead of on chip. */
+extern bool L2PF_META_IN_DRAM;
+
+/** The on-chip storage for the L2 prefetcher metadata, in KB. */
+extern unsigned int L2PF_BUDGET_KB;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+static uint64_t temporal_hash(uint64_t key)
+{
+    return (key * 0x9e3779b97f4a7c15ULL) >> 24;
+}
+
+/**
+ * Read or write the line of a metadata table holding the given entry, if the
+ * metadata is kept in DRAM.
+ */
+static void meta_access(TemporalPrefetcher *tp, DRAM *dram, unsigned table,
+                        uint64_t entry, bool is_write)
+{
+    if (!tp->meta_in_dram)
+    {
+        return;
+    }
+
+    uint64_t line_addr = TEMPORAL_META_BASE +
+                         ((uint64_t)table << TEMPORAL_META_REGION_BITS) +
+                         entry / tp->entries_per_line;
+    dram_access(dram, line_addr, is_write);
+    if (is_write)
+        tp->stat_meta_writes++;
+    else
+        tp->stat_meta_reads++;
+}
+
+/**
+ * Find the number of entries of each of the two tables of a prefetcher: the
+ * largest power of 2 that fits half the budget, or TEMPORAL_DRAM_ENTRIES.
+ */
+static uint64_t table_entries()
+{
+    if (L2PF_META_IN_DRAM)
+    {
+        return TEMPORAL_DRAM_ENTRIES;
+    }
+
+    uint64_t budget = (uint64_t)L2PF_BUDGET_KB * 1024 / 2 /
+                      TEMPORAL_ENTRY_BYTES;
+    uint64_t entries = 1;
+    while (entries * 2 <= budget)
+    {
+        entries *= 2;
+    }
+    return entries;
+}
+
+/**
+ * Allocate and initialize a temporal prefetcher, with tables sized to fit
+ * L2PF_BUDGET_KB on chip, or TEMPORAL_DRAM_ENTRIES each in DRAM.
+ *
+ * @param type The kind of prefetcher.
+ * @return A pointer to the prefetcher.
+ */
+TemporalPrefetcher *temporal_new(L2PrefetcherType type)
+{
+    TemporalPrefetcher *tp =
+        (TemporalPrefetcher *)calloc(1, sizeof(TemporalPrefetcher));
+    tp->type = type;
+    tp->degree = L2PF_DEGREE;
+    tp->meta_in_dram = L2PF_META_IN_DRAM;
+    tp->entries_per_line = CACHE_LINESIZE / TEMPORAL_ENTRY_BYTES;
+
+    uint64_t entries = table_entries();
+    if (type == L2PF_GHB)
+    {
+        tp->ghb = (GhbEntry *)calloc(entries, sizeof(GhbEntry));
+        tp->ghb_mask = entries - 1;
+        tp->ghb_index = (GhbIndexEntry *)calloc(entries,
+                                                sizeof(GhbIndexEntry));
+        tp->ghb_index_mask = entries - 1;
+    }
+    else
+    {
+        tp->isb_ps = (IsbMapEntry *)calloc(entries, sizeof(IsbMapEntry));
+        tp->isb_ps_mask = entries - 1;
+        tp->isb_sp = (IsbMapEntry *)calloc(entries, sizeof(IsbMapEntry));
+        tp->isb_sp_mask = entries - 1;
+    }
+    return tp;
+}
+
+/**
+ * Record a miss in the global history buffer, and find the misses that
+ * followed the previous miss to the same line.
+ */
+static unsigned ghb_train(TemporalPrefetcher *tp, DRAM *dram,
+                          uint64_t line_addr, uint64_t *candidates)
+{
+    uint64_t slot = temporal_hash(line_addr) & tp->ghb_index_mask;
+    GhbIndexEntry *index = &tp->ghb_index[slot];
+    meta_access(tp, dram, TABLE_GHB_INDEX, slot, false);
+
+    uint64_t prev = 0;
+    if (index->pos && index->line_addr == line_addr &&
+        tp->ghb_head - (index->pos - 1) <= tp->ghb_mask)
+    {
+        prev = index->pos;
+    }
+
+    // Misses are appended a line of entries at a time.
+    uint64_t pos = tp->ghb_head++;
+    tp->ghb[pos & tp->ghb_mask].line_addr = line_addr;
+    tp->ghb[pos & tp->ghb_mask].prev = prev;
+    if ((pos + 1) % tp->entries_per_line == 0)
+    {
+        meta_access(tp, dram, TABLE_GHB, pos & tp->ghb_mask, true);
+    }
+
+    index->line_addr = line_addr;
+    index->pos = pos + 1;
+    meta_access(tp, dram, TABLE_GHB_INDEX, slot, true);
+
+    if (prev == 0)
+    {
+        return 0;
+    }
+
+    unsigned n = 0;
+    uint64_t last_line = UINT64_MAX;
+    for (uint64_t p = prev; p < pos && n < tp->degree; p++)
+    {
+        uint64_t entry = p & tp->ghb_mask;
+        if (entry / tp->entries_per_line != last_line)
+        {
+            last_line = entry / tp->entries_per_line;
+            meta_access(tp, dram, TABLE_GHB, entry, false);
+        }
+        if (tp->ghb[entry].line_addr != line_addr)
+        {
+            candidates[n++] = tp->ghb[entry].line_addr;
+        }
+    }
+    return n;
+}
+
+/**
+ * Look up a mapping of ISB, in the physical-to-structural or the
+ * structural-to-physical map.
+ */
+static IsbMapEntry *isb_find(TemporalPrefetcher *tp, bool to_structural,
+                             uint64_t key)
+{
+    IsbMapEntry *entry = to_structural
+                             ? &tp->isb_ps[temporal_hash(key) &
+                                           tp->isb_ps_mask]
+                             : &tp->isb_sp[key & tp->isb_sp_mask];
+    return (entry->valid && entry->key == key) ? entry : NULL;
+}
+
+/**
+ * Look up the structural address of a line, reading the metadata from DRAM
+ * if it is kept there.
+ */
+static IsbMapEntry *isb_read_ps(TemporalPrefetcher *tp, DRAM *dram,
+                                uint64_t line_addr)
+{
+    meta_access(tp, dram, TABLE_ISB_PS,
+                temporal_hash(line_addr) & tp->isb_ps_mask, false);
+    return isb_find(tp, true, line_addr);
+}
+
+/**
+ * Map a line to a structural address and back. A new mapping survives one
+ * miss that contradicts it.
+ */
+static void isb_map(TemporalPrefetcher *tp, DRAM *dram, uint64_t line_addr,
+                    uint64_t structural)
+{
+    uint64_t ps_slot = temporal_hash(line_addr) & tp->isb_ps_mask;
+    IsbMapEntry *ps = &tp->isb_ps[ps_slot];
+    ps->valid = true;
+    ps->key = line_addr;
+    ps->value = structural;
+    ps->confidence = 1;
+    meta_access(tp, dram, TABLE_ISB_PS, ps_slot, true);
+
+    uint64_t sp_slot = structural & tp->isb_sp_mask;
+    IsbMapEntry *sp = &tp->isb_sp[sp_slot];
+    sp->valid = true;
+    sp->key = structural;
+    sp->value = line_addr;
+    meta_access(tp, dram, TABLE_ISB_SP, sp_slot, true);
+}
+
+/**
+ * Give a line the structural address after that of the previous line missed
+ * under the same PC, then find the lines mapped after it.
+ */
+static unsigned isb_train(TemporalPrefetcher *tp, DRAM *dram,
+                          uint64_t line_addr, uint64_t pc,
+                          unsigned int core_id, uint64_t *candidates)
+{
+    IsbTrainingEntry *train =
+        &tp->isb_training[temporal_hash(pc ^ ((uint64_t)core_id << 48)) %
+                          ISB_TRAINING_ENTRIES];
+    IsbMapEntry *cur = isb_read_ps(tp, dram, line_addr);
+
+    if (train->valid && train->line_addr != line_addr)
+    {
+        IsbMapEntry *prev = isb_read_ps(tp, dram, train->line_addr);
+        uint64_t prev_structural;
+        if (prev)
+        {
+            prev_structural = prev->value;
+        }
+        else
+        {
+            // Start a new stream.
+            prev_structural = tp->isb_next_stream;
+            tp->isb_next_stream += ISB_STREAM_CHUNK;
+            isb_map(tp, dram, train->line_addr, prev_structural);
+            cur = isb_find(tp, true, line_addr);
+        }
+
+        // A stream that used up its chunk continues at the start of another.
+        uint64_t next = prev_structural + 1;
+        bool chunk_end = next % ISB_STREAM_CHUNK == 0;
+
+        if (cur && (chunk_end ? cur->value % ISB_STREAM_CHUNK == 0
+                              : cur->value == next))
+        {
+            if (cur->confidence < ISB_CONFIDENCE_MAX)
+            {
+                cur->confidence++;
+            }
+        }
+        else if (cur && cur->confidence > 0)
+        {
+            // Keep a confirmed mapping through one out-of-order miss, so
+            // that a single change does not remap the rest of the stream.
+            cur->confidence--;
+        }
+        else
+        {
+            if (chunk_end)
+            {
+                next = tp->isb_next_stream;
+                tp->isb_next_stream += ISB_STREAM_CHUNK;
+            }
+            isb_map(tp, dram, line_addr, next);
+            cur = isb_find(tp, true, line_addr);
+        }
+    }
+    train->valid = true;
+    train->line_addr = line_addr;
+
+    if (cur == NULL)
+    {
+        return 0;
+    }
+
+    unsigned n = 0;
+    uint64_t last_line = UINT64_MAX;
+    for (unsigned k = 1; k <= tp->degree; k++)
+    {
+        uint64_t structural = cur->value + k;
+        uint64_t slot = structural & tp->isb_sp_mask;
+        if (slot / tp->entries_per_line != last_line)
+        {
+            last_line = slot / tp->entries_per_line;
+            meta_access(tp, dram, TABLE_ISB_SP, slot, false);
+        }
+        IsbMapEntry *sp = isb_find(tp, false, structural);
+        if (sp == NULL)
+        {
+            break;
+        }
+        candidates[n++] = sp->value;
+    }
+    return n;
+}
+
+/**
+ * Record an L2 miss (or first hit on a prefetched line), and find the lines
+ * to prefetch. Metadata kept in DRAM is read and written through the DRAM.
+ *
+ * @param tp The prefetcher.
+ * @param dram The DRAM module holding the metadata.
+ * @param line_addr The address of the cache line accessed (in units of the
+ *                  cache line size).
+ * @param pc The address of the instruction that made the access.
+ * @param core_id The CPU core ID that made the access.
+ * @param candidates Receives up to TEMPORAL_MAX_DEGREE line addresses.
+ * @return The number of lines to prefetch.
+ */
+unsigned int temporal_train(TemporalPrefetcher *tp, DRAM *dram,
+                            uint64_t line_addr, uint64_t pc,
+                            unsigned int core_id, uint64_t *candidates)
+{
+    unsigned n;
+    if (tp->type == L2PF_GHB)
+    {
+        n = ghb_train(tp, dram, line_addr, candidates);
+    }
+    else
+    {
+        n = isb_train(tp, dram, line_addr, pc, core_id, candidates);
+    }
+
+    tp->stat_trains++;
+    tp->stat_candidates += n;
+    return n;
+}
+
+/**
+ * Reset the statistics of a temporal prefetcher.
+ *
+ * @param tp The prefetcher.
+ */
+void temporal_clear_stats(TemporalPrefetcher *tp)
+{
+    tp->stat_trains = 0;
+    tp->stat_candidates = 0;
+    tp->stat_meta_reads = 0;
+    tp->stat_meta_writes = 0;
+}
+
+/**
+ * Add the statistics of one temporal prefetcher to those of another.
+ *
+ * @param dst The prefetcher whose statistics are increased.
+ * @param src The prefetcher whose statistics are added.
+ */
+void temporal_add_stats(TemporalPrefetcher *dst,
+                        const TemporalPrefetcher *src)
+{
+    dst->stat_trains += src->stat_trains;
+    dst->stat_candidates += src->stat_candidates;
+    dst->stat_meta_reads += src->stat_meta_reads;
+    dst->stat_meta_writes += src->stat_meta_writes;
+}
+
+/**
+ * Free a temporal prefetcher.
+ *
+ * @param tp The prefetcher to free.
+ */
+void temporal_free(TemporalPrefetcher *tp)
+{
+    free(tp->ghb);
+    free(tp->ghb_index);
+    free(tp->isb_ps);
+    free(tp->isb_sp);
+    free(tp);
+}
+
+/**
+ * Print the statistics of a temporal prefetcher.
+ *
+ * @param tp The prefetcher.
+ */
+void temporal_print_stats(TemporalPrefetcher *tp)
+{
+    printf("\n");
+    printf("L2PF_TRAINS          \t\t : %10llu\n", tp->stat_trains);
+    printf("L2PF_CANDIDATES      \t\t : %10llu\n", tp->stat_candidates);
+    if (tp->meta_in_dram)
+    {
+        printf("L2PF_META_READS      \t\t : %10llu\n", tp->stat_meta_reads);
+        printf("L2PF_META_WRITES     \t\t : %10llu\n", tp->stat_meta_writes);
+    }
+}
@@ -0,0 +1,176 @@
+// temporal.h
+// Declares the temporal prefetchers of the L2 cache, which replay the misses
+// that followed an address the last time it missed.
+
+#ifndef __TEMPORAL_H__
+#define __TEMPORAL_H__
+
+#include "types.h"
+#include "dram.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The largest number of lines prefetched per training access. */
+#define TEMPORAL_MAX_DEGREE 16
+
+/** The number of entries of each metadata table kept in DRAM. */
+#define TEMPORAL_DRAM_ENTRIES (1 << 20)
+
+/** The size of one metadata table entry, in bytes. */
+#define TEMPORAL_ENTRY_BYTES 8
+
+/** The number of ISB training entries, indexed by the PC. */
+#define ISB_TRAINING_ENTRIES 256
+
+/** The number of structural addresses reserved for each new ISB stream. */
+#define ISB_STREAM_CHUNK 256
+
+/** The largest ISB mapping confidence. */
+#define ISB_CONFIDENCE_MAX 3
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Possible prefetchers of the L2 cache. */
+typedef enum L2PrefetcherEnum
+{
+    L2PF_OFF = 0, // Do not prefetch.
+    L2PF_GHB = 1, // Global history buffer with address correlation (G/AC).
+    L2PF_ISB = 2, // Irregular stream buffer.
+} L2PrefetcherType;
+
+/** One miss in the global history buffer. */
+typedef struct GhbEntry
+{
+    uint64_t line_addr;
+
+    /** The position of the previous miss to the same line, plus one. */
+    uint64_t prev;
+} GhbEntry;
+
+/** The latest position of a line in the global history buffer. */
+typedef struct GhbIndexEntry
+{
+    uint64_t line_addr;
+
+    /** The position, plus one, or 0 if the entry is free. */
+    uint64_t pos;
+} GhbIndexEntry;
+
+/** One mapping between a physical and a structural address. */
+typedef struct IsbMapEntry
+{
+    bool valid;
+    uint64_t key;
+    uint64_t value;
+
+    /** For a physical-to-structural mapping, how often it was confirmed. */
+    uint8_t confidence;
+} IsbMapEntry;
+
+/** The last line missed by the instructions with one PC hash. */
+typedef struct IsbTrainingEntry
+{
+    bool valid;
+    uint64_t line_addr;
+} IsbTrainingEntry;
+
+/** The state of the temporal prefetcher of the L2 cache. */
+typedef struct TemporalPrefetcher
+{
+    L2PrefetcherType type;
+    unsigned int degree;
+
+    /** Whether the metadata is in DRAM, and each lookup is a DRAM access. */
+    bool meta_in_dram;
+    unsigned int entries_per_line;
+
+    /** For GHB, the history of misses, as a ring, and its index by line. */
+    GhbEntry *ghb;
+    uint64_t ghb_mask;
+    uint64_t ghb_head;
+    GhbIndexEntry *ghb_index;
+    uint64_t ghb_index_mask;
+
+    /**
+     * For ISB, the maps from physical to structural addresses and back, in
+     * which lines that miss one after another under the same PC get
+     * consecutive structural addresses.
+     */
+    IsbMapEntry *isb_ps;
+    uint64_t isb_ps_mask;
+    IsbMapEntry *isb_sp;
+    uint64_t isb_sp_mask;
+    IsbTrainingEntry isb_training[ISB_TRAINING_ENTRIES];
+    uint64_t isb_next_stream;
+
+    unsigned long long stat_trains;
+    unsigned long long stat_candidates;
+    unsigned long long stat_meta_reads;
+    unsigned long long stat_meta_writes;
+} TemporalPrefetcher;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate and initialize a temporal prefetcher, with tables sized to fit
+ * L2PF_BUDGET_KB on chip, or TEMPORAL_DRAM_ENTRIES each in DRAM.
+ *
+ * @param type The kind of prefetcher.
+ * @return A pointer to the prefetcher.
+ */
+TemporalPrefetcher *temporal_new(L2PrefetcherType type);
+
+/**
+ * Record an L2 miss (or first hit on a prefetched line), and find the lines
+ * to prefetch. Metadata kept in DRAM is read and written through the DRAM.
+ *
+ * @param tp The prefetcher.
+ * @param dram The DRAM module holding the metadata.
+ * @param line_addr The address of the cache line accessed (in units of the
+ *                  cache line size).
+ * @param pc The address of the instruction that made the access.
+ * @param core_id The CPU core ID that made the access.
+ * @param candidates Receives up to TEMPORAL_MAX_DEGREE line addresses.
+ * @return The number of lines to prefetch.
+ */
+unsigned int temporal_train(TemporalPrefetcher *tp, DRAM *dram,
+                            uint64_t line_addr, uint64_t pc,
+                            unsigned int core_id, uint64_t *candidates);
+
+/**
+ * Reset the statistics of a temporal prefetcher.
+ *
+ * @param tp The prefetcher.
+ */
+void temporal_clear_stats(TemporalPrefetcher *tp);
+
+/**
+ * Add the statistics of one temporal prefetcher to those of another.
+ *
+ * @param dst The prefetcher whose statistics are increased.
+ * @param src The prefetcher whose statistics are added.
+ */
+void temporal_add_stats(TemporalPrefetcher *dst,
+                        const TemporalPrefetcher *src);
+
+/**
+ * Free a temporal prefetcher.
+ *
+ * @param tp The prefetcher to free.
+ */
+void temporal_free(TemporalPrefetcher *tp);
+
+/**
+ * Print the statistics of a temporal prefetcher.
+ *
+ * @param tp The prefetcher.
+ */
+void temporal_print_stats(TemporalPrefetcher *tp);
+
+#endif // __TEMPORAL_H__
@@ -0,0 +1,421 @@
+// tracecache.cpp
+// Defines a decoded trace shared between simulator processes on one host.
+//
+// A trace is decoded once into a POSIX shared memory object named after the
+// trace file's path, inode, size and modification time. A lock file next to
+// it serialises creating and removing the object. Every process that maps
+// the object holds a shared flock() on it, which the kernel drops when the
+// process exits or dies, so the last one to finish can tell that it is the
+// last by taking the lock exclusively, and removes the object.
+
+#include "tracecache.h"
+#include "core.h"
+#include "gzindex.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Marks a completely written segment ("CMPTRC01"). */
+#define TRACECACHE_MAGIC 0x3130435254504d43ULL
+
+/** The directory holding the lock files. */
+#define TRACECACHE_LOCK_DIR "/tmp"
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Whether to decode traces through their access point index. */
+extern bool TRACE_INDEX;
+
+/** The threads that decode a trace through its index, or 0 for one each. */
+extern unsigned int TRACE_THREADS;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+static uint64_t fnv1a(const void *data, size_t size, uint64_t hash)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * Compute a key that changes whenever the trace file does.
+ */
+static int trace_key(const char *trace_filename, uint64_t *key)
+{
+    char path[PATH_MAX];
+    struct stat st;
+    if (realpath(trace_filename, path) == NULL || stat(path, &st) != 0)
+    {
+        perror("Couldn't stat trace file");
+        return 1;
+    }
+
+    uint64_t hash = fnv1a(path, strlen(path), 0xcbf29ce484222325ULL);
+    hash = fnv1a(&st.st_dev, sizeof(st.st_dev), hash);
+    hash = fnv1a(&st.st_ino, sizeof(st.st_ino), hash);
+    hash = fnv1a(&st.st_size, sizeof(st.st_size), hash);
+    hash = fnv1a(&st.st_mtime, sizeof(st.st_mtime), hash);
+    *key = hash;
+    return 0;
+}
+
+/**
+ * The size of a segment holding the given number of records.
+ */
+static size_t segment_size(uint64_t num_records)
+{
+    return sizeof(TraceCacheHeader) + num_records * sizeof(TraceRecord);
+}
+
+/**
+ * Resize a segment being written to the given number of bytes and map it
+ * read-write, replacing the mapping of its old size, if any.
+ */
+static TraceCacheHeader *resize_segment(int shm_fd, TraceCacheHeader *hdr,
+                                        size_t old_size, size_t size)
+{
+    if (hdr != NULL)
+    {
+        munmap(hdr, old_size);
+    }
+    if (ftruncate(shm_fd, size) != 0)
+    {
+        perror("Couldn't resize shared trace");
+        return NULL;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd,
+                     0);
+    if (map == MAP_FAILED)
+    {
+        perror("Couldn't map shared trace");
+        return NULL;
+    }
+    return (TraceCacheHeader *)map;
+}
+
+/**
+ * Decode a whole trace file into a segment, decoding segments between access
+ * points of its index in parallel. The raw trace is decoded into the end of
+ * the segment and widened into records from the front, each record written
+ * only over raw bytes already read.
+ */
+static TraceCacheHeader *decode_trace_indexed(const char *trace_filename,
+                                              int shm_fd)
+{
+    GzIndex *idx = gzindex_open(trace_filename);
+    if (idx == NULL)
+    {
+        return NULL;
+    }
+
+    uint64_t n = idx->total_out / TRACE_RECORD_BYTES;
+    size_t raw_off = sizeof(TraceCacheHeader) +
+                     n * (sizeof(TraceRecord) - TRACE_RECORD_BYTES);
+    size_t size = raw_off + idx->total_out;
+    TraceCacheHeader *hdr = resize_segment(shm_fd, NULL, 0, size);
+    if (hdr == NULL)
+    {
+        gzindex_free(idx);
+        return NULL;
+    }
+
+    uint8_t *raw = (uint8_t *)hdr + raw_off;
+    if (gzindex_decode(idx, trace_filename, raw, TRACE_THREADS) != 0)
+    {
+        munmap(hdr, size);
+        gzindex_free(idx);
+        return NULL;
+    }
+    gzindex_free(idx);
+
+    TraceRecord *records = (TraceRecord *)(hdr + 1);
+    for (uint64_t i = 0; i < n; i++)
+    {
+        const uint8_t *rec = raw + i * TRACE_RECORD_BYTES;
+        TraceRecord r;
+        memcpy(&r.inst_addr, rec, 4);
+        r.inst_type = rec[4];
+        memcpy(&r.ldst_addr, rec + 5, 4);
+        records[i] = r;
+    }
+
+    // Drop the bytes of a partial last record.
+    hdr = resize_segment(shm_fd, hdr, size, segment_size(n));
+    if (hdr != NULL)
+    {
+        hdr->num_records = n;
+    }
+    return hdr;
+}
+
+/**
+ * Decode a whole trace file into a segment, growing it as records arrive.
+ * Returns the segment mapped read-write and sized to its records, or NULL.
+ */
+static TraceCacheHeader *decode_trace(const char *trace_filename, int shm_fd)
+{
+    if (TRACE_INDEX)
+    {
+        return decode_trace_indexed(trace_filename, shm_fd);
+    }
+
+    int fd;
+    pid_t pid;
+    if (open_gunzip_pipe(trace_filename, &fd, &pid) != 0)
+    {
+        return NULL;
+    }
+
+    uint64_t capacity = 1 << 20;
+    uint64_t n = 0;
+    TraceCacheHeader *hdr = resize_segment(shm_fd, NULL, 0,
+                                           segment_size(capacity));
+    uint8_t buf[64 * 1024];
+    size_t have = 0;
+
+    while (hdr != NULL)
+    {
+        ssize_t got = read(fd, buf + have, sizeof(buf) - have);
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got < 0)
+        {
+            perror("Couldn't read from trace file");
+            munmap(hdr, segment_size(capacity));
+            hdr = NULL;
+            break;
+        }
+        if (got == 0)
+        {
+            break;
+        }
+        have += got;
+
+        size_t off = 0;
+        for (; hdr != NULL && have - off >= TRACE_RECORD_BYTES;
+             off += TRACE_RECORD_BYTES)
+        {
+            if (n == capacity)
+            {
+                capacity *= 2;
+                hdr = resize_segment(shm_fd, hdr, segment_size(n),
+                                     segment_size(capacity));
+                if (hdr == NULL)
+                {
+                    break;
+                }
+            }
+            TraceRecord *rec = (TraceRecord *)(hdr + 1) + n;
+            memcpy(&rec->inst_addr, buf + off, 4);
+            rec->inst_type = buf[off + 4];
+            memcpy(&rec->ldst_addr, buf + off + 5, 4);
+            n++;
+        }
+        memmove(buf, buf + off, have - off);
+        have -= off;
+    }
+
+    close(fd);
+    waitpid(pid, NULL, 0);
+    if (hdr == NULL)
+    {
+        return NULL;
+    }
+
+    // Give back the room the last doubling left over.
+    hdr = resize_segment(shm_fd, hdr, segment_size(capacity),
+                         segment_size(n));
+    if (hdr != NULL)
+    {
+        hdr->num_records = n;
+    }
+    return hdr;
+}
+
+/**
+ * Map an existing segment read-only and check that it is complete.
+ */
+static bool map_segment(TraceCache *tc, int shm_fd)
+{
+    struct stat st;
+    if (fstat(shm_fd, &st) != 0 ||
+        (size_t)st.st_size < sizeof(TraceCacheHeader))
+    {
+        return false;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, shm_fd, 0);
+    if (map == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const TraceCacheHeader *hdr = (const TraceCacheHeader *)map;
+    if (hdr->magic != TRACECACHE_MAGIC ||
+        (size_t)st.st_size != segment_size(hdr->num_records))
+    {
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    tc->map = map;
+    tc->map_size = st.st_size;
+    tc->num_records = hdr->num_records;
+    tc->records = (const TraceRecord *)(hdr + 1);
+    return true;
+}
+
+/**
+ * Decode the trace straight into a new segment, then map it read-only. On
+ * failure the segment is removed.
+ *
+ * @return A descriptor of the segment, or -1 on failure.
+ */
+static int create_segment(TraceCache *tc, const char *trace_filename)
+{
+    int shm_fd = shm_open(tc->shm_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (shm_fd < 0)
+    {
+        perror("Couldn't create shared trace");
+        return -1;
+    }
+
+    bool ok = false;
+    TraceCacheHeader *hdr = decode_trace(trace_filename, shm_fd);
+    if (hdr != NULL)
+    {
+        hdr->magic = TRACECACHE_MAGIC;
+        munmap(hdr, segment_size(hdr->num_records));
+        ok = map_segment(tc, shm_fd);
+    }
+
+    if (!ok)
+    {
+        close(shm_fd);
+        shm_unlink(tc->shm_name);
+        return -1;
+    }
+    return shm_fd;
+}
+
+/**
+ * Map the decoded records of the given trace file.
+ *
+ * The first process to ask for a trace decodes it into a shared memory
+ * segment; later processes on the same host map that segment read-only.
+ *
+ * @param trace_filename The gzip-compressed trace file.
+ * @return The mapped trace, or NULL on error.
+ */
+TraceCache *tracecache_open(const char *trace_filename)
+{
+    uint64_t key;
+    if (trace_key(trace_filename, &key) != 0)
+    {
+        return NULL;
+    }
+
+    TraceCache *tc = (TraceCache *)calloc(1, sizeof(TraceCache));
+    snprintf(tc->shm_name, sizeof(tc->shm_name), "/cmpsim-trace-%016llx",
+             (unsigned long long)key);
+    snprintf(tc->lock_path, sizeof(tc->lock_path),
+             TRACECACHE_LOCK_DIR "/cmpsim-trace-%016llx.lock",
+             (unsigned long long)key);
+
+    int lock_fd = open(tc->lock_path, O_RDWR | O_CREAT, 0666);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX) != 0)
+    {
+        perror("Couldn't lock shared trace");
+        if (lock_fd >= 0)
+        {
+            close(lock_fd);
+        }
+        free(tc);
+        return NULL;
+    }
+
+    int shm_fd = shm_open(tc->shm_name, O_RDONLY, 0);
+    if (shm_fd >= 0 && !map_segment(tc, shm_fd))
+    {
+        close(shm_fd);
+        shm_fd = -1;
+    }
+
+    if (shm_fd < 0)
+    {
+        // Either nobody has decoded this trace yet, or a process died while
+        // decoding it.
+        shm_unlink(tc->shm_name);
+        shm_fd = create_segment(tc, trace_filename);
+    }
+
+    // Mark the segment as in use before another process may remove it.
+    if (shm_fd >= 0 && flock(shm_fd, LOCK_SH) != 0)
+    {
+        perror("Couldn't lock shared trace");
+        munmap(tc->map, tc->map_size);
+        close(shm_fd);
+        shm_fd = -1;
+    }
+
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+
+    if (shm_fd < 0)
+    {
+        free(tc);
+        return NULL;
+    }
+    tc->shm_fd = shm_fd;
+    return tc;
+}
+
+/**
+ * Unmap a decoded trace. The last process to unmap it removes the segment.
+ *
+ * @param tc The mapped trace.
+ */
+void tracecache_close(TraceCache *tc)
+{
+    // The shared lock becomes exclusive only if no other process, alive,
+    // holds one.
+    int lock_fd = open(tc->lock_path, O_RDWR);
+    if (lock_fd >= 0 && flock(lock_fd, LOCK_EX) == 0)
+    {
+        if (flock(tc->shm_fd, LOCK_EX | LOCK_NB) == 0)
+        {
+            shm_unlink(tc->shm_name);
+        }
+        flock(lock_fd, LOCK_UN);
+    }
+    if (lock_fd >= 0)
+    {
+        close(lock_fd);
+    }
+
+    close(tc->shm_fd);
+    munmap(tc->map, tc->map_size);
+    free(tc);
+}
@@ -0,0 +1,75 @@
+// tracecache.h
+// Declares a decoded trace shared between simulator processes on one host.
+
+#ifndef __TRACECACHE_H__
+#define __TRACECACHE_H__
+
+#include "types.h"
+#include <stddef.h>
+#include <limits.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The size of one record in a trace file, in bytes. */
+#define TRACE_RECORD_BYTES 9
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The header at the start of a shared trace segment, followed by the
+ * records.
+ */
+typedef struct TraceCacheHeader
+{
+    /** TRACECACHE_MAGIC once the segment is completely written. */
+    uint64_t magic;
+    uint64_t num_records;
+} TraceCacheHeader;
+
+/** A read-only mapping of a decoded trace. */
+typedef struct TraceCache
+{
+    const TraceRecord *records;
+    uint64_t num_records;
+
+    void *map;
+    size_t map_size;
+
+    /**
+     * The name of the POSIX shared memory object holding the trace, and a
+     * descriptor on which every process that maps it holds a shared lock.
+     */
+    char shm_name[64];
+    int shm_fd;
+
+    /** The lock file that serialises creating and removing the object. */
+    char lock_path[PATH_MAX];
+} TraceCache;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Map the decoded records of the given trace file.
+ *
+ * The first process to ask for a trace decodes it into a shared memory
+ * segment; later processes on the same host map that segment read-only.
+ *
+ * @param trace_filename The gzip-compressed trace file.
+ * @return The mapped trace, or NULL on error.
+ */
+TraceCache *tracecache_open(const char *trace_filename);
+
+/**
+ * Unmap a decoded trace. The last process to unmap it removes the segment.
+ *
+ * @param tc The mapped trace.
+ */
+void tracecache_close(TraceCache *tc);
+
+#endif // __TRACECACHE_H__
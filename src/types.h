@@ -32,4 +32,12 @@ typedef enum ModeEnum
     SIM_MODE_DEF = 4,   // Simulate a multicore system (in parts D, E, and F).
 } Mode;
 
+/** One decoded instruction of a trace. */
+typedef struct TraceRecord
+{
+    uint32_t inst_addr;
+    uint32_t ldst_addr;
+    uint8_t inst_type;
+} TraceRecord;
+
 #endif // __TYPES_H__
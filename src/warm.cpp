@@ -0,0 +1,172 @@
+// warm.cpp
+// Defines the skipping of a trace prefix and the warming of the caches
+// before the detailed simulation starts.
+
+#include "warm.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//                    EXTERNALLY DEFINED GLOBAL VARIABLES                    //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The current clock cycle number. */
+extern thread_local uint64_t current_cycle;
+
+/** The number of instructions to skip before the detailed simulation. */
+extern uint64_t SKIP_INSTS;
+
+/** The number of skipped instructions used to warm the caches. */
+extern uint64_t WARM_INSTS;
+
+/** How the caches are warmed. */
+extern WarmMethod WARM_METHOD;
+
+///////////////////////////////////////////////////////////////////////////////
+//                              GLOBAL VARIABLES                             //
+///////////////////////////////////////////////////////////////////////////////
+
+static unsigned long long stat_skipped_insts;
+static unsigned long long stat_warm_insts;
+static unsigned long long stat_scanned_insts;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+static AccessType data_access_type(const TraceRecord *rec)
+{
+    return (rec->inst_type == INST_TYPE_LOAD) ? ACCESS_TYPE_LOAD
+                                              : ACCESS_TYPE_STORE;
+}
+
+static bool is_mem_op(const TraceRecord *rec)
+{
+    return rec->inst_type == INST_TYPE_LOAD ||
+           rec->inst_type == INST_TYPE_STORE;
+}
+
+/**
+ * Run the window forward through the memory system, one cycle per
+ * instruction, then restart the clock, in the DRAM too.
+ */
+static uint64_t warm_functional(MemorySystem *sys, unsigned int core_id,
+                                const TraceRecord *window, uint64_t n)
+{
+    for (uint64_t i = 0; i < n; i++)
+    {
+        current_cycle = i + 1;
+        memsys_access(sys, window[i].inst_addr, ACCESS_TYPE_IFETCH,
+                      core_id, window[i].inst_addr);
+        if (is_mem_op(&window[i]))
+        {
+            memsys_access(sys, window[i].ldst_addr,
+                          data_access_type(&window[i]), core_id,
+                          window[i].inst_addr);
+        }
+    }
+    current_cycle = 0;
+    memsys_normalize_lru(sys);
+    memsys_reset_clock(sys);
+    return n;
+}
+
+/**
+ * Scan the window backwards, placing each line the first time it is seen, so
+ * that each set ends up holding its most recently used lines in LRU order.
+ * Stops as soon as every set is full.
+ */
+static uint64_t warm_reverse(MemorySystem *sys, unsigned int core_id,
+                             const TraceRecord *window, uint64_t n)
+{
+    uint64_t i = n;
+    bool full = false;
+    while (i > 0 && !full)
+    {
+        i--;
+
+        // The data access follows the fetch, so it is the more recent one.
+        if (is_mem_op(&window[i]))
+        {
+            full = memsys_reverse_fill(sys, window[i].ldst_addr,
+                                       data_access_type(&window[i]),
+                                       core_id);
+        }
+        full = memsys_reverse_fill(sys, window[i].inst_addr,
+                                   ACCESS_TYPE_IFETCH, core_id);
+    }
+    return n - i;
+}
+
+/**
+ * Warm the empty caches of a memory system with a window of instructions,
+ * using WARM_METHOD.
+ *
+ * @param sys The memory system to warm.
+ * @param core_id The CPU core ID that executed the window.
+ * @param window The instructions, oldest first.
+ * @param n The number of instructions in the window.
+ * @return The number of instructions of the window that were used.
+ */
+uint64_t warm_caches(MemorySystem *sys, unsigned int core_id,
+                     const TraceRecord *window, uint64_t n)
+{
+    if (WARM_METHOD == WARM_FUNCTIONAL)
+    {
+        return warm_functional(sys, core_id, window, n);
+    }
+    if (WARM_METHOD == WARM_REVERSE)
+    {
+        return warm_reverse(sys, core_id, window, n);
+    }
+    return 0;
+}
+
+/**
+ * Skip the first SKIP_INSTS instructions of the core's trace, warming the
+ * caches with the last WARM_INSTS of them using WARM_METHOD, and clear the
+ * statistics so that only the detailed region is reported.
+ *
+ * @param sys The memory system to warm.
+ * @param core The (only) core, whose trace is advanced.
+ */
+void warm_run(MemorySystem *sys, Core *core)
+{
+    uint64_t warm_insts = (WARM_METHOD == WARM_NONE) ? 0 : WARM_INSTS;
+    if (warm_insts > SKIP_INSTS)
+    {
+        warm_insts = SKIP_INSTS;
+    }
+
+    // The core already holds the first instruction.
+    uint64_t skipped = core_skip_trace(core, SKIP_INSTS - warm_insts);
+
+    TraceRecord *window =
+        (TraceRecord *)malloc(warm_insts * sizeof(TraceRecord) + 1);
+    uint64_t n = 0;
+    for (; n < warm_insts && !core->done; n++)
+    {
+        window[n].inst_addr = core->trace_inst_addr;
+        window[n].inst_type = core->trace_inst_type;
+        window[n].ldst_addr = core->trace_ldst_addr;
+        core_read_trace(core);
+    }
+
+    stat_scanned_insts = warm_caches(sys, core->core_id, window, n);
+    free(window);
+
+    memsys_clear_stats(sys);
+    stat_skipped_insts = skipped + n;
+    stat_warm_insts = n;
+}
+
+/**
+ * Print the statistics of the skipping and warming.
+ */
+void warm_print_stats()
+{
+    printf("\n");
+    printf("WARM_SKIPPED_INSTS  \t\t : %10llu\n", stat_skipped_insts);
+    printf("WARM_WINDOW_INSTS   \t\t : %10llu\n", stat_warm_insts);
+    printf("WARM_SCANNED_INSTS  \t\t : %10llu\n", stat_scanned_insts);
+}
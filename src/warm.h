@@ -0,0 +1,56 @@
+// warm.h
+// Declares the skipping of a trace prefix and the warming of the caches
+// before the detailed simulation starts.
+
+#ifndef __WARM_H__
+#define __WARM_H__
+
+#include "types.h"
+#include "memsys.h"
+#include "core.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** Possible ways to warm the caches before the detailed simulation. */
+typedef enum WarmMethodEnum
+{
+    WARM_NONE = 0,       // Start the detailed simulation with empty caches.
+    WARM_FUNCTIONAL = 1, // Run the warmup window through the caches.
+    WARM_REVERSE = 2,    // Fill the caches from the window scanned backwards.
+} WarmMethod;
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Warm the empty caches of a memory system with a window of instructions,
+ * using WARM_METHOD.
+ *
+ * @param sys The memory system to warm.
+ * @param core_id The CPU core ID that executed the window.
+ * @param window The instructions, oldest first.
+ * @param n The number of instructions in the window.
+ * @return The number of instructions of the window that were used.
+ */
+uint64_t warm_caches(MemorySystem *sys, unsigned int core_id,
+                     const TraceRecord *window, uint64_t n);
+
+/**
+ * Skip the first SKIP_INSTS instructions of the core's trace, warming the
+ * caches with the last WARM_INSTS of them using WARM_METHOD, and clear the
+ * statistics so that only the detailed region is reported.
+ *
+ * @param sys The memory system to warm.
+ * @param core The (only) core, whose trace is advanced.
+ */
+void warm_run(MemorySystem *sys, Core *core);
+
+/**
+ * Print the statistics of the skipping and warming.
+ */
+void warm_print_stats();
+
+#endif // __WARM_H__
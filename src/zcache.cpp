@@ -0,0 +1,210 @@
+// zcache.cpp
+// Defines the zcache organisation: ways indexed by different hash functions,
+// with a replacement walk over the alternative positions of the lines.
+//
+// A zcache reuses the storage of a Cache: the line at position i of way w is
+// cacheGrid[i].row[w]. Since each way has its own index function, lines keep
+// their whole line address as the tag.
+
+#include "zcache.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** An odd multiplier per way for the index hash functions. */
+static const uint64_t ZCACHE_HASH_MULT[MAX_WAYS_PER_CACHE_SET] = {
+    0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL, 0x94d049bb133111ebULL,
+    0xd6e8feb86659fd93ULL, 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL, 0x1d8e4e27c47d124fULL,
+    0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL, 0x85ebca77c2b2ae63ULL,
+    0x27d4eb2f165667c5ULL, 0xff51afd7ed558ccdULL, 0xc4ceb9fe1a85ec53ULL,
+    0x9fb21c651e98df25ULL,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//                              DATA STRUCTURES                              //
+///////////////////////////////////////////////////////////////////////////////
+
+/** A position examined by the replacement walk. */
+typedef struct ZCandidate
+{
+    unsigned way;
+    unsigned index;
+
+    /** The candidate whose line would move here, or -1 at the first level. */
+    int parent;
+} ZCandidate;
+
+///////////////////////////////////////////////////////////////////////////////
+//                           FUNCTION DEFINITIONS                            //
+///////////////////////////////////////////////////////////////////////////////
+
+static unsigned zcache_index(const Cache *c, unsigned way, uint64_t line_addr)
+{
+    uint64_t h = line_addr * ZCACHE_HASH_MULT[way];
+    return (unsigned)((h ^ (h >> 29)) >> 16) & c->index_mask;
+}
+
+static CacheLine *zcache_line(Cache *c, const ZCandidate *cand)
+{
+    return &c->cacheGrid[cand->index].row[cand->way];
+}
+
+/**
+ * Access a zcache at the given address. Behaves like cache_access().
+ *
+ * @param c The cache to access, with zcache_levels set.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param is_write Whether this access is a write.
+ * @param core_id The CPU core ID that requested this access.
+ * @return Whether the cache access was a hit or a miss.
+ */
+CacheResult zcache_access(Cache *c, uint64_t line_addr, bool is_write,
+                          unsigned int core_id)
+{
+    if (is_write)
+        c->stat_write_access++;
+    else
+        c->stat_read_access++;
+
+    for (unsigned w = 0; w < c->ways; w++)
+    {
+        CacheLine *line = &c->cacheGrid[zcache_index(c, w, line_addr)].row[w];
+        if (line->valid && line->coreID == core_id && line->tag == line_addr)
+        {
+            line->dirty = line->dirty || is_write;
+            line->lastAccessTime = *c->clock;
+            return HIT;
+        }
+    }
+
+    if (is_write)
+        c->stat_write_miss++;
+    else
+        c->stat_read_miss++;
+    return MISS;
+}
+
+/**
+ * Add a candidate unless its position is already in the walk, which would
+ * make a relocation path visit it twice.
+ */
+static bool zcache_add_candidate(ZCandidate *cands, unsigned *n, unsigned way,
+                                 unsigned index, int parent)
+{
+    for (unsigned i = 0; i < *n; i++)
+    {
+        if (cands[i].way == way && cands[i].index == index)
+        {
+            return false;
+        }
+    }
+    cands[*n].way = way;
+    cands[*n].index = index;
+    cands[*n].parent = parent;
+    (*n)++;
+    return true;
+}
+
+/**
+ * Install a line into a zcache. Behaves like cache_install().
+ *
+ * The candidates are the positions of the new line in each way, then the
+ * other positions of the lines found there, and so on for zcache_levels
+ * levels. The least recently used candidate (or a random one) is evicted, and
+ * the lines on the path from the new line's position to it each move one step
+ * down, freeing a position for the new line.
+ *
+ * @param c The cache to install the line into, with zcache_levels set.
+ * @param line_addr The address of the cache line to install (in units of the
+ *                  cache line size).
+ * @param is_write Whether this install is triggered by a write.
+ * @param core_id The CPU core ID that requested this access.
+ */
+void zcache_install(Cache *c, uint64_t line_addr, bool is_write,
+                    unsigned int core_id)
+{
+    ZCandidate cands[ZCACHE_MAX_CANDIDATES];
+    unsigned n = 0;
+    int victim = -1;
+
+    for (unsigned w = 0; w < c->ways; w++)
+    {
+        zcache_add_candidate(cands, &n, w, zcache_index(c, w, line_addr), -1);
+    }
+
+    // Walk the candidate tree breadth first, stopping at a free position.
+    unsigned level_begin = 0;
+    for (unsigned level = 0; level < c->zcache_levels && victim < 0; level++)
+    {
+        unsigned level_end = n;
+        for (unsigned i = level_begin; i < level_end && victim < 0; i++)
+        {
+            CacheLine *line = zcache_line(c, &cands[i]);
+            if (!line->valid)
+            {
+                victim = (int)i;
+                break;
+            }
+            if (level + 1 == c->zcache_levels)
+            {
+                continue;
+            }
+            for (unsigned w = 0; w < c->ways && n < ZCACHE_MAX_CANDIDATES; w++)
+            {
+                if (w != cands[i].way)
+                {
+                    zcache_add_candidate(cands, &n, w,
+                                         zcache_index(c, w, line->tag),
+                                         (int)i);
+                }
+            }
+        }
+        level_begin = level_end;
+    }
+
+    if (victim < 0)
+    {
+        if (c->policy == RANDOM)
+        {
+            victim = cache_random() % n;
+        }
+        else
+        {
+            victim = 0;
+            for (unsigned i = 1; i < n; i++)
+            {
+                if (zcache_line(c, &cands[i])->lastAccessTime <
+                    zcache_line(c, &cands[victim])->lastAccessTime)
+                {
+                    victim = (int)i;
+                }
+            }
+        }
+    }
+
+    CacheLine *slot = zcache_line(c, &cands[victim]);
+    c->lastEvictedLine = *slot;
+    if (slot->valid && slot->dirty)
+    {
+        c->stat_dirty_evicts++;
+    }
+
+    // Move each line on the path one step toward the victim's position.
+    int i = victim;
+    while (cands[i].parent >= 0)
+    {
+        *zcache_line(c, &cands[i]) = *zcache_line(c, &cands[cands[i].parent]);
+        c->stat_relocations++;
+        i = cands[i].parent;
+    }
+
+    slot = zcache_line(c, &cands[i]);
+    slot->valid = true;
+    slot->dirty = is_write;
+    slot->tag = line_addr;
+    slot->coreID = core_id;
+    slot->lastAccessTime = *c->clock;
+}
@@ -0,0 +1,53 @@
+// zcache.h
+// Declares the zcache organisation: ways indexed by different hash functions,
+// with a replacement walk over the alternative positions of the lines.
+
+#ifndef __ZCACHE_H__
+#define __ZCACHE_H__
+
+#include "types.h"
+#include "cache.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//                                 CONSTANTS                                 //
+///////////////////////////////////////////////////////////////////////////////
+
+/** The largest number of replacement candidates examined on a miss. */
+#define ZCACHE_MAX_CANDIDATES 64
+
+///////////////////////////////////////////////////////////////////////////////
+//                            FUNCTION PROTOTYPES                            //
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Access a zcache at the given address. Behaves like cache_access().
+ *
+ * @param c The cache to access, with zcache_levels set.
+ * @param line_addr The address of the cache line to access (in units of the
+ *                  cache line size).
+ * @param is_write Whether this access is a write.
+ * @param core_id The CPU core ID that requested this access.
+ * @return Whether the cache access was a hit or a miss.
+ */
+CacheResult zcache_access(Cache *c, uint64_t line_addr, bool is_write,
+                          unsigned int core_id);
+
+/**
+ * Install a line into a zcache. Behaves like cache_install().
+ *
+ * The candidates are the positions of the new line in each way, then the
+ * other positions of the lines found there, and so on for zcache_levels
+ * levels. The least recently used candidate (or a random one) is evicted, and
+ * the lines on the path from the new line's position to it each move one step
+ * down, freeing a position for the new line.
+ *
+ * @param c The cache to install the line into, with zcache_levels set.
+ * @param line_addr The address of the cache line to install (in units of the
+ *                  cache line size).
+ * @param is_write Whether this install is triggered by a write.
+ * @param core_id The CPU core ID that requested this access.
+ */
+void zcache_install(Cache *c, uint64_t line_addr, bool is_write,
+                    unsigned int core_id);
+
+#endif // __ZCACHE_H__